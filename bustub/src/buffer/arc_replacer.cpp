@@ -0,0 +1,183 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+namespace bustub {
+
+ArcReplacer::ArcReplacer(size_t num_frames) : nodes_(num_frames), num_frames_(num_frames) {}
+
+bool ArcReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock{latch_};
+  std::set<FrameKey> *frames = &t2_frames_;
+  if (!t1_frames_.empty() && (t1_size_ > p_ || t2_frames_.empty())) {
+    frames = &t1_frames_;
+  }
+  if (frames->empty()) {
+    return false;
+  }
+  *frame_id = frames->begin()->second;
+  const FrameNode &node = nodes_[*frame_id];
+  (node.queue_ == Queue::T1 ? b1_ : b2_).PushFront(node.page_id_);
+  Untrack(*frame_id);
+  return true;
+}
+
+void ArcReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  FrameNode &node = nodes_[frame_id];
+  if (node.queue_ == Queue::NONE || !node.is_evictable_) {
+    return;
+  }
+  EvictableSet(node.queue_)->erase({node.seq_, frame_id});
+  node.is_evictable_ = false;
+}
+
+void ArcReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  FrameNode &node = nodes_[frame_id];
+  if (node.queue_ == Queue::NONE || node.is_evictable_) {
+    return;
+  }
+  EvictableSet(node.queue_)->emplace(node.seq_, frame_id);
+  node.is_evictable_ = true;
+}
+
+void ArcReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  FrameNode &node = nodes_[frame_id];
+  if (node.queue_ == Queue::NONE) {
+    // A hit on a frame that was handed out as a victim but kept its page.
+    Track(frame_id, Queue::T1, false);
+    return;
+  }
+  if (access_type == AccessType::Scan) {
+    return;
+  }
+  const bool is_evictable = node.is_evictable_;
+  Untrack(frame_id);
+  Track(frame_id, Queue::T2, is_evictable);
+}
+
+void ArcReplacer::RecordLoad(frame_id_t frame_id, page_id_t page_id, AccessType access_type) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  if (nodes_[frame_id].queue_ != Queue::NONE) {
+    Untrack(frame_id);
+  }
+  nodes_[frame_id].page_id_ = page_id;
+  const size_t b1_size = b1_.Size();
+  const size_t b2_size = b2_.Size();
+  if (b1_.Erase(page_id)) {
+    // Evicted from T1 too early: grow T1.
+    p_ = std::min(num_frames_, p_ + std::max<size_t>(b2_size / b1_size, 1));
+    Track(frame_id, access_type == AccessType::Scan ? Queue::T1 : Queue::T2, false);
+    return;
+  }
+  if (b2_.Erase(page_id)) {
+    // Evicted from T2 too early: shrink T1.
+    p_ -= std::min(p_, std::max<size_t>(b1_size / b2_size, 1));
+    Track(frame_id, access_type == AccessType::Scan ? Queue::T1 : Queue::T2, false);
+    return;
+  }
+  Track(frame_id, Queue::T1, false);
+  // The directory holds at most num_frames_ pages seen once and 2 * num_frames_ pages in total.
+  while (t1_size_ + b1_.Size() > num_frames_ && b1_.Size() > 0) {
+    b1_.PopBack();
+  }
+  while (t1_size_ + t2_size_ + b1_.Size() + b2_.Size() > 2 * num_frames_) {
+    if (b2_.Size() > 0) {
+      b2_.PopBack();
+    } else if (b1_.Size() > 0) {
+      b1_.PopBack();
+    } else {
+      break;
+    }
+  }
+}
+
+void ArcReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  if (nodes_[frame_id].queue_ != Queue::NONE) {
+    Untrack(frame_id);
+  }
+  nodes_[frame_id].page_id_ = INVALID_PAGE_ID;
+}
+
+void ArcReplacer::SetNumFrames(size_t num_frames) {
+  std::scoped_lock lock{latch_};
+  if (num_frames <= num_frames_) {
+    return;
+  }
+  nodes_.resize(num_frames);
+  num_frames_ = num_frames;
+}
+
+std::vector<frame_id_t> ArcReplacer::GetRetentionOrder() {
+  std::scoped_lock lock{latch_};
+  // T2 before T1, the most recently promoted first within each.
+  std::vector<std::tuple<bool, size_t, frame_id_t>> keys;
+  for (size_t i = 0; i < num_frames_; ++i) {
+    const FrameNode &node = nodes_[i];
+    if (node.queue_ != Queue::NONE) {
+      keys.emplace_back(node.queue_ == Queue::T2, node.seq_, static_cast<frame_id_t>(i));
+    }
+  }
+  std::sort(keys.begin(), keys.end(), std::greater<>());
+  std::vector<frame_id_t> frame_ids;
+  frame_ids.reserve(keys.size());
+  for (const auto &key : keys) {
+    frame_ids.push_back(std::get<2>(key));
+  }
+  return frame_ids;
+}
+
+size_t ArcReplacer::Size() {
+  std::scoped_lock lock{latch_};
+  return t1_frames_.size() + t2_frames_.size();
+}
+
+size_t ArcReplacer::GetTarget() {
+  std::scoped_lock lock{latch_};
+  return p_;
+}
+
+void ArcReplacer::Track(frame_id_t frame_id, Queue queue, bool is_evictable) {
+  FrameNode &node = nodes_[frame_id];
+  node.queue_ = queue;
+  node.seq_ = next_seq_++;
+  node.is_evictable_ = is_evictable;
+  if (is_evictable) {
+    EvictableSet(queue)->emplace(node.seq_, frame_id);
+  }
+  (queue == Queue::T1 ? t1_size_ : t2_size_)++;
+}
+
+void ArcReplacer::Untrack(frame_id_t frame_id) {
+  FrameNode &node = nodes_[frame_id];
+  if (node.is_evictable_) {
+    EvictableSet(node.queue_)->erase({node.seq_, frame_id});
+  }
+  (node.queue_ == Queue::T1 ? t1_size_ : t2_size_)--;
+  node.queue_ = Queue::NONE;
+  node.is_evictable_ = false;
+}
+
+}  // namespace bustub
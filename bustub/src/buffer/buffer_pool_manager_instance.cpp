@@ -12,202 +12,910 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerPolicy replacer_policy,
+                                                     size_t replacer_k, bool huge_pages)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_policy, replacer_k, huge_pages) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size),
-      num_instances_(num_instances),
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerPolicy replacer_policy, size_t replacer_k,
+                                                     bool huge_pages)
+    : num_instances_(num_instances),
       instance_index_(instance_index),
       next_page_id_(static_cast<page_id_t>(instance_index)),
+      frame_arena_(huge_pages),
       disk_manager_(disk_manager),
-      log_manager_(log_manager) {
+      log_manager_(log_manager),
+      shards_(NUM_PAGE_TABLE_SHARDS),
+      replacer_(MakeReplacer(replacer_policy, pool_size, replacer_k)) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // Pages already in the file are not handed out again, start after the last one that belongs to this instance.
+  if (disk_manager_ != nullptr) {
+    const auto file_pages = static_cast<page_id_t>(disk_manager_->GetDbFileSize() / PAGE_SIZE);
+    while (next_page_id_ < file_pages) {
+      next_page_id_ += static_cast<page_id_t>(num_instances_);
+    }
+  }
 
   // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
-  }
+  AddFrames(pool_size);
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
-  delete replacer_;
+  read_ahead_.Stop();
+  StopPageCleaner();
+}
+
+bool BufferPoolManagerInstance::Resize(size_t pool_size, std::chrono::milliseconds timeout) {
+  BUSTUB_ASSERT(pool_size > 0, "A buffer pool needs at least one frame");
+  std::scoped_lock resize_lock{resize_latch_};
+  std::unique_lock<MeasuredMutex> lock(latch_);
+  if (pool_size >= pool_size_) {
+    AddFrames(pool_size);
+    return true;
+  }
+  return RemoveFrames(&lock, pool_size, std::chrono::steady_clock::now() + timeout);
+}
+
+void BufferPoolManagerInstance::AddFrames(size_t pool_size) {
+  const size_t num_chunks = (pool_size + FRAME_CHUNK_SIZE - 1) / FRAME_CHUNK_SIZE;
+  if (num_chunks > chunk_table_capacity_) {
+    // Other threads may be reading the current table, so it is replaced by a copy instead of being grown in place.
+    const size_t capacity = std::max(num_chunks, 2 * chunk_table_capacity_);
+    auto table = std::make_unique<FrameChunk *[]>(capacity);
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      table[i] = chunks_[i].get();
+    }
+    chunk_table_.store(table.get(), std::memory_order_release);
+    chunk_tables_.push_back(std::move(table));
+    chunk_table_capacity_ = capacity;
+  }
+  // Nobody reads the entries of chunks outside the pool, so they can be filled in place.
+  FrameChunk **table = chunk_table_.load(std::memory_order_relaxed);
+  if (num_chunks > chunks_.size()) {
+    // The data of all new chunks is one segment of the arena, so that it can go on as few huge pages as possible.
+    char *data = frame_arena_.Allocate((num_chunks - chunks_.size()) * FRAME_CHUNK_SIZE);
+    for (size_t i = chunks_.size(); i < num_chunks; ++i, data += FRAME_CHUNK_SIZE * PAGE_SIZE) {
+      chunks_.push_back(std::make_unique<FrameChunk>());
+      chunks_[i]->data_ = data;
+      table[i] = chunks_[i].get();
+    }
+  }
+  for (size_t i = (pool_size_ + FRAME_CHUNK_SIZE - 1) / FRAME_CHUNK_SIZE; i < num_chunks; ++i) {
+    chunks_[i]->pages_ = std::make_unique<Page[]>(FRAME_CHUNK_SIZE);
+    for (size_t j = 0; j < FRAME_CHUNK_SIZE; ++j) {
+      chunks_[i]->pages_[j].data_ = chunks_[i]->data_ + j * PAGE_SIZE;
+    }
+  }
+
+  replacer_->SetNumFrames(pool_size);
+  for (size_t i = pool_size_; i < pool_size; ++i) {
+    free_list_.emplace_back(static_cast<frame_id_t>(i));
+    num_free_frames_++;
+  }
+  pool_size_ = pool_size;
+  frame_limit_ = pool_size;
 }
 
+bool BufferPoolManagerInstance::RemoveFrames(std::unique_lock<MeasuredMutex> *lock, size_t pool_size,
+                                             std::chrono::steady_clock::time_point deadline) {
+  const size_t old_pool_size = pool_size_;
+  frame_limit_ = pool_size;
+  const size_t num_free_frames = free_list_.size();
+  free_list_.remove_if([pool_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= pool_size; });
+  num_free_frames_ -= num_free_frames - free_list_.size();
 
+  bool drained = true;
+  for (size_t i = pool_size; i < old_pool_size && drained; ++i) {
+    const auto frame_id = static_cast<frame_id_t>(i);
+    Page *page = GetFrame(frame_id);
+    // Only changed under latch_, so the page stays in the frame until latch_ is released.
+    page_id_t page_id;
+    while ((page_id = page->page_id_) != INVALID_PAGE_ID) {
+      PageTableShard &shard = GetShard(page_id);
+      std::unique_lock<std::mutex> shard_lock(shard.latch_);
+      if (page->pin_count_ > 0 || IoState(frame_id) != FrameIoState::NONE) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+          drained = false;
+          break;
+        }
+        // latch_ comes before the shard latch, so neither is held while waiting. The last unpin signals the frame.
+        lock->unlock();
+        IoCv(frame_id).wait_until(shard_lock, deadline);
+      } else if (page->is_dirty_) {
+        lock->unlock();
+        WriteBackFrame(&shard_lock, frame_id);
+      } else {
+        replacer_->Remove(frame_id);
+        shard.page_table_.erase(page_id);
+        page->page_id_ = INVALID_PAGE_ID;
+        break;
+      }
+      shard_lock.unlock();
+      lock->lock();
+    }
+  }
 
-bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id)
-{
-    latch_.lock();
-    if (page_table_.find(page_id)==page_table_.end() || page_id==INVALID_PAGE_ID)
-    {
-      latch_.unlock();
+  if (!drained) {
+    // The frames emptied so far go back to the free list, those PickFrame skipped back into the replacer.
+    for (size_t i = pool_size; i < old_pool_size; ++i) {
+      if (GetFrame(static_cast<frame_id_t>(i))->page_id_ == INVALID_PAGE_ID) {
+        free_list_.emplace_back(static_cast<frame_id_t>(i));
+        num_free_frames_++;
+      }
+    }
+    for (frame_id_t frame_id : skipped_frames_) {
+      Page *page = GetFrame(frame_id);
+      if (page->page_id_ == INVALID_PAGE_ID) {
+        continue;
+      }
+      std::scoped_lock shard_lock{GetShard(page->page_id_).latch_};
+      if (page->pin_count_ == 0 && IoState(frame_id) == FrameIoState::NONE) {
+        replacer_->RecordAccess(frame_id, AccessType::Unknown);
+        replacer_->Unpin(frame_id);
+      }
+    }
+    skipped_frames_.clear();
+    frame_limit_ = old_pool_size;
+    return false;
+  }
+
+  skipped_frames_.clear();
+  pool_size_ = pool_size;
+  // The frames left over in the last chunk keep their memory, the chunks past it give it back.
+  for (size_t i = (pool_size + FRAME_CHUNK_SIZE - 1) / FRAME_CHUNK_SIZE; i < chunks_.size(); ++i) {
+    if (chunks_[i]->pages_ != nullptr) {
+      chunks_[i]->pages_.reset();
+      FrameArena::Release(chunks_[i]->data_, FRAME_CHUNK_SIZE);
+    }
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
+  PageTableShard &shard = GetShard(page_id);
+  std::unique_lock<std::mutex> shard_lock(shard.latch_);
+  frame_id_t frame_id;
+  while (true) {
+    auto wb_iter = shard.write_back_table_.find(page_id);
+    if (wb_iter != shard.write_back_table_.end()) {
+      // The page is already on its way to disk, wait for it and look again.
+      IoCv(wb_iter->second).wait(shard_lock);
+      continue;
+    }
+    auto iter = shard.page_table_.find(page_id);
+    if (iter == shard.page_table_.end() || page_id == INVALID_PAGE_ID) {
       return false;
     }
-    disk_manager_->WritePage(page_id, pages_[page_table_.find(page_id)->second].data_);
-    pages_[page_table_.find(page_id)->second].is_dirty_=false;
-    latch_.unlock();
-    return true; 
+    frame_id = iter->second;
+    if (IoState(frame_id) == FrameIoState::NONE) {
+      break;
+    }
+    IoCv(frame_id).wait(shard_lock);
+  }
+  WriteBackFrame(&shard_lock, frame_id);
+  return true;
 }
 
+void BufferPoolManagerInstance::FlushAllPgsImp() {
+  // Only the dirty pages are written; WriteBackFrames sorts them, so runs of adjacent pages go out as one write.
+  std::vector<frame_id_t> frame_ids;
+  std::vector<page_id_t> busy_page_ids;
+  for (auto &shard : shards_) {
+    std::scoped_lock shard_lock{shard.latch_};
+    // BeginWriteBack takes the page out of the dirty set, so iterate over a copy.
+    std::vector<page_id_t> dirty_page_ids;
+    dirty_page_ids.reserve(shard.dirty_pages_.size());
+    for (const auto &[page_id, rec_lsn] : shard.dirty_pages_) {
+      dirty_page_ids.push_back(page_id);
+    }
+    for (page_id_t page_id : dirty_page_ids) {
+      const frame_id_t frame_id = shard.page_table_.at(page_id);
+      if (IoState(frame_id) == FrameIoState::NONE) {
+        BeginWriteBack(frame_id);
+        frame_ids.push_back(frame_id);
+      } else {
+        busy_page_ids.push_back(page_id);
+      }
+    }
+  }
+  WriteBackFrames(frame_ids);
+  // Pages with I/O running are flushed one by one, FlushPgImp waits for that I/O first.
+  for (page_id_t page_id : busy_page_ids) {
+    FlushPgImp(page_id);
+  }
+  disk_manager_->SyncPages();
+}
 
+Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
+  std::unique_lock<MeasuredMutex> lock(latch_);
+  frame_id_t frame_id;
+  page_id_t victim_page_id;
+  bool write_back;
+  if (!PickFrame(&frame_id, &victim_page_id, &write_back)) {
+    return nullptr;
+  }
+  *page_id = AllocatePage();
+  ReassignFrame(frame_id, *page_id, AccessType::Unknown);
+  LoadFrame(&lock, frame_id, victim_page_id, write_back, false);
+  return GetFrame(frame_id);
+}
 
-void BufferPoolManagerInstance::FlushAllPgsImp()
-{
-  for(size_t i=0;i<pool_size_;i++)
-  {
-    FlushPage(pages_[i].page_id_);
+Page *BufferPoolManagerInstance::NewPgInExtentImp(page_id_t *page_id, Extent *extent) {
+  std::unique_lock<MeasuredMutex> lock(latch_);
+  if (extent->next_page_id_ == extent->end_page_id_) {
+    extent->next_page_id_ = TakePageIds(EXTENT_SIZE);
+    extent->end_page_id_ = extent->next_page_id_ + EXTENT_SIZE;
+  }
+  frame_id_t frame_id;
+  page_id_t victim_page_id;
+  bool write_back;
+  if (!PickFrame(&frame_id, &victim_page_id, &write_back)) {
+    return nullptr;
   }
+  *page_id = extent->next_page_id_++;
+  ValidatePageId(*page_id);
+  ReassignFrame(frame_id, *page_id, AccessType::Unknown);
+  LoadFrame(&lock, frame_id, victim_page_id, write_back, false);
+  return GetFrame(frame_id);
 }
 
+Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id, AccessType access_type) {
+  // Hit path: only the page's shard latch is taken.
+  {
+    PageTableShard &shard = GetShard(page_id);
+    std::unique_lock<std::mutex> shard_lock(shard.latch_);
+    auto iter = shard.page_table_.find(page_id);
+    if (iter != shard.page_table_.end()) {
+      hits_.Add();
+      return PinFrame(&shard_lock, iter->second, access_type);
+    }
+  }
 
-Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) 
-{ 
-    latch_.lock();
-    frame_id_t fra;
-    if(!free_list_.empty())
-    {
-      fra=free_list_.front();
-      free_list_.pop_front();
+  // Miss path: frames are only ever reassigned under latch_, so the lookup is repeated under it.
+  std::unique_lock<MeasuredMutex> lock(latch_);
+  while (true) {
+    PageTableShard &shard = GetShard(page_id);
+    std::unique_lock<std::mutex> shard_lock(shard.latch_);
+    auto iter = shard.page_table_.find(page_id);
+    if (iter != shard.page_table_.end()) {
+      // Another thread read it in meanwhile.
+      lock.unlock();
+      hits_.Add();
+      return PinFrame(&shard_lock, iter->second, access_type);
     }
-    else 
-    {
-      bool is_s=replacer_->Victim(&fra);
-      if (is_s==false)
-      {
-        latch_.unlock();
-        return nullptr;
+    auto wb_iter = shard.write_back_table_.find(page_id);
+    if (wb_iter == shard.write_back_table_.end()) {
+      break;
+    }
+    // The page was just evicted and its write-back is still running, reading it now would see a stale copy.
+    frame_id_t wb_frame_id = wb_iter->second;
+    lock.unlock();
+    pin_waits_.Add();
+    IoCv(wb_frame_id).wait(shard_lock, [&] {
+      auto it = shard.write_back_table_.find(page_id);
+      return it == shard.write_back_table_.end() || it->second != wb_frame_id;
+    });
+    shard_lock.unlock();
+    lock.lock();
+  }
+
+  misses_.Add();
+  frame_id_t frame_id;
+  page_id_t victim_page_id;
+  bool write_back;
+  if (!PickFrame(&frame_id, &victim_page_id, &write_back)) {
+    return nullptr;
+  }
+  ReassignFrame(frame_id, page_id, access_type);
+  LoadFrame(&lock, frame_id, victim_page_id, write_back, true);
+  return GetFrame(frame_id);
+}
+
+bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
+  std::unique_lock<MeasuredMutex> lock(latch_);
+  PageTableShard &shard = GetShard(page_id);
+  std::unique_lock<std::mutex> shard_lock(shard.latch_);
+  frame_id_t frame_id;
+  while (true) {
+    frame_id_t wait_frame_id;
+    auto wb_iter = shard.write_back_table_.find(page_id);
+    if (wb_iter != shard.write_back_table_.end()) {
+      wait_frame_id = wb_iter->second;
+    } else {
+      auto iter = shard.page_table_.find(page_id);
+      if (page_id == INVALID_PAGE_ID || iter == shard.page_table_.end()) {
+        DeallocatePage(page_id);
+        return true;
       }
-      if (pages_[fra].is_dirty_==true)
-      {
-        disk_manager_->WritePage(pages_[fra].page_id_, pages_[fra].data_);
+      frame_id = iter->second;
+      if (GetFrame(frame_id)->pin_count_ > 0) {
+        return false;
       }
-      page_table_.erase(pages_[fra].page_id_);
-    }
-    page_id_t page_i=AllocatePage();
-    *page_id = page_i;
-    page_table_.insert(std::pair<page_id_t, frame_id_t>(page_i,fra));
-    replacer_->Pin(fra);
-    pages_[fra].ResetMemory();
-    pages_[fra].page_id_ = page_i;
-    pages_[fra].pin_count_ = 1;
-    pages_[fra].is_dirty_ = false;
-    latch_.unlock();
-    return &pages_[fra]; 
-}
-
-
-Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id)
-{
-    latch_.lock();
-    frame_id_t fra;
-    if(page_table_.find(page_id)!=page_table_.end())
-    {
-      fra=page_table_.find(page_id)->second;
-      pages_[fra].pin_count_ ++;
-      replacer_->Pin(fra);
-      latch_.unlock();
-      return &pages_[fra];
+      if (IoState(frame_id) == FrameIoState::NONE) {
+        break;
+      }
+      // A flush of this unpinned page is running.
+      wait_frame_id = frame_id;
     }
-    if(!free_list_.empty())
-    {
-      fra=free_list_.front();
-      free_list_.pop_front();
+    // latch_ comes before the shard latch, so neither is held while waiting.
+    lock.unlock();
+    IoCv(wait_frame_id).wait(shard_lock);
+    shard_lock.unlock();
+    lock.lock();
+    shard_lock.lock();
+  }
+
+  Page *page = GetFrame(frame_id);
+  replacer_->Remove(frame_id);
+  shard.page_table_.erase(page_id);
+  shard.dirty_pages_.erase(page_id);
+  page->ResetMemory();
+  page->page_id_ = INVALID_PAGE_ID;
+  page->is_dirty_ = false;
+  if (static_cast<size_t>(frame_id) < frame_limit_) {
+    free_list_.push_back(frame_id);
+    num_free_frames_++;
+  }
+  DeallocatePage(page_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
+  PageTableShard &shard = GetShard(page_id);
+  std::scoped_lock shard_lock{shard.latch_};
+  auto iter = shard.page_table_.find(page_id);
+  if (iter == shard.page_table_.end() || page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  frame_id_t frame_id = iter->second;
+  Page *page = GetFrame(frame_id);
+  if (page->pin_count_ <= 0) {
+    return false;
+  }
+  if (is_dirty) {
+    page->is_dirty_ = true;
+    shard.dirty_pages_.emplace(page_id, PinLSN(frame_id));
+  }
+  if (page->pin_count_.fetch_sub(1) == 1) {
+    if (IoState(frame_id) == FrameIoState::NONE) {
+      replacer_->Unpin(frame_id);
     }
-    else 
-    {
-      bool is_s=replacer_->Victim(&fra);
-      if (is_s==false)
-      {
-        latch_.unlock();
-        return nullptr;
-      }
-      if (pages_[fra].is_dirty_==true)
-      {
-        disk_manager_->WritePage(pages_[fra].page_id_, pages_[fra].data_);
-      }
-      page_table_.erase(pages_[fra].page_id_);
+    if (static_cast<size_t>(frame_id) >= frame_limit_) {
+      // Resize is waiting to take the frame out of the pool.
+      IoCv(frame_id).notify_all();
     }
-    page_table_.insert(std::pair<page_id_t, frame_id_t>(page_id,fra));
-    pages_[fra].ResetMemory();
-    pages_[fra].page_id_ = page_id;
-    pages_[fra].pin_count_ = 1;
-    pages_[fra].is_dirty_ = false;
-    replacer_->Pin(fra);
-    disk_manager_->ReadPage(page_id, pages_[fra].data_);
-    latch_.unlock();
-    return &pages_[fra];
+  }
+  return true;
+}
+
+BufferPoolManagerInstance::PageTableShard &BufferPoolManagerInstance::GetShard(page_id_t page_id) {
+  // Page ids of one instance are all congruent modulo num_instances_, divide that out to use every shard.
+  return shards_[static_cast<size_t>(page_id / static_cast<page_id_t>(num_instances_)) % shards_.size()];
+}
+
+Page *BufferPoolManagerInstance::PinFrame(std::unique_lock<std::mutex> *shard_lock, frame_id_t frame_id,
+                                         AccessType access_type) {
+  Page *page = GetFrame(frame_id);
+  if (page->pin_count_++ == 0) {
+    PinLSN(frame_id) = NextLSN();
+  }
+  // Pin before recording: an eviction racing with this hit must either miss the frame or drop its history before the
+  // access is recorded, never in between.
+  replacer_->Pin(frame_id);
+  replacer_->RecordAccess(frame_id, access_type);
+  // Pinned first, so the frame cannot be reassigned while another fetcher is still reading this page in.
+  if (IoState(frame_id) == FrameIoState::READING) {
+    pin_waits_.Add();
+  }
+  IoCv(frame_id).wait(*shard_lock, [&] { return IoState(frame_id) != FrameIoState::READING; });
+  return page;
+}
+
+bool BufferPoolManagerInstance::PickFrame(frame_id_t *frame_id, page_id_t *victim_page_id, bool *write_back) {
+  *victim_page_id = INVALID_PAGE_ID;
+  *write_back = false;
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    num_free_frames_--;
+    return true;
+  }
+  if (resident_) {
+    return false;
+  }
+  while (replacer_->Victim(frame_id)) {
+    if (static_cast<size_t>(*frame_id) >= frame_limit_) {
+      // Leaving the pool, Resize empties it.
+      skipped_frames_.push_back(*frame_id);
+      continue;
+    }
+    Page *page = GetFrame(*frame_id);
+    PageTableShard &shard = GetShard(page->page_id_);
+    std::scoped_lock shard_lock{shard.latch_};
+    if (page->pin_count_ > 0 || IoState(*frame_id) != FrameIoState::NONE) {
+      // Pinned by a hit or picked up by a flush after the replacer handed it out. Whoever drops the last pin or
+      // finishes the flush puts it back into the replacer.
+      continue;
+    }
+    shard.page_table_.erase(page->page_id_);
+    evictions_.Add();
+    *victim_page_id = page->page_id_;
+    *write_back = page->is_dirty_;
+    if (*write_back) {
+      // Off the dirty page table, but a checkpoint still has to list it until it is written.
+      shard.writing_pages_.emplace(*victim_page_id, shard.dirty_pages_.at(*victim_page_id));
+      shard.dirty_pages_.erase(*victim_page_id);
+      // The page cleaner fell behind, let it start a round now instead of at the end of its interval.
+      cleaner_cv_.notify_one();
+    }
+    if (*write_back || compressed_cache_ != nullptr) {
+      shard.write_back_table_.emplace(*victim_page_id, *frame_id);
+    }
+    return true;
+  }
+  return false;
+}
+
+void BufferPoolManagerInstance::ReassignFrame(frame_id_t frame_id, page_id_t page_id, AccessType access_type) {
+  Page *page = GetFrame(frame_id);
+  PageTableShard &shard = GetShard(page_id);
+  std::scoped_lock shard_lock{shard.latch_};
+  // The frame left the replacer (and lost its history) when it was picked, so this starts a fresh, pinned history.
+  replacer_->RecordLoad(frame_id, page_id, access_type);
+  shard.page_table_.emplace(page_id, frame_id);
+  page->page_id_ = page_id;
+  page->pin_count_ = 1;
+  page->is_dirty_ = false;
+  PinLSN(frame_id) = NextLSN();
+  IoState(frame_id) = FrameIoState::READING;
+}
+
+void BufferPoolManagerInstance::LoadFrame(std::unique_lock<MeasuredMutex> *lock, frame_id_t frame_id,
+                                          page_id_t victim_page_id, bool write_back, bool read_page) {
+  // Nobody else touches the frame while it is READING: the new page is pinned by us, the victim is unreachable.
+  Page *page = GetFrame(frame_id);
+  const page_id_t page_id = page->page_id_;
+  lock->unlock();
+  const bool cache_victim = compressed_cache_ != nullptr && victim_page_id != INVALID_PAGE_ID;
+  if (cache_victim) {
+    compressed_cache_->Insert(victim_page_id, page->GetData());
+  }
+  std::vector<PageIoRequest> requests;
+  if (write_back) {
+    ForceLog(page->GetLSN());
+    requests.push_back({true, victim_page_id, page->GetData()});
+    foreground_write_backs_.Add();
+  }
+  char cached_page[PAGE_SIZE];
+  bool from_cache = false;
+  if (read_page) {
+    from_cache = compressed_cache_ != nullptr && compressed_cache_->Lookup(page_id, cached_page);
+    if (!from_cache) {
+      requests.push_back({false, page_id, page->GetData()});
+    }
+  }
+  // One submission for the write-back and the read, ordered since both use the frame's buffer.
+  if (!requests.empty()) {
+    disk_manager_->SubmitPageIo(std::move(requests), true).wait();
+  }
+  if (from_cache) {
+    std::memcpy(page->GetData(), cached_page, PAGE_SIZE);
+  } else if (!read_page) {
+    page->ResetMemory();
+  }
+
+  if (write_back || cache_victim) {
+    PageTableShard &victim_shard = GetShard(victim_page_id);
+    std::scoped_lock victim_shard_lock{victim_shard.latch_};
+    victim_shard.write_back_table_.erase(victim_page_id);
+    victim_shard.writing_pages_.erase(victim_page_id);
+    IoCv(frame_id).notify_all();
+  }
+  PageTableShard &shard = GetShard(page_id);
+  std::scoped_lock shard_lock{shard.latch_};
+  if (!read_page) {
+    // A new page may reuse a freed page whose old contents are still on disk, so the zeroed frame must get there.
+    page->is_dirty_ = true;
+    shard.dirty_pages_.emplace(page_id, PinLSN(frame_id));
+  }
+  IoState(frame_id) = FrameIoState::NONE;
+  IoCv(frame_id).notify_all();
+}
+
+void BufferPoolManagerInstance::WriteBackFrame(std::unique_lock<std::mutex> *shard_lock, frame_id_t frame_id) {
+  Page *page = GetFrame(frame_id);
+  const page_id_t page_id = page->page_id_;
+  BeginWriteBack(frame_id);
+  shard_lock->unlock();
+  ForceLog(page->GetLSN());
+  disk_manager_->WritePage(page_id, page->GetData());
+  shard_lock->lock();
+  EndWriteBack(frame_id);
+}
+
+void BufferPoolManagerInstance::BeginWriteBack(frame_id_t frame_id) {
+  IoState(frame_id) = FrameIoState::WRITING;
+  replacer_->Pin(frame_id);
+  // Cleared before the write so that an unpin with is_dirty during the write marks the page dirty again.
+  Page *page = GetFrame(frame_id);
+  page->is_dirty_ = false;
+  PageTableShard &shard = GetShard(page->page_id_);
+  auto iter = shard.dirty_pages_.find(page->page_id_);
+  if (iter != shard.dirty_pages_.end()) {
+    shard.writing_pages_.emplace(page->page_id_, iter->second);
+    shard.dirty_pages_.erase(iter);
+  }
+}
+
+void BufferPoolManagerInstance::EndWriteBack(frame_id_t frame_id) {
+  GetShard(GetFrame(frame_id)->page_id_).writing_pages_.erase(GetFrame(frame_id)->page_id_);
+  IoState(frame_id) = FrameIoState::NONE;
+  if (GetFrame(frame_id)->pin_count_ == 0) {
+    replacer_->Unpin(frame_id);
+  }
+  IoCv(frame_id).notify_all();
 }
 
+void BufferPoolManagerInstance::WriteBackFrames(const std::vector<frame_id_t> &frame_ids) {
+  if (frame_ids.empty()) {
+    return;
+  }
+  // The frames are WRITING, so their pages stay put and nobody else writes to them. In page id order, the disk
+  // manager merges the writes of adjacent pages.
+  std::vector<frame_id_t> sorted_frame_ids(frame_ids);
+  std::sort(sorted_frame_ids.begin(), sorted_frame_ids.end(),
+            [this](frame_id_t a, frame_id_t b) { return GetFrame(a)->page_id_ < GetFrame(b)->page_id_; });
+  std::vector<PageIoRequest> requests;
+  requests.reserve(sorted_frame_ids.size());
+  lsn_t max_lsn = INVALID_LSN;
+  for (frame_id_t frame_id : sorted_frame_ids) {
+    Page *page = GetFrame(frame_id);
+    requests.push_back({true, page->page_id_, page->GetData()});
+    max_lsn = std::max(max_lsn, page->GetLSN());
+  }
+  ForceLog(max_lsn);
+  disk_manager_->SubmitPageIo(std::move(requests)).wait();
+  for (frame_id_t frame_id : frame_ids) {
+    PageTableShard &shard = GetShard(GetFrame(frame_id)->page_id_);
+    std::scoped_lock shard_lock{shard.latch_};
+    EndWriteBack(frame_id);
+  }
+}
 
+bool BufferPoolManagerInstance::IsLogPersistent(Page *page) {
+  return !enable_logging || log_manager_ == nullptr || page->GetLSN() <= log_manager_->GetPersistentLSN();
+}
 
-bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) 
-{
-    latch_.lock();
-    if (page_id==INVALID_PAGE_ID || page_table_.find(page_id)==page_table_.end())
+void BufferPoolManagerInstance::ForceLog(lsn_t lsn) {
+  if (enable_logging && log_manager_ != nullptr && lsn > log_manager_->GetPersistentLSN()) {
+    log_manager_->FlushUntil(lsn);
+  }
+}
+
+void BufferPoolManagerInstance::PrefetchPages(page_id_t page_id, size_t count, next_page_fn next_page) {
+  read_ahead_.Submit(page_id, count, std::move(next_page));
+}
+
+std::vector<page_id_t> BufferPoolManagerInstance::GetResidentPages() {
+  // latch_ keeps frames from being reassigned while they are listed.
+  std::scoped_lock lock{latch_};
+  const size_t pool_size = pool_size_;
+  std::vector<frame_id_t> frame_ids = replacer_->GetRetentionOrder();
+  for (size_t i = 0; i < pool_size; ++i) {
+    frame_ids.push_back(static_cast<frame_id_t>(i));
+  }
+  std::vector<bool> listed(pool_size, false);
+  std::vector<page_id_t> page_ids;
+  for (frame_id_t frame_id : frame_ids) {
+    const auto index = static_cast<size_t>(frame_id);
+    if (index >= pool_size || listed[index] || GetFrame(frame_id)->page_id_ == INVALID_PAGE_ID) {
+      continue;
+    }
+    listed[index] = true;
+    page_ids.push_back(GetFrame(frame_id)->page_id_);
+  }
+  return page_ids;
+}
+
+size_t BufferPoolManagerInstance::LoadPages(const std::vector<page_id_t> &page_ids) {
+  // Pages past the end of the file, e.g. listed before it was recreated, have nothing to read.
+  const int64_t file_size = disk_manager_->GetDbFileSize();
+  std::vector<frame_id_t> frame_ids;
+  std::unique_lock<MeasuredMutex> lock(latch_);
+  for (page_id_t page_id : page_ids) {
+    if (free_list_.empty()) {
+      break;
+    }
+    if (page_id == INVALID_PAGE_ID || (static_cast<int64_t>(page_id) + 1) * PAGE_SIZE > file_size ||
+        page_id % static_cast<page_id_t>(num_instances_) != static_cast<page_id_t>(instance_index_)) {
+      continue;
+    }
     {
-      latch_.unlock();
-      return true;
+      // Pages only become resident under latch_, so they cannot show up between this check and ReassignFrame.
+      PageTableShard &shard = GetShard(page_id);
+      std::scoped_lock shard_lock{shard.latch_};
+      if (shard.page_table_.count(page_id) > 0 || shard.write_back_table_.count(page_id) > 0) {
+        continue;
+      }
     }
-    if (pages_[page_table_.find(page_id)->second].pin_count_>0)
+    const frame_id_t frame_id = free_list_.front();
+    free_list_.pop_front();
+    num_free_frames_--;
+    ReassignFrame(frame_id, page_id, AccessType::Unknown);
+    frame_ids.push_back(frame_id);
+  }
+  lock.unlock();
+
+  // The frames are READING and pinned by us, nobody else touches them.
+  std::vector<PageIoRequest> requests;
+  for (frame_id_t frame_id : frame_ids) {
+    Page *page = GetFrame(frame_id);
+    if (compressed_cache_ == nullptr || !compressed_cache_->Lookup(page->page_id_, page->GetData())) {
+      requests.push_back({false, page->page_id_, page->GetData()});
+    }
+  }
+  if (!requests.empty()) {
+    disk_manager_->SubmitPageIo(std::move(requests)).wait();
+  }
+  for (frame_id_t frame_id : frame_ids) {
+    const page_id_t page_id = GetFrame(frame_id)->page_id_;
     {
-      latch_.unlock();
-      return false;
+      PageTableShard &shard = GetShard(page_id);
+      std::scoped_lock shard_lock{shard.latch_};
+      IoState(frame_id) = FrameIoState::NONE;
+      IoCv(frame_id).notify_all();
     }
-    frame_id_t fra=page_table_.find(page_id)->second;
-    free_list_.push_back(fra);
-    replacer_->Pin(fra);
-    page_table_.erase(page_id);
-    pages_[fra].ResetMemory();
-    DeallocatePage(page_id);
-    latch_.unlock();
-    return true; 
+    UnpinPgImp(page_id, false);
+  }
+  return frame_ids.size();
 }
 
+void BufferPoolManagerInstance::StartPageCleaner(size_t target_clean_frames, double max_dirty_ratio,
+                                                 std::chrono::milliseconds interval) {
+  BUSTUB_ASSERT(!cleaner_thread_.joinable(), "The page cleaner is already running.");
+  cleaner_target_clean_frames_ = std::min(target_clean_frames, pool_size_.load());
+  cleaner_max_dirty_ratio_ = max_dirty_ratio;
+  cleaner_interval_ = interval;
+  cleaner_stop_ = false;
+  cleaner_thread_ = std::thread(&BufferPoolManagerInstance::PageCleanerLoop, this);
+}
 
-bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty)
-{
-    latch_.lock();
-    if (page_table_.find(page_id)==page_table_.end() || page_id==INVALID_PAGE_ID || pages_[page_table_.find(page_id)->second].pin_count_==0)
-    {
-        latch_.unlock();
-        return false;
+void BufferPoolManagerInstance::StopPageCleaner() {
+  if (!cleaner_thread_.joinable()) {
+    return;
+  }
+  {
+    std::scoped_lock lock{cleaner_latch_};
+    cleaner_stop_ = true;
+  }
+  cleaner_cv_.notify_all();
+  cleaner_thread_.join();
+}
+
+void BufferPoolManagerInstance::PageCleanerLoop() {
+  std::unique_lock<std::mutex> lock(cleaner_latch_);
+  while (!cleaner_stop_) {
+    lock.unlock();
+    CleanPages(cleaner_target_clean_frames_, cleaner_max_dirty_ratio_);
+    lock.lock();
+    if (!cleaner_stop_) {
+      cleaner_cv_.wait_for(lock, cleaner_interval_);
     }
-    auto iter = page_table_.find(page_id);
-    frame_id_t frame_id = iter->second;
-    Page *page = &pages_[frame_id];
-    if (page->GetPinCount() <= 0) {  // 如果没被pin过，直接返回false
-    return false;
+  }
+}
+
+size_t BufferPoolManagerInstance::CleanPages(size_t target_clean_frames, double max_dirty_ratio) {
+  // Take stock shard by shard. The numbers are only a heuristic, every candidate is checked again before its write.
+  std::vector<std::pair<page_id_t, frame_id_t>> candidates;
+  size_t resident = 0;
+  size_t dirty = 0;
+  size_t clean_unpinned = 0;
+  for (auto &shard : shards_) {
+    std::scoped_lock shard_lock{shard.latch_};
+    for (const auto &entry : shard.page_table_) {
+      const Page &page = *GetFrame(entry.second);
+      resident++;
+      dirty += page.is_dirty_ ? 1 : 0;
+      if (page.pin_count_ > 0 || IoState(entry.second) != FrameIoState::NONE) {
+        continue;
+      }
+      if (page.is_dirty_) {
+        candidates.push_back(entry);
+      } else {
+        clean_unpinned++;
+      }
     }
-    pages_[page_table_.find(page_id)->second].pin_count_--;
-    pages_[page_table_.find(page_id)->second].is_dirty_ |=is_dirty;
-    if (page->GetPinCount() <= 0) {
-    replacer_->Unpin(frame_id);
+  }
+
+  // Frames without a resident page are free, or being refilled right now.
+  const size_t pool_size = pool_size_;
+  const size_t clean = pool_size - std::min(resident, pool_size) + clean_unpinned;
+  size_t to_write = target_clean_frames > clean ? target_clean_frames - clean : 0;
+  const auto max_dirty = static_cast<size_t>(max_dirty_ratio * static_cast<double>(pool_size));
+  if (dirty > max_dirty) {
+    to_write = std::max(to_write, dirty - max_dirty);
+  }
+
+  std::vector<frame_id_t> frame_ids;
+  for (const auto &candidate : candidates) {
+    if (frame_ids.size() >= to_write) {
+      break;
     }
-    latch_.unlock();
-    return true;
+    PageTableShard &shard = GetShard(candidate.first);
+    std::scoped_lock shard_lock{shard.latch_};
+    auto iter = shard.page_table_.find(candidate.first);
+    if (iter == shard.page_table_.end() || iter->second != candidate.second) {
+      continue;
+    }
+    Page *page = GetFrame(candidate.second);
+    if (page->pin_count_ > 0 || !page->is_dirty_ || IoState(candidate.second) != FrameIoState::NONE ||
+        !IsLogPersistent(page)) {
+      continue;
+    }
+    BeginWriteBack(candidate.second);
+    frame_ids.push_back(candidate.second);
+  }
+  WriteBackFrames(frame_ids);
+  background_write_backs_.Add(frame_ids.size());
+  return frame_ids.size();
 }
 
 page_id_t BufferPoolManagerInstance::AllocatePage() {
+  const page_id_t free_page_id = disk_manager_->AllocateFreePage(num_instances_, instance_index_);
+  if (free_page_id != INVALID_PAGE_ID) {
+    ValidatePageId(free_page_id);
+    return free_page_id;
+  }
+  if (page_id_source_ != nullptr) {
+    if (source_page_ids_.next_page_id_ == source_page_ids_.end_page_id_) {
+      source_page_ids_.next_page_id_ = TakePageIds(EXTENT_SIZE);
+      source_page_ids_.end_page_id_ = source_page_ids_.next_page_id_ + EXTENT_SIZE;
+    }
+    return source_page_ids_.next_page_id_++;
+  }
   const page_id_t next_page_id = next_page_id_;
   next_page_id_ += num_instances_;
   ValidatePageId(next_page_id);
   return next_page_id;
 }
 
+page_id_t BufferPoolManagerInstance::TakePageIds(size_t count) {
+  const auto num_page_ids = static_cast<page_id_t>(count);
+  if (page_id_source_ != nullptr) {
+    const page_id_t start = page_id_source_->ReservePageIds(count);
+    BUSTUB_ASSERT(start != INVALID_PAGE_ID, "The page id source cannot reserve page ids");
+    // DeallocatePage only frees pages below next_page_id_.
+    next_page_id_ = std::max(next_page_id_.load(), start + num_page_ids);
+    return start;
+  }
+  BUSTUB_ASSERT(num_instances_ == 1, "The page ids of a parallel buffer pool are reserved by the parallel BPM");
+  const page_id_t start = next_page_id_;
+  next_page_id_ += num_page_ids;
+  return start;
+}
+
+page_id_t BufferPoolManagerInstance::ReservePageIds(size_t count) {
+  if (num_instances_ != 1) {
+    return INVALID_PAGE_ID;
+  }
+  std::scoped_lock lock{latch_};
+  return TakePageIds(count);
+}
+
+double BufferPoolManagerInstance::GetHitRatio() const {
+  const uint64_t hits = hits_.Get();
+  const uint64_t fetches = hits + misses_.Get();
+  return fetches == 0 ? 0 : static_cast<double>(hits) / static_cast<double>(fetches);
+}
+
+std::vector<BufferPoolMetrics> BufferPoolManagerInstance::GetMetrics() {
+  BufferPoolMetrics metrics;
+  metrics.hits_ = hits_.Get();
+  metrics.misses_ = misses_.Get();
+  metrics.evictions_ = evictions_.Get();
+  metrics.foreground_write_backs_ = foreground_write_backs_.Get();
+  metrics.background_write_backs_ = background_write_backs_.Get();
+  metrics.pin_waits_ = pin_waits_.Get();
+  metrics.latch_hold_ = latch_hold_times_.GetSnapshot();
+  return {metrics};
+}
+
+std::vector<std::pair<page_id_t, lsn_t>> BufferPoolManagerInstance::GetDirtyPages() {
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  for (auto &shard : shards_) {
+    std::scoped_lock shard_lock{shard.latch_};
+    std::unordered_map<page_id_t, lsn_t> rec_lsns(shard.writing_pages_);
+    auto add = [&rec_lsns](page_id_t page_id, lsn_t rec_lsn) {
+      auto [iter, inserted] = rec_lsns.emplace(page_id, rec_lsn);
+      if (!inserted) {
+        iter->second = std::min(iter->second, rec_lsn);
+      }
+    };
+    for (const auto &[page_id, rec_lsn] : shard.dirty_pages_) {
+      add(page_id, rec_lsn);
+    }
+    // A page is marked dirty when it is unpinned, after the changes made under the pin were logged.
+    for (const auto &[page_id, frame_id] : shard.page_table_) {
+      if (GetFrame(frame_id)->pin_count_ > 0) {
+        add(page_id, PinLSN(frame_id));
+      }
+    }
+    dirty_pages.insert(dirty_pages.end(), rec_lsns.begin(), rec_lsns.end());
+  }
+  return dirty_pages;
+}
+
+size_t BufferPoolManagerInstance::WriteBackPages(const std::vector<page_id_t> &page_ids) {
+  std::vector<frame_id_t> frame_ids;
+  std::vector<page_id_t> busy_page_ids;
+  for (page_id_t page_id : page_ids) {
+    PageTableShard &shard = GetShard(page_id);
+    std::scoped_lock shard_lock{shard.latch_};
+    if (shard.dirty_pages_.count(page_id) == 0) {
+      continue;
+    }
+    const frame_id_t frame_id = shard.page_table_.at(page_id);
+    if (IoState(frame_id) == FrameIoState::NONE) {
+      BeginWriteBack(frame_id);
+      frame_ids.push_back(frame_id);
+    } else {
+      busy_page_ids.push_back(page_id);
+    }
+  }
+  WriteBackFrames(frame_ids);
+  size_t num_written = frame_ids.size();
+  for (page_id_t page_id : busy_page_ids) {
+    num_written += FlushPgImp(page_id) ? 1 : 0;
+  }
+  return num_written;
+}
+
+page_id_t BufferPoolManagerInstance::SkipPageIds(page_id_t end) {
+  std::scoped_lock lock{latch_};
+  return SkipPageIdsLocked(end);
+}
+
+page_id_t BufferPoolManagerInstance::SkipPageIdsLocked(page_id_t end) {
+  const page_id_t next_page_id = next_page_id_;
+  while (next_page_id_ < end) {
+    next_page_id_ += static_cast<page_id_t>(num_instances_);
+  }
+  return next_page_id;
+}
+
+void BufferPoolManagerInstance::ReleaseExtent(Extent *extent) {
+  std::scoped_lock lock{latch_};
+  for (; extent->next_page_id_ < extent->end_page_id_; extent->next_page_id_++) {
+    DeallocatePage(extent->next_page_id_);
+  }
+}
+
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  // Only pages this instance handed out can be freed, anything else would be allocated twice.
+  if (page_id == INVALID_PAGE_ID || page_id >= next_page_id_) {
+    return;
+  }
+  ValidatePageId(page_id);
+  if (compressed_cache_ != nullptr) {
+    // The id may be handed out again, its old contents must not come back.
+    compressed_cache_->Erase(page_id);
+  }
+  disk_manager_->DeallocatePage(page_id);
+}
+
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
   assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
 }
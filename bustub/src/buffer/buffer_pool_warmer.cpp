@@ -0,0 +1,143 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_warmer.cpp
+//
+// Identification: src/buffer/buffer_pool_warmer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_warmer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+/** First word of a dump file. */
+constexpr uint32_t DUMP_MAGIC = 0x57524d42;
+
+}  // namespace
+
+BufferPoolWarmer::BufferPoolWarmer(BufferPoolManager *buffer_pool_manager, std::string file_name)
+    : buffer_pool_manager_(buffer_pool_manager), file_name_(std::move(file_name)) {}
+
+bool BufferPoolWarmer::Dump() {
+  std::scoped_lock lock{dump_latch_};
+  const std::vector<page_id_t> page_ids = buffer_pool_manager_->GetResidentPages();
+  const std::string tmp_name = file_name_ + ".tmp";
+  {
+    std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc);
+    const auto count = static_cast<uint32_t>(page_ids.size());
+    out.write(reinterpret_cast<const char *>(&DUMP_MAGIC), sizeof(DUMP_MAGIC));
+    out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char *>(page_ids.data()),
+              static_cast<std::streamsize>(page_ids.size() * sizeof(page_id_t)));
+    out.flush();
+    if (!out.good()) {
+      LOG_DEBUG("I/O error while writing the buffer pool dump");
+      remove(tmp_name.c_str());
+      return false;
+    }
+  }
+  return rename(tmp_name.c_str(), file_name_.c_str()) == 0;
+}
+
+void BufferPoolWarmer::StartDumper(std::chrono::milliseconds interval) {
+  BUSTUB_ASSERT(!dumper_thread_.joinable(), "The dumper is already running.");
+  {
+    std::scoped_lock lock{latch_};
+    stop_ = false;
+  }
+  dumper_thread_ = std::thread(&BufferPoolWarmer::RunDumper, this, interval);
+}
+
+bool BufferPoolWarmer::StartLoader() {
+  BUSTUB_ASSERT(!loader_thread_.joinable(), "The loader is already running.");
+  std::vector<page_id_t> page_ids;
+  if (!ReadFile(&page_ids)) {
+    return false;
+  }
+  {
+    std::scoped_lock lock{latch_};
+    stop_ = false;
+  }
+  loader_thread_ = std::thread(&BufferPoolWarmer::RunLoader, this, std::move(page_ids));
+  return true;
+}
+
+void BufferPoolWarmer::WaitForLoader() {
+  if (loader_thread_.joinable()) {
+    loader_thread_.join();
+  }
+}
+
+void BufferPoolWarmer::Stop() {
+  {
+    std::scoped_lock lock{latch_};
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (dumper_thread_.joinable()) {
+    dumper_thread_.join();
+  }
+  if (loader_thread_.joinable()) {
+    loader_thread_.join();
+  }
+}
+
+void BufferPoolWarmer::RunDumper(std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (!cv_.wait_for(lock, interval, [this] { return stop_; })) {
+    lock.unlock();
+    Dump();
+    lock.lock();
+  }
+}
+
+void BufferPoolWarmer::RunLoader(std::vector<page_id_t> page_ids) {
+  page_ids.resize(std::min(page_ids.size(), buffer_pool_manager_->GetPoolSize()));
+  for (size_t begin = 0; begin < page_ids.size(); begin += BATCH_SIZE) {
+    {
+      std::scoped_lock lock{latch_};
+      if (stop_) {
+        return;
+      }
+    }
+    std::vector<page_id_t> batch(page_ids.begin() + begin,
+                                 page_ids.begin() + std::min(begin + BATCH_SIZE, page_ids.size()));
+    std::sort(batch.begin(), batch.end());
+    loaded_pages_ += buffer_pool_manager_->LoadPages(batch);
+  }
+}
+
+bool BufferPoolWarmer::ReadFile(std::vector<page_id_t> *page_ids) {
+  std::ifstream in(file_name_, std::ios::binary);
+  uint32_t magic = 0;
+  uint32_t count = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  if (!in.good() || magic != DUMP_MAGIC) {
+    return false;
+  }
+  page_ids->resize(count);
+  in.read(reinterpret_cast<char *>(page_ids->data()), static_cast<std::streamsize>(count * sizeof(page_id_t)));
+  if (in.gcount() != static_cast<std::streamsize>(count * sizeof(page_id_t))) {
+    LOG_DEBUG("The buffer pool dump is truncated");
+    page_ids->clear();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace bustub
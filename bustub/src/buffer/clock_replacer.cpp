@@ -12,18 +12,129 @@
 
 #include "buffer/clock_replacer.h"
 
+#include <algorithm>
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) { SetNumFrames(num_pages); }
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock{latch_};
+  const size_t num_frames = num_frames_.load(std::memory_order_relaxed);
+  // The first turn of the hand clears the reference bits, the second finds them still clear unless hit meanwhile.
+  for (size_t step = 0; step < 2 * num_frames; ++step) {
+    const auto candidate = static_cast<frame_id_t>(hand_);
+    hand_ = (hand_ + 1) % num_frames;
+    ClockFrame &frame = GetFrame(candidate);
+    if (frame.state_.load(std::memory_order_acquire) != FrameState::EVICTABLE) {
+      continue;
+    }
+    if (frame.referenced_.exchange(false, std::memory_order_relaxed)) {
+      continue;
+    }
+    // Fails if the frame was pinned since it was looked at.
+    if (Transition(candidate, &frame, FrameState::EVICTABLE, FrameState::NONE)) {
+      *frame_id = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_.load(std::memory_order_relaxed), "Invalid frame id");
+  ClockFrame &frame = GetFrame(frame_id);
+  if (frame.state_.load(std::memory_order_relaxed) == FrameState::EVICTABLE) {
+    Transition(frame_id, &frame, FrameState::EVICTABLE, FrameState::PINNED);
+  }
+}
+
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_.load(std::memory_order_relaxed), "Invalid frame id");
+  ClockFrame &frame = GetFrame(frame_id);
+  frame.referenced_.store(true, std::memory_order_relaxed);
+  FrameState state = frame.state_.load(std::memory_order_relaxed);
+  if (state != FrameState::EVICTABLE) {
+    Transition(frame_id, &frame, state, FrameState::EVICTABLE);
+  }
+}
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_.load(std::memory_order_relaxed), "Invalid frame id");
+  ClockFrame &frame = GetFrame(frame_id);
+  if (frame.state_.load(std::memory_order_relaxed) == FrameState::NONE) {
+    // A hit on a frame that was handed out as a victim but kept its page, or a page just read in.
+    Transition(frame_id, &frame, FrameState::NONE, FrameState::PINNED);
+  }
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_.load(std::memory_order_relaxed), "Invalid frame id");
+  ClockFrame &frame = GetFrame(frame_id);
+  frame.referenced_.store(false, std::memory_order_relaxed);
+  if (frame.state_.exchange(FrameState::NONE, std::memory_order_acq_rel) == FrameState::EVICTABLE) {
+    GetStripe(frame_id).fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void ClockReplacer::SetNumFrames(size_t num_frames) {
+  std::scoped_lock lock{latch_};
+  if (num_frames <= num_frames_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  const size_t num_chunks = (num_frames + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  if (num_chunks > chunks_.size()) {
+    auto chunk_table = std::make_unique<ClockFrame *[]>(num_chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+      if (i == chunks_.size()) {
+        chunks_.emplace_back(std::make_unique<ClockFrame[]>(CHUNK_SIZE));
+      }
+      chunk_table[i] = chunks_[i].get();
+    }
+    chunk_table_.store(chunk_table.get(), std::memory_order_release);
+    chunk_tables_.emplace_back(std::move(chunk_table));
+  }
+  num_frames_.store(num_frames, std::memory_order_release);
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+std::vector<frame_id_t> ClockReplacer::GetRetentionOrder() {
+  std::scoped_lock lock{latch_};
+  const size_t num_frames = num_frames_.load(std::memory_order_relaxed);
+  // The hand reaches the frames just behind it last.
+  std::vector<frame_id_t> frame_ids;
+  std::vector<frame_id_t> unreferenced;
+  for (size_t step = 1; step <= num_frames; ++step) {
+    const auto frame_id = static_cast<frame_id_t>((hand_ + num_frames - step) % num_frames);
+    ClockFrame &frame = GetFrame(frame_id);
+    if (frame.state_.load(std::memory_order_acquire) == FrameState::NONE) {
+      continue;
+    }
+    (frame.referenced_.load(std::memory_order_relaxed) ? frame_ids : unreferenced).push_back(frame_id);
+  }
+  frame_ids.insert(frame_ids.end(), unreferenced.begin(), unreferenced.end());
+  return frame_ids;
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+size_t ClockReplacer::Size() {
+  int64_t size = 0;
+  for (auto &stripe : size_stripes_) {
+    size += stripe.count_.load(std::memory_order_relaxed);
+  }
+  return static_cast<size_t>(std::max<int64_t>(size, 0));
+}
 
-size_t ClockReplacer::Size() { return 0; }
+bool ClockReplacer::Transition(frame_id_t frame_id, ClockFrame *frame, FrameState from, FrameState to) {
+  if (!frame->state_.compare_exchange_strong(from, to, std::memory_order_acq_rel)) {
+    return false;
+  }
+  if (from == FrameState::EVICTABLE) {
+    GetStripe(frame_id).fetch_sub(1, std::memory_order_relaxed);
+  } else if (to == FrameState::EVICTABLE) {
+    GetStripe(frame_id).fetch_add(1, std::memory_order_relaxed);
+  }
+  return true;
+}
 
 }  // namespace bustub
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <utility>
+
+#include "common/util/lz_util.h"
+
+namespace bustub {
+
+CompressedPageCache::CompressedPageCache(size_t budget) : budget_(budget) {}
+
+void CompressedPageCache::Insert(page_id_t page_id, const char *data) {
+  char buffer[MAX_COMPRESSED_SIZE];
+  const size_t size = LZUtil::Compress(data, PAGE_SIZE, buffer, sizeof(buffer));
+  std::scoped_lock lock{latch_};
+  auto iter = entries_.find(page_id);
+  if (iter != entries_.end()) {
+    EraseLocked(iter);
+  }
+  if (size == 0 || size > budget_) {
+    return;
+  }
+  num_inserted_++;
+  compressed_bytes_ += size;
+  while (size_ + size > budget_) {
+    EraseLocked(entries_.find(lru_.back()));
+  }
+  lru_.push_front(page_id);
+  entries_.emplace(page_id, Entry{std::vector<char>(buffer, buffer + size), lru_.begin()});
+  size_ += size;
+}
+
+bool CompressedPageCache::Lookup(page_id_t page_id, char *data) {
+  lookups_++;
+  std::vector<char> compressed;
+  {
+    std::scoped_lock lock{latch_};
+    auto iter = entries_.find(page_id);
+    if (iter == entries_.end()) {
+      return false;
+    }
+    compressed = std::move(iter->second.data_);
+    size_ -= compressed.size();
+    lru_.erase(iter->second.lru_iter_);
+    entries_.erase(iter);
+  }
+  hits_++;
+  const size_t size = LZUtil::Decompress(compressed.data(), compressed.size(), data, PAGE_SIZE);
+  BUSTUB_ASSERT(size == PAGE_SIZE, "A cached page must decompress to a whole page");
+  return true;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::scoped_lock lock{latch_};
+  auto iter = entries_.find(page_id);
+  if (iter != entries_.end()) {
+    EraseLocked(iter);
+  }
+}
+
+size_t CompressedPageCache::GetNumPages() {
+  std::scoped_lock lock{latch_};
+  return entries_.size();
+}
+
+size_t CompressedPageCache::GetSize() {
+  std::scoped_lock lock{latch_};
+  return size_;
+}
+
+double CompressedPageCache::GetHitRatio() const {
+  const uint64_t lookups = lookups_;
+  return lookups == 0 ? 0.0 : static_cast<double>(hits_) / static_cast<double>(lookups);
+}
+
+double CompressedPageCache::GetCompressionRatio() const {
+  const uint64_t compressed_bytes = compressed_bytes_;
+  return compressed_bytes == 0 ? 0.0
+                               : static_cast<double>(num_inserted_ * PAGE_SIZE) / static_cast<double>(compressed_bytes);
+}
+
+void CompressedPageCache::EraseLocked(std::unordered_map<page_id_t, Entry>::iterator iter) {
+  size_ -= iter->second.data_.size();
+  lru_.erase(iter->second.lru_iter_);
+  entries_.erase(iter);
+}
+
+}  // namespace bustub
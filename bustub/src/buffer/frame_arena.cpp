@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+FrameArena::~FrameArena() {
+  for (const Segment &segment : segments_) {
+    munmap(segment.data_, segment.size_);
+  }
+}
+
+char *FrameArena::Allocate(size_t num_frames) {
+  const size_t size = num_frames * PAGE_SIZE;
+  // Over-map by one huge page, then trim both ends so that the segment starts on a huge page boundary.
+  const size_t slack = huge_pages_ ? HUGE_PAGE_SIZE : 0;
+  void *addr = mmap(nullptr, size + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map the buffer pool frames");
+  }
+  auto *data = static_cast<char *>(addr);
+  if (huge_pages_) {
+    const auto address = reinterpret_cast<uintptr_t>(data);
+    const size_t head = (HUGE_PAGE_SIZE - address % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+    if (head > 0) {
+      munmap(data, head);
+    }
+    if (slack > head) {
+      munmap(data + head + size, slack - head);
+    }
+    data += head;
+#ifdef MADV_HUGEPAGE
+    if (madvise(data, size, MADV_HUGEPAGE) != 0) {
+      LOG_DEBUG("transparent huge pages are not available");
+    }
+#endif
+  }
+  segments_.push_back({data, size});
+  return data;
+}
+
+void FrameArena::Release(char *data, size_t num_frames) {
+  if (madvise(data, num_frames * PAGE_SIZE, MADV_DONTNEED) != 0) {
+    LOG_DEBUG("cannot release the memory of buffer pool frames");
+  }
+}
+
+size_t FrameArena::GetMappedSize() const {
+  size_t size = 0;
+  for (const Segment &segment : segments_) {
+    size += segment.size_;
+  }
+  return size;
+}
+
+}  // namespace bustub
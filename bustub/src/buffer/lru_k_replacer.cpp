@@ -11,115 +11,113 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/lru_k_replacer.h"
-//#include "common/exception.h"
 
-namespace bustub {
-
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(0), k_(k) {}
+#include <algorithm>
+#include <functional>
+#include <tuple>
 
-auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool 
-{
-    latch_.lock();
-    size_t te=0;
-    frame_id_t frame=1;
-    //不满k次的
-    for(auto it=node_store_.begin();it!=node_store_.end();it++)
-    {
-        if (it->second.get_history_size()<k_ && it->second.is_evictable()==true && current_timestamp_ - it->second.get_front() >te)
-        {
-            te=current_timestamp_ - it->second.get_front();
-            frame=it->first;
-        }
-    }
-    if (te!=0)
-    {
-        *frame_id=frame;
-        node_store_.erase(frame);
-        replacer_size_--;
-        latch_.unlock();
-        return true;
-    }
-    //k次的
-    te=0;
-    for(auto it=node_store_.begin();it!=node_store_.end();it++)
-    {
-        if (it->second.get_history_size()==k_ && it->second.is_evictable()==true && current_timestamp_ - it->second.get_front() > te)
-        {
-            te=current_timestamp_ - it->second.get_front();
-            frame=it->first;
-        }
+namespace bustub {
 
-    }
-    if (te!=0)
-    {
-        *frame_id=frame;
-        node_store_.erase(frame);
-        replacer_size_--;
-        latch_.unlock();
-        return true;
-    }
-    
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : node_store_(num_frames), replacer_size_(num_frames), k_(k) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to look back at least one reference");
+  for (auto &node : node_store_) {
+    node.Init(k_);
+  }
+}
 
-    
-    latch_.unlock();
+auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock lock{latch_};
+  std::set<FrameKey> *frames = inf_distance_frames_.empty() ? &k_distance_frames_ : &inf_distance_frames_;
+  if (frames->empty()) {
     return false;
-
-
+  }
+  *frame_id = frames->begin()->second;
+  frames->erase(frames->begin());
+  node_store_[*frame_id].Clear();
+  return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id) 
-{
-    latch_.lock();
-    auto it=node_store_.find(frame_id);
-    if (it==node_store_.end())
-    {
-
-        bustub::LRUKNode te;
-        node_store_.insert(std::pair<frame_id_t,bustub::LRUKNode>(frame_id,te));
-    }
-    it=node_store_.find(frame_id);
-    it->second.setk(k_);
-    it->second.push(current_timestamp_);
-    current_timestamp_++;
-    latch_.unlock();
-
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < replacer_size_, "Invalid frame id");
+  LRUKNode &node = node_store_[frame_id];
+  if (access_type == AccessType::Scan && node.HistorySize() > 0) {
+    return;
+  }
+  if (node.is_evictable_) {
+    EvictableSet(node)->erase({node.OldestTimestamp(), frame_id});
+  }
+  node.Push(current_timestamp_++);
+  if (node.is_evictable_) {
+    EvictableSet(node)->emplace(node.OldestTimestamp(), frame_id);
+  }
 }
 
-void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) 
-{
-    latch_.lock();
-    auto it=node_store_.find(frame_id);
-    if (set_evictable==true && it->second.is_evictable()==false)
-    {
-        replacer_size_++;
-    }
-    if (set_evictable==false && it->second.is_evictable()==true)
-    {
-        replacer_size_--;
-    }
-    it->second.set_evictab(set_evictable);
-    latch_.unlock();
+void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < replacer_size_, "Invalid frame id");
+  LRUKNode &node = node_store_[frame_id];
+  if (node.HistorySize() == 0 || node.is_evictable_ == set_evictable) {
+    return;
+  }
+  node.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    EvictableSet(node)->emplace(node.OldestTimestamp(), frame_id);
+  } else {
+    EvictableSet(node)->erase({node.OldestTimestamp(), frame_id});
+  }
+}
 
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < replacer_size_, "Invalid frame id");
+  LRUKNode &node = node_store_[frame_id];
+  if (node.HistorySize() == 0) {
+    return;
+  }
+  BUSTUB_ASSERT(node.is_evictable_, "Cannot remove a non-evictable frame");
+  EvictableSet(node)->erase({node.OldestTimestamp(), frame_id});
+  node.Clear();
+}
 
+void LRUKReplacer::SetNumFrames(size_t num_frames) {
+  std::scoped_lock lock{latch_};
+  if (num_frames <= replacer_size_) {
+    return;
+  }
+  node_store_.resize(num_frames);
+  for (size_t i = replacer_size_; i < num_frames; ++i) {
+    node_store_[i].Init(k_);
+  }
+  replacer_size_ = num_frames;
 }
 
-void LRUKReplacer::Remove(frame_id_t frame_id) 
-{
-    latch_.lock();
-    if (node_store_.find(frame_id)->second.is_evictable())
-    {
-        replacer_size_--;
+std::vector<frame_id_t> LRUKReplacer::GetRetentionOrder() {
+  std::scoped_lock lock{latch_};
+  // The reverse of the eviction order: frames with k references before the others, then by oldest timestamp.
+  std::vector<std::tuple<bool, size_t, frame_id_t>> keys;
+  for (size_t i = 0; i < replacer_size_; ++i) {
+    const LRUKNode &node = node_store_[i];
+    if (node.HistorySize() > 0) {
+      keys.emplace_back(node.HistorySize() >= k_, node.OldestTimestamp(), static_cast<frame_id_t>(i));
     }
-    node_store_.erase(frame_id);
-    
-    latch_.unlock();
-
+  }
+  std::sort(keys.begin(), keys.end(), std::greater<>());
+  std::vector<frame_id_t> frame_ids;
+  frame_ids.reserve(keys.size());
+  for (const auto &key : keys) {
+    frame_ids.push_back(std::get<2>(key));
+  }
+  return frame_ids;
 }
 
-auto LRUKReplacer::Size() -> size_t 
-{ 
+auto LRUKReplacer::Size() -> size_t {
+  std::scoped_lock lock{latch_};
+  return inf_distance_frames_.size() + k_distance_frames_.size();
+}
 
-    return replacer_size_;
+std::set<LRUKReplacer::FrameKey> *LRUKReplacer::EvictableSet(const LRUKNode &node) {
+  return node.HistorySize() < k_ ? &inf_distance_frames_ : &k_distance_frames_;
 }
 
 }  // namespace bustub
@@ -12,6 +12,8 @@
 
 #include "buffer/lru_replacer.h"
 
+#include <algorithm>
+
 namespace bustub {
 
 LRUReplacer::LRUReplacer(size_t num_pages) { max_size_ = num_pages; }
@@ -60,6 +62,15 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   lru_hash_[frame_id] = lru_list_.begin();
 }
 
+void LRUReplacer::SetNumFrames(size_t num_frames) {
+  std::scoped_lock lock{mutex_};
+  max_size_ = std::max(max_size_, num_frames);
+}
+
+std::vector<frame_id_t> LRUReplacer::GetRetentionOrder() {
+  std::scoped_lock lock{mutex_};
+  return {lru_list_.begin(), lru_list_.end()};
+}
 
 // 返回replacer中能够victim的数量
 size_t LRUReplacer::Size() {
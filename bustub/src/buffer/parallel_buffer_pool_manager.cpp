@@ -12,46 +12,157 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace bustub {
 
+namespace {
+
+/** Hands every thread that allocates pages a home instance, in the order the threads show up. */
+std::atomic<size_t> next_thread_index{0};
+
+}  // namespace
+
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
                                                      LogManager *log_manager) {
   // Allocate and create individual BufferPoolManagerInstances
   num_instances_ = num_instances;
-  pool_size_ = pool_size;
   next_instance_ = 0;
-  // managers_ = new BufferPoolManager *[static_cast<int>(num_instances)];
   for (size_t i = 0; i < num_instances_; i++) {
     managers_.push_back(new BufferPoolManagerInstance(pool_size, num_instances_, i, disk_manager, log_manager));
-    // BufferPoolManagerInstance *manager =
-    //     new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager);
-    // *(managers_ + i) = manager;
   }
 }
 
 // Update constructor to destruct all BufferPoolManagerInstances and deallocate any associated memory
 ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  read_ahead_.Stop();
   for (size_t i = 0; i < num_instances_; i++) {
     delete managers_[i];
   }
-  // delete[] managers_;
 }
 
 size_t ParallelBufferPoolManager::GetPoolSize() {
   // Get size of all BufferPoolManagerInstances
-  return num_instances_ * pool_size_;
+  size_t pool_size = 0;
+  for (auto *manager : managers_) {
+    pool_size += manager->GetPoolSize();
+  }
+  return pool_size;
 }
 
-BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) 
-{
+bool ParallelBufferPoolManager::Resize(size_t pool_size, std::chrono::milliseconds timeout) {
+  bool resized = true;
+  for (auto *manager : managers_) {
+    resized = manager->Resize(pool_size, timeout) && resized;
+  }
+  return resized;
+}
+
+void ParallelBufferPoolManager::StartPageCleaner(size_t target_clean_frames, double max_dirty_ratio,
+                                                 std::chrono::milliseconds interval) {
+  for (auto *manager : managers_) {
+    manager->StartPageCleaner(target_clean_frames, max_dirty_ratio, interval);
+  }
+}
+
+void ParallelBufferPoolManager::StopPageCleaner() {
+  for (auto *manager : managers_) {
+    manager->StopPageCleaner();
+  }
+}
+
+uint64_t ParallelBufferPoolManager::GetForegroundWriteBacks() {
+  uint64_t write_backs = 0;
+  for (auto *manager : managers_) {
+    write_backs += manager->GetForegroundWriteBacks();
+  }
+  return write_backs;
+}
+
+uint64_t ParallelBufferPoolManager::GetBackgroundWriteBacks() {
+  uint64_t write_backs = 0;
+  for (auto *manager : managers_) {
+    write_backs += manager->GetBackgroundWriteBacks();
+  }
+  return write_backs;
+}
+
+void ParallelBufferPoolManager::PrefetchPages(page_id_t page_id, size_t count, next_page_fn next_page) {
+  read_ahead_.Submit(page_id, count, std::move(next_page));
+}
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetResidentPages() {
+  std::vector<std::vector<page_id_t>> lists;
+  size_t longest = 0;
+  for (auto *manager : managers_) {
+    lists.push_back(manager->GetResidentPages());
+    longest = std::max(longest, lists.back().size());
+  }
+  std::vector<page_id_t> page_ids;
+  for (size_t rank = 0; rank < longest; ++rank) {
+    for (const auto &list : lists) {
+      if (rank < list.size()) {
+        page_ids.push_back(list[rank]);
+      }
+    }
+  }
+  return page_ids;
+}
+
+size_t ParallelBufferPoolManager::LoadPages(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> batches(num_instances_);
+  for (page_id_t page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID) {
+      batches[page_id % num_instances_].push_back(page_id);
+    }
+  }
+  size_t loaded = 0;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    loaded += managers_[i]->LoadPages(batches[i]);
+  }
+  return loaded;
+}
+
+std::vector<BufferPoolMetrics> ParallelBufferPoolManager::GetMetrics() {
+  std::vector<BufferPoolMetrics> metrics;
+  for (auto *manager : managers_) {
+    metrics.push_back(manager->GetMetrics().front());
+  }
+  return metrics;
+}
+
+std::vector<std::pair<page_id_t, lsn_t>> ParallelBufferPoolManager::GetDirtyPages() {
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  for (auto *manager : managers_) {
+    auto instance_dirty_pages = manager->GetDirtyPages();
+    dirty_pages.insert(dirty_pages.end(), instance_dirty_pages.begin(), instance_dirty_pages.end());
+  }
+  return dirty_pages;
+}
+
+size_t ParallelBufferPoolManager::WriteBackPages(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> batches(num_instances_);
+  for (page_id_t page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID) {
+      batches[page_id % num_instances_].push_back(page_id);
+    }
+  }
+  size_t num_written = 0;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    num_written += managers_[i]->WriteBackPages(batches[i]);
+  }
+  return num_written;
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
   // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
   return managers_[page_id % num_instances_];
-  // return *(managers_ + page_id % num_instances_);
 }
 
-Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) {
+Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id, AccessType access_type) {
   // Fetch page for page_id from responsible BufferPoolManagerInstance
-  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, access_type);
 }
 
 bool ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) {
@@ -65,19 +176,11 @@ bool ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) {
 }
 
 Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) {
-  // create new page. We will request page allocation in a round robin manner from the underlying
-  // BufferPoolManagerInstances
-  // 1.   From a starting index of the BPMIs, call NewPageImpl until either 1) success and return 2) looped around to
-  // starting index and return nullptr
-  // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
-  // is called
-  std::scoped_lock lock{latch_};
-  for (size_t i = 0; i < num_instances_; i++) 
-  {
-    // BufferPoolManager *manager = *(managers_ + next_instance_);
-    BufferPoolManager *manager = managers_[next_instance_];
-    Page *page = manager->NewPage(page_id);
-    next_instance_ = (next_instance_ + 1) % num_instances_;
+  // From the instance PickInstance chose, try every instance once until one creates the page.
+  // The instances are independent, so there is no latch here: the cursor is atomic and each instance latches itself.
+  const size_t start = PickInstance();
+  for (size_t i = 0; i < num_instances_; i++) {
+    Page *page = managers_[(start + i) % num_instances_]->NewPage(page_id);
     if (page != nullptr) {
       return page;
     }
@@ -85,6 +188,89 @@ Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) {
   return nullptr;
 }
 
+size_t ParallelBufferPoolManager::PickInstance() {
+  const InstanceSelection selection = selection_;
+  if (selection == InstanceSelection::THREAD_AFFINITY) {
+    thread_local const size_t thread_index = next_thread_index++;
+    const size_t home = thread_index % num_instances_;
+    if (managers_[home]->GetAvailableFrames() > 0) {
+      return home;
+    }
+  }
+  const size_t turn = next_instance_++ % num_instances_;
+  if (selection == InstanceSelection::ROUND_ROBIN) {
+    return turn;
+  }
+  // Two choices instead of all of them: nearly as even, and only two instances are looked at.
+  const size_t other = (turn + 1) % num_instances_;
+  return managers_[other]->GetAvailableFrames() > managers_[turn]->GetAvailableFrames() ? other : turn;
+}
+
+page_id_t ParallelBufferPoolManager::ReservePageIds(size_t count) {
+  std::scoped_lock lock{latch_};
+  return ReservePageIdsLocked(count);
+}
+
+page_id_t ParallelBufferPoolManager::SkipPageIds(page_id_t end) {
+  std::scoped_lock lock{latch_};
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  for (auto *manager : managers_) {
+    const page_id_t skipped = manager->SkipPageIds(end);
+    next_page_id = next_page_id == INVALID_PAGE_ID ? skipped : std::min(next_page_id, skipped);
+  }
+  return next_page_id;
+}
+
+page_id_t ParallelBufferPoolManager::ReservePageIdsLocked(size_t count) {
+  // With the page ids of every instance locked, none can hand out an id of the range between picking and skipping it.
+  std::vector<std::unique_lock<MeasuredMutex>> locks;
+  locks.reserve(num_instances_);
+  page_id_t start = 0;
+  for (auto *manager : managers_) {
+    locks.push_back(manager->LockPageIds());
+    start = std::max(start, manager->GetNextPageId());
+  }
+  for (auto *manager : managers_) {
+    manager->SkipPageIdsLocked(start + static_cast<page_id_t>(count));
+  }
+  return start;
+}
+
+Page *ParallelBufferPoolManager::NewPgInExtentImp(page_id_t *page_id, Extent *extent) {
+  page_id_t extent_page_id;
+  {
+    std::scoped_lock extent_lock{extent->latch_};
+    if (extent->next_page_id_ == extent->end_page_id_) {
+      std::scoped_lock lock{latch_};
+      extent->next_page_id_ = ReservePageIdsLocked(EXTENT_SIZE);
+      extent->end_page_id_ = extent->next_page_id_ + EXTENT_SIZE;
+    }
+    extent_page_id = extent->next_page_id_++;
+  }
+  // The page is created without any latch of this manager, out of a one page extent of the instance owning its id.
+  BufferPoolManager *manager = GetBufferPoolManager(extent_page_id);
+  Extent page_extent{extent_page_id, extent_page_id + 1};
+  Page *page = manager->NewPageInExtent(page_id, &page_extent);
+  if (page == nullptr) {
+    // The id goes back to the extent if no other page was taken from it since, to the free pages otherwise.
+    std::scoped_lock extent_lock{extent->latch_};
+    if (extent->next_page_id_ == extent_page_id + 1) {
+      extent->next_page_id_--;
+    } else {
+      manager->DeletePage(extent_page_id);
+    }
+  }
+  return page;
+}
+
+void ParallelBufferPoolManager::ReleaseExtent(Extent *extent) {
+  std::scoped_lock extent_lock{extent->latch_};
+  for (; extent->next_page_id_ < extent->end_page_id_; extent->next_page_id_++) {
+    Extent page_extent{extent->next_page_id_, extent->next_page_id_ + 1};
+    GetBufferPoolManager(extent->next_page_id_)->ReleaseExtent(&page_extent);
+  }
+}
+
 bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
   // Delete page_id from responsible BufferPoolManagerInstance
   return GetBufferPoolManager(page_id)->DeletePage(page_id);
@@ -93,9 +279,7 @@ bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
 void ParallelBufferPoolManager::FlushAllPgsImp() {
   // flush all pages from all BufferPoolManagerInstances
   for (size_t i = 0; i < num_instances_; i++) {
-    // BufferPoolManager *manager = *(managers_ + i);
-    // manager->FlushAllPages();
-    delete managers_[i];
+    managers_[i]->FlushAllPages();
   }
 }
 
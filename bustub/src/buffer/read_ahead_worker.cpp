@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_worker.cpp
+//
+// Identification: src/buffer/read_ahead_worker.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/read_ahead_worker.h"
+
+#include <utility>
+
+namespace bustub {
+
+void ReadAheadWorker::Submit(page_id_t page_id, size_t count, BufferPoolManager::next_page_fn next_page) {
+  if (page_id == INVALID_PAGE_ID || count == 0) {
+    return;
+  }
+  {
+    std::scoped_lock lock{latch_};
+    if (stop_ || queue_.size() >= MAX_PENDING_REQUESTS) {
+      return;
+    }
+    queue_.push_back(Request{page_id, count, std::move(next_page)});
+    if (!thread_.joinable()) {
+      thread_ = std::thread(&ReadAheadWorker::Run, this);
+    }
+  }
+  cv_.notify_one();
+}
+
+void ReadAheadWorker::Stop() {
+  {
+    std::scoped_lock lock{latch_};
+    stop_ = true;
+    queue_.clear();
+  }
+  cv_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void ReadAheadWorker::Run() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+    if (stop_) {
+      return;
+    }
+    Request request = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    ReadChain(request);
+    lock.lock();
+  }
+}
+
+void ReadAheadWorker::ReadChain(const Request &request) {
+  page_id_t page_id = request.page_id_;
+  for (size_t i = 0; i < request.count_ && page_id != INVALID_PAGE_ID; ++i) {
+    {
+      std::scoped_lock lock{latch_};
+      if (stop_) {
+        return;
+      }
+    }
+    Page *page = buffer_pool_manager_->FetchPage(page_id, AccessType::Scan);
+    if (page == nullptr) {
+      // Every frame is pinned, reading further ahead would only evict pages the requester still needs.
+      return;
+    }
+    page->RLatch();
+    page_id_t next_page_id = request.next_page_(page);
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    prefetched_pages_++;
+    page_id = next_page_id;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,40 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer.cpp
+//
+// Identification: src/buffer/replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/replacer.h"
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/two_q_replacer.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+std::unique_ptr<Replacer> MakeReplacer(ReplacerPolicy policy, size_t num_frames, size_t k) {
+  switch (policy) {
+    case ReplacerPolicy::LRU:
+      return std::make_unique<LRUReplacer>(num_frames);
+    case ReplacerPolicy::LRU_K:
+      return std::make_unique<LRUKReplacer>(num_frames, k);
+    case ReplacerPolicy::TWO_Q:
+      return std::make_unique<TwoQReplacer>(num_frames);
+    case ReplacerPolicy::ARC:
+      return std::make_unique<ArcReplacer>(num_frames);
+    case ReplacerPolicy::CLOCK:
+      return std::make_unique<ClockReplacer>(num_frames);
+  }
+  UNREACHABLE("Unknown replacement policy");
+}
+
+}  // namespace bustub
@@ -0,0 +1,166 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.cpp
+//
+// Identification: src/buffer/two_q_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_q_replacer.h"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+namespace bustub {
+
+TwoQReplacer::TwoQReplacer(size_t num_frames) : nodes_(num_frames), num_frames_(num_frames) { SetShares(); }
+
+bool TwoQReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock{latch_};
+  std::set<FrameKey> *frames = &a1in_frames_;
+  if (a1in_frames_.empty() || (a1in_size_ <= kin_ && !am_frames_.empty())) {
+    frames = &am_frames_;
+  }
+  if (frames->empty()) {
+    return false;
+  }
+  *frame_id = frames->begin()->second;
+  const FrameNode &node = nodes_[*frame_id];
+  if (node.queue_ == Queue::A1IN) {
+    a1out_.PushFront(node.page_id_);
+    while (a1out_.Size() > kout_) {
+      a1out_.PopBack();
+    }
+  }
+  Untrack(*frame_id);
+  return true;
+}
+
+void TwoQReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  FrameNode &node = nodes_[frame_id];
+  if (node.queue_ == Queue::NONE || !node.is_evictable_) {
+    return;
+  }
+  EvictableSet(node.queue_)->erase({node.seq_, frame_id});
+  node.is_evictable_ = false;
+}
+
+void TwoQReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  FrameNode &node = nodes_[frame_id];
+  if (node.queue_ == Queue::NONE || node.is_evictable_) {
+    return;
+  }
+  EvictableSet(node.queue_)->emplace(node.seq_, frame_id);
+  node.is_evictable_ = true;
+}
+
+void TwoQReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  FrameNode &node = nodes_[frame_id];
+  if (node.queue_ == Queue::NONE) {
+    // A hit on a frame that was handed out as a victim but kept its page.
+    Track(frame_id, Queue::A1IN, false);
+  } else if (node.queue_ == Queue::AM && access_type != AccessType::Scan) {
+    const bool is_evictable = node.is_evictable_;
+    Untrack(frame_id);
+    Track(frame_id, Queue::AM, is_evictable);
+  }
+  // Hits in A1in are not recorded: they are most likely correlated references of the access that read the page in.
+}
+
+void TwoQReplacer::RecordLoad(frame_id_t frame_id, page_id_t page_id, AccessType access_type) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  if (nodes_[frame_id].queue_ != Queue::NONE) {
+    Untrack(frame_id);
+  }
+  const bool reloaded = a1out_.Erase(page_id);
+  Track(frame_id, reloaded && access_type != AccessType::Scan ? Queue::AM : Queue::A1IN, false);
+  nodes_[frame_id].page_id_ = page_id;
+}
+
+void TwoQReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  if (nodes_[frame_id].queue_ != Queue::NONE) {
+    Untrack(frame_id);
+  }
+  nodes_[frame_id].page_id_ = INVALID_PAGE_ID;
+}
+
+void TwoQReplacer::SetNumFrames(size_t num_frames) {
+  std::scoped_lock lock{latch_};
+  if (num_frames <= num_frames_) {
+    return;
+  }
+  nodes_.resize(num_frames);
+  num_frames_ = num_frames;
+  SetShares();
+}
+
+std::vector<frame_id_t> TwoQReplacer::GetRetentionOrder() {
+  std::scoped_lock lock{latch_};
+  // Am before A1in, the most recently promoted first within each.
+  std::vector<std::tuple<bool, size_t, frame_id_t>> keys;
+  for (size_t i = 0; i < num_frames_; ++i) {
+    const FrameNode &node = nodes_[i];
+    if (node.queue_ != Queue::NONE) {
+      keys.emplace_back(node.queue_ == Queue::AM, node.seq_, static_cast<frame_id_t>(i));
+    }
+  }
+  std::sort(keys.begin(), keys.end(), std::greater<>());
+  std::vector<frame_id_t> frame_ids;
+  frame_ids.reserve(keys.size());
+  for (const auto &key : keys) {
+    frame_ids.push_back(std::get<2>(key));
+  }
+  return frame_ids;
+}
+
+size_t TwoQReplacer::Size() {
+  std::scoped_lock lock{latch_};
+  return a1in_frames_.size() + am_frames_.size();
+}
+
+void TwoQReplacer::Track(frame_id_t frame_id, Queue queue, bool is_evictable) {
+  FrameNode &node = nodes_[frame_id];
+  node.queue_ = queue;
+  node.seq_ = next_seq_++;
+  node.is_evictable_ = is_evictable;
+  if (is_evictable) {
+    EvictableSet(queue)->emplace(node.seq_, frame_id);
+  }
+  if (queue == Queue::A1IN) {
+    a1in_size_++;
+  }
+}
+
+void TwoQReplacer::Untrack(frame_id_t frame_id) {
+  FrameNode &node = nodes_[frame_id];
+  if (node.is_evictable_) {
+    EvictableSet(node.queue_)->erase({node.seq_, frame_id});
+  }
+  if (node.queue_ == Queue::A1IN) {
+    a1in_size_--;
+  }
+  node.queue_ = Queue::NONE;
+  node.is_evictable_ = false;
+}
+
+void TwoQReplacer::SetShares() {
+  // The shares the 2Q paper recommends: 25% of the frames for A1in, ghosts for 50% of them in A1out.
+  kin_ = std::max<size_t>(num_frames_ / 4, 1);
+  kout_ = std::max<size_t>(num_frames_ / 2, 1);
+}
+
+}  // namespace bustub
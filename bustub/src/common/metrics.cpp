@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics.cpp
+//
+// Identification: src/common/metrics.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace bustub {
+
+size_t GetMetricShard() {
+  static std::atomic<size_t> next_shard{0};
+  thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % NUM_METRIC_SHARDS;
+  return shard;
+}
+
+uint64_t ShardedCounter::Get() const {
+  uint64_t value = 0;
+  for (const Shard &shard : shards_) {
+    value += shard.value_.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds latency) {
+  const auto ns = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+  // The bucket is the bit width of the latency: 0 for 0ns, i for [2^(i-1), 2^i) ns.
+  const auto width = static_cast<size_t>(ns == 0 ? 0 : 64 - __builtin_clzll(ns));
+  Shard &shard = shards_[GetMetricShard()];
+  shard.buckets_[std::min(width, HistogramSnapshot::NUM_BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+  shard.sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+}
+
+HistogramSnapshot LatencyHistogram::GetSnapshot() const {
+  HistogramSnapshot snapshot;
+  for (const Shard &shard : shards_) {
+    for (size_t i = 0; i < HistogramSnapshot::NUM_BUCKETS; ++i) {
+      const uint64_t count = shard.buckets_[i].load(std::memory_order_relaxed);
+      snapshot.buckets_[i] += count;
+      snapshot.count_ += count;
+    }
+    snapshot.sum_ns_ += shard.sum_ns_.load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+void HistogramSnapshot::Merge(const HistogramSnapshot &other) {
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_ns_ += other.sum_ns_;
+}
+
+double HistogramSnapshot::GetMeanNs() const {
+  return count_ == 0 ? 0 : static_cast<double>(sum_ns_) / static_cast<double>(count_);
+}
+
+uint64_t HistogramSnapshot::GetPercentileNs(double fraction) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  // The rank of the latency in sorted order, at least 1 so that the 0th percentile is the lowest bucket in use.
+  const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count_))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return i == 0 ? 0 : (uint64_t{1} << i) - 1;
+    }
+  }
+  return (uint64_t{1} << (NUM_BUCKETS - 1)) - 1;
+}
+
+std::string HistogramSnapshot::ToString() const {
+  char line[160];
+  snprintf(line, sizeof(line), "count=%llu mean=%.2fus p50<=%.2fus p99<=%.2fus p99.9<=%.2fus max<=%.2fus",
+           static_cast<unsigned long long>(count_), GetMeanNs() / 1e3,  // NOLINT
+           static_cast<double>(GetPercentileNs(0.5)) / 1e3, static_cast<double>(GetPercentileNs(0.99)) / 1e3,
+           static_cast<double>(GetPercentileNs(0.999)) / 1e3, static_cast<double>(GetPercentileNs(1)) / 1e3);
+  return line;
+}
+
+}  // namespace bustub
@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_util.cpp
+//
+// Identification: src/common/util/lz_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz_util.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+/** Shortest match worth encoding. */
+constexpr size_t MIN_MATCH = 4;
+/** Largest offset a match can reach back. */
+constexpr size_t MAX_OFFSET = 65535;
+/** log2 of the number of hash table entries. */
+constexpr int HASH_BITS = 12;
+
+uint32_t Load32(const char *p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Appends bytes to the output, failing once capacity is exceeded. */
+class BlockWriter {
+ public:
+  BlockWriter(char *dst, size_t capacity) : dst_(dst), capacity_(capacity) {}
+
+  bool Byte(uint8_t byte) {
+    if (pos_ == capacity_) {
+      return false;
+    }
+    dst_[pos_++] = static_cast<char>(byte);
+    return true;
+  }
+
+  bool Bytes(const char *src, size_t size) {
+    if (capacity_ - pos_ < size) {
+      return false;
+    }
+    std::memcpy(dst_ + pos_, src, size);
+    pos_ += size;
+    return true;
+  }
+
+  /** Write the part of a length that did not fit in its nibble. */
+  bool ExtraLength(size_t length) {
+    for (; length >= 255; length -= 255) {
+      if (!Byte(255)) {
+        return false;
+      }
+    }
+    return Byte(static_cast<uint8_t>(length));
+  }
+
+  /** Write one sequence; match_length is 0 for the last one. */
+  bool Sequence(const char *literals, size_t num_literals, size_t offset, size_t match_length) {
+    const size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+    const auto token = static_cast<uint8_t>(((num_literals < 15 ? num_literals : 15) << 4) |
+                                            (match_code < 15 ? match_code : 15));
+    if (!Byte(token) || (num_literals >= 15 && !ExtraLength(num_literals - 15)) || !Bytes(literals, num_literals)) {
+      return false;
+    }
+    if (match_length == 0) {
+      return true;
+    }
+    return Byte(static_cast<uint8_t>(offset & 0xff)) && Byte(static_cast<uint8_t>(offset >> 8)) &&
+           (match_code < 15 || ExtraLength(match_code - 15));
+  }
+
+  size_t Size() const { return pos_; }
+
+ private:
+  char *dst_;
+  size_t capacity_;
+  size_t pos_{0};
+};
+
+/** Reads a length continued past its nibble. */
+bool ReadLength(const uint8_t *src, size_t size, size_t *pos, size_t *length) {
+  if (*length != 15) {
+    return true;
+  }
+  while (*pos < size) {
+    const uint8_t byte = src[(*pos)++];
+    *length += byte;
+    if (byte != 255) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+size_t LZUtil::Compress(const char *src, size_t size, char *dst, size_t capacity) {
+  // Positions plus one, so that 0 means empty.
+  uint32_t table[1 << HASH_BITS] = {0};
+  BlockWriter writer(dst, capacity);
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= size) {
+    const uint32_t sequence = Load32(src + pos);
+    uint32_t &entry = table[Hash(sequence)];
+    const size_t candidate = entry;
+    entry = static_cast<uint32_t>(pos + 1);
+    if (candidate == 0 || pos + 1 - candidate > MAX_OFFSET || Load32(src + candidate - 1) != sequence) {
+      pos++;
+      continue;
+    }
+    const size_t match = candidate - 1;
+    size_t length = MIN_MATCH;
+    while (pos + length < size && src[match + length] == src[pos + length]) {
+      length++;
+    }
+    if (!writer.Sequence(src + anchor, pos - anchor, pos - match, length)) {
+      return 0;
+    }
+    pos += length;
+    anchor = pos;
+  }
+  if (!writer.Sequence(src + anchor, size - anchor, 0, 0)) {
+    return 0;
+  }
+  return writer.Size();
+}
+
+size_t LZUtil::Decompress(const char *src, size_t size, char *dst, size_t capacity) {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  size_t in_pos = 0;
+  size_t out_pos = 0;
+  while (in_pos < size) {
+    const uint8_t token = in[in_pos++];
+    size_t num_literals = token >> 4;
+    if (!ReadLength(in, size, &in_pos, &num_literals) || size - in_pos < num_literals ||
+        capacity - out_pos < num_literals) {
+      return 0;
+    }
+    std::memcpy(dst + out_pos, src + in_pos, num_literals);
+    in_pos += num_literals;
+    out_pos += num_literals;
+    if (in_pos == size) {
+      // The last sequence has no match.
+      break;
+    }
+    if (size - in_pos < 2) {
+      return 0;
+    }
+    const size_t offset = in[in_pos] | (static_cast<size_t>(in[in_pos + 1]) << 8);
+    in_pos += 2;
+    size_t length = token & 0xf;
+    if (!ReadLength(in, size, &in_pos, &length)) {
+      return 0;
+    }
+    length += MIN_MATCH;
+    if (offset == 0 || offset > out_pos || capacity - out_pos < length) {
+      return 0;
+    }
+    if (offset >= length) {
+      std::memcpy(dst + out_pos, dst + out_pos - offset, length);
+      out_pos += length;
+    } else {
+      // Byte by byte: the match overlaps the bytes it produces.
+      for (size_t i = 0; i < length; ++i, ++out_pos) {
+        dst[out_pos] = dst[out_pos - offset];
+      }
+    }
+  }
+  return out_pos;
+}
+
+}  // namespace bustub
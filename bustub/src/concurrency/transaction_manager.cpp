@@ -14,6 +14,8 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "catalog/catalog.h"
 #include "storage/table/table_heap.h"
@@ -29,7 +31,15 @@ Transaction *TransactionManager::Begin(Transaction *txn, IsolationLevel isolatio
 
   if (txn == nullptr) {
     txn = new Transaction(next_txn_id_++, isolation_level);
+    txn->SetAsyncCommit(async_commit_);
   }
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
+    std::scoped_lock lock(active_txns_latch_);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+    active_txns_[txn->GetTransactionId()] = txn->GetPrevLSN();
+  }
+
   txn_map_mutex.lock();
   txn_map[txn->GetTransactionId()] = txn;
   txn_map_mutex.unlock();
@@ -52,10 +62,30 @@ void TransactionManager::Commit(Transaction *txn) {
   }
   write_set->clear();
 
+  lsn_t commit_lsn = INVALID_LSN;
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    commit_lsn = log_manager_->AppendLogRecord(&log_record);
+    txn->SetPrevLSN(commit_lsn);
+    std::scoped_lock lock(active_txns_latch_);
+    active_txns_.erase(txn->GetTransactionId());
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
   global_txn_latch_.RUnlock();
+
+  // Only the commit has to wait for its log record to be durable, not the transactions waiting for its locks: theirs
+  // come later in the log, so they cannot be durable first. Waiting here lets the commits of all the transactions that
+  // get this far during one log write share the next one.
+  if (commit_lsn != INVALID_LSN) {
+    if (txn->IsAsyncCommit()) {
+      log_manager_->FlushWithinLag(commit_lsn);
+    } else {
+      log_manager_->FlushUntil(commit_lsn);
+    }
+  }
 }
 
 void TransactionManager::Abort(Transaction *txn) {
@@ -104,6 +134,13 @@ void TransactionManager::Abort(Transaction *txn) {
   table_write_set->clear();
   index_write_set->clear();
 
+  if (enable_logging && log_manager_ != nullptr) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+    std::scoped_lock lock(active_txns_latch_);
+    active_txns_.erase(txn->GetTransactionId());
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
@@ -114,4 +151,9 @@ void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
 
 void TransactionManager::ResumeTransactions() { global_txn_latch_.WUnlock(); }
 
+std::vector<std::pair<txn_id_t, lsn_t>> TransactionManager::GetActiveTransactions() {
+  std::scoped_lock lock(active_txns_latch_);
+  return {active_txns_.begin(), active_txns_.end()};
+}
+
 }  // namespace bustub
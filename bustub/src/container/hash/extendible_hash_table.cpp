@@ -38,6 +38,9 @@ HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager
   // }
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_TYPE::~ExtendibleHashTable() { buffer_pool_manager_->ReleaseExtent(&extent_); }
+
 /*****************************************************************************
  * HELPERS
  *****************************************************************************/
@@ -99,7 +102,7 @@ HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage()
   if (directory_page_id_ == INVALID_PAGE_ID)
   {
     page_id_t new_direpageid;
-    Page *new_direpage=buffer_pool_manager_->NewPage(&new_direpageid);
+    Page *new_direpage=buffer_pool_manager_->NewPageInExtent(&new_direpageid, &extent_);
 
     temp=reinterpret_cast<HashTableDirectoryPage *>(new_direpage->GetData());
 
@@ -107,7 +110,7 @@ HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage()
     temp->SetPageId(directory_page_id_);
 
     page_id_t new_buckpageid;
-    Page *new_buckpage=buffer_pool_manager_->NewPage(&new_buckpageid);
+    Page *new_buckpage=buffer_pool_manager_->NewPageInExtent(&new_buckpageid, &extent_);
     assert(new_buckpage != nullptr);
 
     temp->SetBucketPageId(0,new_buckpageid);
@@ -243,7 +246,7 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
 
   // 创建一个image bucket，并初始化该image bucket
   page_id_t image_bucket_page_id;
-  Page *image_bucket_page = buffer_pool_manager_->NewPage(&image_bucket_page_id);
+  Page *image_bucket_page = buffer_pool_manager_->NewPageInExtent(&image_bucket_page_id, &extent_);
   assert(image_bucket_page != nullptr);
   image_bucket_page->WLatch();
   HASH_TABLE_BUCKET_TYPE *image_bucket = GetBucketPageData(image_bucket_page);
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/ghost_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ArcReplacer implements the Adaptive Replacement Cache policy (Megiddo and Modha, FAST '03).
+ *
+ * Resident frames are split between T1, pages referenced once since they were read in, and T2, pages referenced
+ * again; both are LRU. Pages evicted from T1 and T2 leave their ids in the ghost lists B1 and B2. A page read back in
+ * while its id is in B1 shows that T1 is too small, one in B2 that T2 is, and the target size p of T1 moves towards
+ * the list that missed; the page enters T2 either way. Victims come from T1 while it is larger than p, from T2
+ * otherwise.
+ *
+ * The buffer pool asks for a victim before it knows which page comes in, so unlike the paper p is adapted when the
+ * page is loaded rather than just before the victim is chosen. Scan accesses never promote a page to T2.
+ */
+class ArcReplacer : public Replacer {
+ public:
+  /**
+   * Create a new ArcReplacer.
+   * @param num_frames the maximum number of frames the ArcReplacer will be required to store
+   */
+  explicit ArcReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ArcReplacer);
+
+  ~ArcReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
+
+  void RecordLoad(frame_id_t frame_id, page_id_t page_id, AccessType access_type = AccessType::Unknown) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void SetNumFrames(size_t num_frames) override;
+
+  std::vector<frame_id_t> GetRetentionOrder() override;
+
+  size_t Size() override;
+
+  /** @return the current target size of T1 */
+  size_t GetTarget();
+
+ private:
+  enum class Queue : uint8_t { NONE, T1, T2 };
+
+  /** State of one frame. The page id outlives an eviction, so that a victim that is hit again keeps it. */
+  struct FrameNode {
+    Queue queue_{Queue::NONE};
+    size_t seq_{0};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    bool is_evictable_{false};
+  };
+
+  /** Ordering key of an evictable frame: the sequence number of its last promotion, then the frame id. */
+  using FrameKey = std::pair<size_t, frame_id_t>;
+
+  /** Put an untracked frame at the most recent end of a list, keeping its evictable state. Needs latch_ held. */
+  void Track(frame_id_t frame_id, Queue queue, bool is_evictable);
+
+  /** Take a tracked frame out of its list. Must be called with latch_ held. */
+  void Untrack(frame_id_t frame_id);
+
+  /** @return the evictable frames of a list */
+  std::set<FrameKey> *EvictableSet(Queue queue) { return queue == Queue::T1 ? &t1_frames_ : &t2_frames_; }
+
+  std::vector<FrameNode> nodes_;
+  /** Evictable frames of T1 and T2, least recently used first. */
+  std::set<FrameKey> t1_frames_;
+  std::set<FrameKey> t2_frames_;
+  /** Number of frames in T1 and T2, pinned or not. */
+  size_t t1_size_{0};
+  size_t t2_size_{0};
+  /** Ids of pages recently evicted from T1 and T2. */
+  GhostList b1_;
+  GhostList b2_;
+  /** Target size of T1, between 0 and num_frames_. */
+  size_t p_{0};
+  size_t num_frames_;
+  size_t next_seq_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
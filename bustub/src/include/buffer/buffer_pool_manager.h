@@ -12,17 +12,68 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
 #include <mutex>  // NOLINT
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/lru_replacer.h"
+#include "common/metrics.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+/** Number of contiguous pages reserved at a time for one table heap or index. */
+static constexpr int EXTENT_SIZE = 64;
+
+/**
+ * A run of contiguous page ids reserved for one table heap or index. NewPageInExtent hands its pages out in order, so
+ * that the pages of the object sit next to each other on disk and a scan of it reads the file sequentially. It is
+ * only modified by the buffer pool manager: a BufferPoolManagerInstance under its own latch, a
+ * ParallelBufferPoolManager under latch_ of the extent, so that creating pages of different objects does not
+ * serialize.
+ */
+struct Extent {
+  /** the next page id to hand out */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  /** one past the last page id of the extent */
+  page_id_t end_page_id_{INVALID_PAGE_ID};
+  /** protects the page ids when they are handed out by a ParallelBufferPoolManager */
+  std::mutex latch_{};
+};
+
+/** A snapshot of the metrics of one buffer pool instance, see BufferPoolManager::GetMetrics. */
+struct BufferPoolMetrics {
+  /** Fetches that found their page in the pool. */
+  uint64_t hits_{0};
+  /** Fetches that read their page from the compressed cache or disk. */
+  uint64_t misses_{0};
+  /** Pages evicted to make room for another one. */
+  uint64_t evictions_{0};
+  /** Dirty victims written back by the fetch or new page that evicted them. */
+  uint64_t foreground_write_backs_{0};
+  /** Dirty pages written back ahead of eviction by the page cleaner. */
+  uint64_t background_write_backs_{0};
+  /** Fetches that found their page resident but had to wait for it to be read in, or for its write-back on eviction. */
+  uint64_t pin_waits_{0};
+  /** How long the instance latch was held, each time it was taken. */
+  HistogramSnapshot latch_hold_;
+
+  /** @return the metrics on one line */
+  std::string ToString() const {
+    return "hits=" + std::to_string(hits_) + " misses=" + std::to_string(misses_) +
+           " evictions=" + std::to_string(evictions_) +
+           " foreground_write_backs=" + std::to_string(foreground_write_backs_) +
+           " background_write_backs=" + std::to_string(background_write_backs_) +
+           " pin_waits=" + std::to_string(pin_waits_) + " latch_hold: " + latch_hold_.ToString();
+  }
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -30,6 +81,8 @@ class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Reads the id of the page that follows a page in a page chain, INVALID_PAGE_ID at the end of the chain. */
+  using next_page_fn = std::function<page_id_t(Page *page)>;
 
   BufferPoolManager() = default;
   /**
@@ -39,8 +92,16 @@ class BufferPoolManager {
 
   /** Grading function. Do not modify! */
   Page *FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
+    return FetchPage(page_id, AccessType::Unknown, callback);
+  }
+
+  /**
+   * Fetch a page, telling the replacement policy how it is accessed. Sequential scans pass AccessType::Scan so that
+   * the pages they stream through do not push the hot pages out of the pool.
+   */
+  Page *FetchPage(page_id_t page_id, AccessType access_type, bufferpool_callback_fn callback = nullptr) {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
-    auto *result = FetchPgImp(page_id);
+    auto *result = FetchPgImp(page_id, access_type);
     GradingCallback(callback, CallbackType::AFTER, page_id);
     return result;
   }
@@ -69,6 +130,19 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Creates a new page out of an extent owned by the caller, reserving a new extent of EXTENT_SIZE pages when the
+   * current one is used up or was never reserved.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the table heap or index the page belongs to
+   */
+  Page *NewPageInExtent(page_id_t *page_id, Extent *extent, bufferpool_callback_fn callback = nullptr) {
+    GradingCallback(callback, CallbackType::BEFORE, INVALID_PAGE_ID);
+    auto *result = NewPgInExtentImp(page_id, extent);
+    GradingCallback(callback, CallbackType::AFTER, *page_id);
+    return result;
+  }
+
   /** Grading function. Do not modify! */
   bool DeletePage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -87,6 +161,85 @@ class BufferPoolManager {
   /** @return size of the buffer pool */
   virtual size_t GetPoolSize() = 0;
 
+  /**
+   * Asynchronously read up to count pages of a page chain into the buffer pool, starting at page_id. The pages are
+   * left unpinned, so that a later FetchPage finds them resident instead of waiting for the disk. This is only a hint,
+   * managers without read-ahead ignore it.
+   * @param page_id the first page to read ahead
+   * @param count the number of pages to read ahead
+   * @param next_page reads the id of the following page out of a page, called with the page read-latched
+   */
+  virtual void PrefetchPages(page_id_t page_id, size_t count, next_page_fn next_page) {}
+
+  /**
+   * Reserve a run of contiguous page ids that this manager will never hand out itself, for another buffer pool on the
+   * same disk manager, e.g. a partition of the catalog.
+   * @param count the number of page ids to reserve
+   * @return the first reserved page id, INVALID_PAGE_ID if this manager cannot reserve page ids
+   */
+  virtual page_id_t ReservePageIds(size_t count) { return INVALID_PAGE_ID; }
+
+  /**
+   * Never hand out page ids below end, e.g. those of the pages recovery found in the log, which need not be in the db
+   * file. Managers that cannot skip page ids ignore this.
+   * @param end one past the last page id not to hand out
+   * @return the id that would have been handed out next before skipping, INVALID_PAGE_ID if unknown
+   */
+  virtual page_id_t SkipPageIds(page_id_t end) { return INVALID_PAGE_ID; }
+
+  /**
+   * Free the page ids an extent has not handed out yet, once its table heap or index goes away, so that they are
+   * reused instead of lost. Managers without extents ignore this.
+   * @param extent the extent to release, it is used up afterwards
+   */
+  virtual void ReleaseExtent(Extent *extent) {}
+
+  /**
+   * List the resident pages, e.g. to save the working set across a restart, see BufferPoolWarmer. Managers that cannot
+   * list them return none.
+   * @return the ids of the resident pages, the ones the replacement policy would keep longest first
+   */
+  virtual std::vector<page_id_t> GetResidentPages() { return {}; }
+
+  /**
+   * Read pages into free frames and leave them unpinned, with one disk submission for all of them. Pages already
+   * resident are skipped, and no page is evicted to make room: once the free frames run out the rest are skipped too.
+   * Managers that cannot load pages in bulk ignore this.
+   * @param page_ids the pages to read, in the order they should be read
+   * @return the number of pages read
+   */
+  virtual size_t LoadPages(const std::vector<page_id_t> &page_ids) { return 0; }
+
+  /**
+   * Take a snapshot of the metrics. They are kept per instance, with counters cheap enough to stay on at all times.
+   * Managers without metrics return none.
+   * @return the metrics of every instance, in instance order
+   */
+  virtual std::vector<BufferPoolMetrics> GetMetrics() { return {}; }
+
+  /**
+   * List the dirty page table of a checkpoint: every page whose changes may not all be on disk, with its recLSN, an
+   * LSN at or before the first log record of a change the disk may miss. Changes of pages that are not listed, and
+   * changes logged before the recLSN of a page, are on disk once DiskManager::SyncPages returns. Managers that do not
+   * track recLSNs list none, and must be flushed instead.
+   * @return the dirty pages and their recLSNs
+   */
+  virtual std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPages() { return {}; }
+
+  /**
+   * Write back some pages, e.g. those of a checkpoint's dirty page table. Pages that are not resident are skipped,
+   * and so are clean ones by managers that track them.
+   * @param page_ids the pages to write back
+   * @return the number of pages written
+   */
+  virtual size_t WriteBackPages(const std::vector<page_id_t> &page_ids) {
+    size_t num_written = 0;
+    for (page_id_t page_id : page_ids) {
+      num_written += FlushPage(page_id) ? 1 : 0;
+    }
+    return num_written;
+  }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -104,9 +257,10 @@ class BufferPoolManager {
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
+   * @param access_type how the page is accessed, a hint for the replacement policy
    * @return the requested page
    */
-  virtual Page *FetchPgImp(page_id_t page_id) = 0;
+  virtual Page *FetchPgImp(page_id_t page_id, AccessType access_type) = 0;
 
   /**
    * Unpin the target page from the buffer pool.
@@ -130,6 +284,14 @@ class BufferPoolManager {
    */
   virtual Page *NewPgImp(page_id_t *page_id) = 0;
 
+  /**
+   * Creates a new page out of an extent. Managers that do not reserve extents create an ordinary new page.
+   * @param[out] page_id id of created page
+   * @param extent the extent to take the page id from
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPgInExtentImp(page_id_t *page_id, Extent *extent) { return NewPgImp(page_id); }
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -12,12 +12,22 @@
 
 #pragma once
 
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/read_ahead_worker.h"
+#include "buffer/replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -34,8 +44,13 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy
+   * @param replacer_k the number of references the LRU-K replacement policy looks back at, 1 for plain LRU
+   * @param huge_pages whether to back the frames with transparent huge pages, see FrameArena
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K, size_t replacer_k = REPLACER_K,
+                            bool huge_pages = false);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +58,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy
+   * @param replacer_k the number of references the LRU-K replacement policy looks back at, 1 for plain LRU
+   * @param huge_pages whether to back the frames with transparent huge pages, see FrameArena
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K, size_t replacer_k = REPLACER_K,
+                            bool huge_pages = false);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -55,16 +75,148 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override { return pool_size_; }
 
-  /** @return pointer to all the pages in the buffer pool */
-  Page *GetPages() { return pages_; }
+  /** @return pointer to the pages of the first FRAME_CHUNK_SIZE frames, which are contiguous */
+  Page *GetPages() { return GetFrame(0); }
+
+  /** @return the arena holding the data of the frames */
+  const FrameArena &GetFrameArena() const { return frame_arena_; }
+
+  /**
+   * Grow or shrink the buffer pool while it is in use. Frames leaving the pool are drained first: their pages are
+   * written back if dirty and evicted, waiting up to timeout for the ones still pinned. The page memory of every chunk
+   * of frames that leaves the pool is freed.
+   * @param pool_size the new number of frames, at least 1
+   * @param timeout how long to wait for pinned pages when shrinking
+   * @return false if shrinking timed out; the pool then keeps its old size
+   */
+  bool Resize(size_t pool_size, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+
+  /**
+   * Start the background page cleaner. It writes back dirty, unpinned pages ahead of eviction, so that NewPage and
+   * FetchPage find clean victims instead of paying for a synchronous write-back.
+   * @param target_clean_frames number of clean frames (free, or unpinned and not dirty) the cleaner tries to keep
+   * @param max_dirty_ratio fraction of the pool that may be dirty; above it the cleaner also writes back the excess
+   * @param interval time between two cleaning rounds, a dirty eviction wakes the cleaner up earlier
+   */
+  void StartPageCleaner(size_t target_clean_frames, double max_dirty_ratio,
+                        std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+  /** Stop the background page cleaner if it is running, waiting for its current round to finish. */
+  void StopPageCleaner();
+
+  /** @return number of dirty victims written back synchronously by NewPage and FetchPage */
+  uint64_t GetForegroundWriteBacks() const { return foreground_write_backs_.Get(); }
+
+  /** @return number of pages written back by the background page cleaner */
+  uint64_t GetBackgroundWriteBacks() const { return background_write_backs_.Get(); }
+
+  /** Read a page chain ahead asynchronously, see BufferPoolManager::PrefetchPages. */
+  void PrefetchPages(page_id_t page_id, size_t count, next_page_fn next_page) override;
+
+  /** @return number of pages fetched by read-ahead */
+  uint64_t GetPrefetchedPages() const { return read_ahead_.GetPrefetchedPages(); }
+
+  /**
+   * List the resident pages, see BufferPoolManager::GetResidentPages. They come in the replacer's retention order,
+   * followed by the resident pages the replacer does not order.
+   */
+  std::vector<page_id_t> GetResidentPages() override;
+
+  /** Read pages into free frames in one disk submission, see BufferPoolManager::LoadPages. */
+  size_t LoadPages(const std::vector<page_id_t> &page_ids) override;
+
+  /**
+   * @return number of frames a new page could go to right now, free or evictable. Read without the instance latch,
+   * so it is only an estimate for spreading allocations over instances.
+   */
+  size_t GetAvailableFrames() { return num_free_frames_ + (resident_ ? 0 : replacer_->Size()); }
+
+  /** @return the id AllocatePage hands out next when there is no freed page to reuse */
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  /**
+   * Never hand out page ids below end, see BufferPoolManager::SkipPageIds. Also used by ParallelBufferPoolManager when
+   * it reserves an extent, whose contiguous page ids belong to every instance.
+   * @param end one past the last reserved page id
+   * @return the id AllocatePage would have handed out next before skipping
+   */
+  page_id_t SkipPageIds(page_id_t end) override;
+
+  /** Free the rest of an extent, see BufferPoolManager::ReleaseExtent. */
+  void ReleaseExtent(Extent *extent) override;
+
+  /**
+   * Lock the page ids of this instance: while the lock is held, no new page id is handed out. ParallelBufferPoolManager
+   * locks every instance this way, in index order, to reserve an extent past all of their page ids in one step.
+   * @return the lock, on latch_
+   */
+  std::unique_lock<MeasuredMutex> LockPageIds() { return std::unique_lock<MeasuredMutex>(latch_); }
+
+  /** SkipPageIds, with the lock returned by LockPageIds held. */
+  page_id_t SkipPageIdsLocked(page_id_t end);
+
+  /**
+   * Reserve page ids for another buffer pool on the same disk manager, see BufferPoolManager::ReservePageIds. An
+   * instance of a parallel buffer pool cannot, the parallel BPM reserves for all of its instances.
+   */
+  page_id_t ReservePageIds(size_t count) override;
+
+  /**
+   * Take the ids of new pages from another buffer pool instead of counting them up here, so that several pools can
+   * share one disk manager. Runs of EXTENT_SIZE ids are reserved from source at a time. Must be set before the first
+   * page is created.
+   * @param source the buffer pool that hands out page ids, see ReservePageIds
+   */
+  void SetPageIdSource(BufferPoolManager *source) { page_id_source_ = source; }
+
+  /**
+   * Keep every page in the pool once it is there: nothing is evicted, and a new page or a miss fails once all frames
+   * are taken. For small, latency-critical tables that must never wait for the disk.
+   * @param resident whether pages stay resident
+   */
+  void SetResident(bool resident) { resident_ = resident; }
+
+  /**
+   * Keep compressed copies of evicted pages in memory, see CompressedPageCache. A miss then looks there before it reads
+   * the disk. Must be called before the pool is used.
+   * @param budget the number of bytes of compressed pages to keep, 0 for no compressed cache
+   */
+  void SetCompressedCacheSize(size_t budget) {
+    compressed_cache_ = budget == 0 ? nullptr : std::make_unique<CompressedPageCache>(budget);
+  }
+
+  /** @return the compressed cache, nullptr if there is none */
+  CompressedPageCache *GetCompressedCache() { return compressed_cache_.get(); }
+
+  /** @return number of fetches that found their page in the pool, read-ahead included */
+  uint64_t GetHits() const { return hits_.Get(); }
+
+  /** @return number of fetches that read their page from the compressed cache or disk, read-ahead included */
+  uint64_t GetMisses() const { return misses_.Get(); }
+
+  /** @return the fraction of fetches that were hits, 0 before the first fetch */
+  double GetHitRatio() const;
+
+  /** @return a snapshot of the metrics of this instance, see BufferPoolManager::GetMetrics */
+  std::vector<BufferPoolMetrics> GetMetrics() override;
+
+  /**
+   * List the pages that may differ from their copy on disk, see BufferPoolManager::GetDirtyPages. Pinned pages are
+   * listed too, their changes may not be marked dirty yet.
+   */
+  std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPages() override;
+
+  /** Write back the dirty ones of the pages, see BufferPoolManager::WriteBackPages. */
+  size_t WriteBackPages(const std::vector<page_id_t> &page_ids) override;
 
  protected:
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
+   * @param access_type how the page is accessed, a hint for the replacement policy
    * @return the requested page
    */
-  Page *FetchPgImp(page_id_t page_id) override;
+  Page *FetchPgImp(page_id_t page_id, AccessType access_type) override;
 
   /**
    * Unpin the target page from the buffer pool.
@@ -88,6 +240,15 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page out of an extent. Only a standalone instance reserves extents itself; the extents of a parallel
+   * buffer pool are reserved by ParallelBufferPoolManager and must not be empty here.
+   * @param[out] page_id id of created page
+   * @param extent the extent to take the page id from
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgInExtentImp(page_id_t *page_id, Extent *extent) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -101,18 +262,16 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Allocate a page on disk. A page of this instance freed earlier is reused before the file grows.
    * @return the id of the allocated page
    */
   page_id_t AllocatePage();
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, handing it to the disk manager's free space map.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -121,8 +280,213 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void ValidatePageId(page_id_t page_id) const;
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /** What a frame is doing while no latch is held around its disk I/O. */
+  enum class FrameIoState {
+    /** No I/O is running, the frame contents are valid. */
+    NONE,
+    /** The frame is being refilled (victim write-back and/or page read), its contents are not valid yet. */
+    READING,
+    /** The resident page is being flushed, its contents stay valid and readable. */
+    WRITING,
+  };
+
+  /**
+   * One partition of the page table. Pages are spread over the shards by page id, so that pinning and unpinning
+   * resident pages only contends with other pages of the same shard.
+   */
+  struct PageTableShard {
+    /** Protects both maps, and the pin count, dirty flag and I/O state of every frame mapped from this shard. */
+    std::mutex latch_;
+    /** Resident pages of this shard and the frame each one lives in. */
+    std::unordered_map<page_id_t, frame_id_t> page_table_;
+    /**
+     * Victims of this shard whose frame is still being written back or compressed into the compressed cache, and that
+     * frame. A fetch of one waits, so that it cannot read an older copy.
+     */
+    std::unordered_map<page_id_t, frame_id_t> write_back_table_;
+    /**
+     * Resident pages of this shard whose dirty flag is set, so that FlushAllPages skips the clean ones, and the recLSN
+     * of each: no change to the page before it is missing from the disk.
+     */
+    std::unordered_map<page_id_t, lsn_t> dirty_pages_;
+    /** Pages of this shard that are being written back, resident or victims, and their recLSN until the write ends. */
+    std::unordered_map<page_id_t, lsn_t> writing_pages_;
+  };
+
+  /** Frames are allocated and freed FRAME_CHUNK_SIZE at a time, the pool grows and shrinks by whole chunks. */
+  static constexpr size_t FRAME_CHUNK_SIZE = 64;
+
+  /**
+   * A chunk of frames. The pages are only allocated, and the memory of the frame data only held, while the chunk is
+   * part of the pool. The I/O state and condition variables are small and stay, so that a thread just woken up on one
+   * never finds it gone.
+   */
+  struct FrameChunk {
+    std::unique_ptr<Page[]> pages_;
+    /** Data of the chunk's frames in frame_arena_, mapped at the same address for the life of the pool. */
+    char *data_{nullptr};
+    /**
+     * Per-frame I/O state, see FrameIoState. Protected by the latch of the shard the frame's current page maps to.
+     * Frames with I/O in progress are never in the replacer.
+     */
+    FrameIoState io_state_[FRAME_CHUNK_SIZE]{};
+    /**
+     * Per-frame condition variable, signalled when the I/O on that frame completes. Waiters hold the latch of the
+     * shard whose state they wait on (the resident page's shard, or the victim's shard for a write-back).
+     */
+    std::condition_variable_any io_cv_[FRAME_CHUNK_SIZE];
+    /**
+     * Per-frame next LSN of the log when the frame was last pinned from zero pins, a recLSN for the changes made under
+     * those pins. Protected like io_state_.
+     */
+    lsn_t pin_lsn_[FRAME_CHUNK_SIZE]{};
+  };
+
+  /** Number of page table shards per instance. */
+  static constexpr size_t NUM_PAGE_TABLE_SHARDS = 16;
+  /** Number of references the LRU-K replacer looks back at. */
+  static constexpr size_t REPLACER_K = 2;
+
+  /** @return the page table shard that owns page_id */
+  PageTableShard &GetShard(page_id_t page_id);
+
+  /** @return the chunk holding the frame, looked up without a latch */
+  FrameChunk *GetChunk(frame_id_t frame_id) const {
+    return chunk_table_.load(std::memory_order_acquire)[static_cast<size_t>(frame_id) / FRAME_CHUNK_SIZE];
+  }
+
+  /** @return the page of the frame */
+  Page *GetFrame(frame_id_t frame_id) const {
+    return &GetChunk(frame_id)->pages_[static_cast<size_t>(frame_id) % FRAME_CHUNK_SIZE];
+  }
+
+  /** @return the I/O state of the frame */
+  FrameIoState &IoState(frame_id_t frame_id) const {
+    return GetChunk(frame_id)->io_state_[static_cast<size_t>(frame_id) % FRAME_CHUNK_SIZE];
+  }
+
+  /** @return the condition variable of the frame */
+  std::condition_variable_any &IoCv(frame_id_t frame_id) const {
+    return GetChunk(frame_id)->io_cv_[static_cast<size_t>(frame_id) % FRAME_CHUNK_SIZE];
+  }
+
+  /** @return the pin LSN of the frame, see FrameChunk::pin_lsn_ */
+  lsn_t &PinLSN(frame_id_t frame_id) const {
+    return GetChunk(frame_id)->pin_lsn_[static_cast<size_t>(frame_id) % FRAME_CHUNK_SIZE];
+  }
+
+  /** @return the LSN the next log record will get, INVALID_LSN without a log manager */
+  lsn_t NextLSN() const { return log_manager_ == nullptr ? INVALID_LSN : log_manager_->GetNextLSN(); }
+
+  /**
+   * Reserve count contiguous page ids, from page_id_source_ if it is set. Must be called with latch_ held.
+   * @return the first reserved page id
+   */
+  page_id_t TakePageIds(size_t count);
+
+  /** Add frames [pool_size_, pool_size) to the pool and the free list. Must be called with latch_ held. */
+  void AddFrames(size_t pool_size);
+
+  /**
+   * Empty frames [pool_size, pool_size_) and take them out of the pool. Called with latch_ held through lock, which is
+   * released while waiting for pins and I/O.
+   * @return false if a page was still pinned at the deadline; the frames are back in use then
+   */
+  bool RemoveFrames(std::unique_lock<MeasuredMutex> *lock, size_t pool_size,
+                    std::chrono::steady_clock::time_point deadline);
+
+  /**
+   * Pin a frame found through its shard, waiting (with the shard latch released) while its page is being read in.
+   * @param shard_lock the held latch of the shard the frame was found in
+   * @param frame_id the frame to pin
+   * @param access_type how the page is accessed, recorded in the replacer
+   * @return the pinned page
+   */
+  Page *PinFrame(std::unique_lock<std::mutex> *shard_lock, frame_id_t frame_id, AccessType access_type);
+
+  /**
+   * Pick a frame for a new resident page, from the free list first and the replacer otherwise. A victim is unmapped
+   * from its shard; if it is dirty, or there is a compressed cache, it moves to the shard's write-back table until
+   * LoadFrame is done with it. Must be called with latch_ held.
+   * @param[out] frame_id the frame that was picked
+   * @param[out] victim_page_id the page evicted from the frame, or INVALID_PAGE_ID for a free frame
+   * @param[out] write_back whether the victim is dirty and must be written back first
+   * @return false if all frames are pinned
+   */
+  bool PickFrame(frame_id_t *frame_id, page_id_t *victim_page_id, bool *write_back);
+
+  /**
+   * Map page_id to the frame, pinned once and in the READING state. Must be called with latch_ held.
+   * @param frame_id the frame picked by PickFrame
+   * @param page_id the page that will live in the frame
+   * @param access_type how the page is accessed, recorded in the replacer
+   */
+  void ReassignFrame(frame_id_t frame_id, page_id_t page_id, AccessType access_type);
+
+  /**
+   * Finish refilling a frame set up by ReassignFrame: release latch_, write back the victim and read (or zero) the
+   * new page, then mark the frame valid and wake up everyone waiting on it. With a compressed cache, the victim is
+   * compressed into it first, and the new page is taken from it if it is there.
+   * @param lock the held instance latch, released on return
+   * @param frame_id the frame being refilled
+   * @param victim_page_id the page evicted from the frame, or INVALID_PAGE_ID
+   * @param write_back whether the victim must be written back
+   * @param read_page true to read the page from disk, false to zero it (new page)
+   */
+  void LoadFrame(std::unique_lock<MeasuredMutex> *lock, frame_id_t frame_id, page_id_t victim_page_id, bool write_back,
+                 bool read_page);
+
+  /**
+   * Write the resident page of an idle (FrameIoState::NONE) frame to disk. The frame is WRITING and out of the replacer
+   * meanwhile, and the shard latch is released around the write.
+   * @param shard_lock the held latch of the shard the frame's page maps to, held again on return
+   * @param frame_id the frame to write back
+   */
+  void WriteBackFrame(std::unique_lock<std::mutex> *shard_lock, frame_id_t frame_id);
+
+  /**
+   * Put an idle frame in the WRITING state and take it out of the replacer, ahead of writing its page to disk. Must be
+   * called with the latch of the shard the frame's page maps to held.
+   */
+  void BeginWriteBack(frame_id_t frame_id);
+
+  /**
+   * Undo BeginWriteBack once the write is done, waking up everyone waiting on the frame. Must be called with the latch
+   * of the shard the frame's page maps to held.
+   */
+  void EndWriteBack(frame_id_t frame_id);
+
+  /**
+   * Write the pages of frames prepared with BeginWriteBack to disk as one batch, so that the disk manager can keep many
+   * writes in flight, then end their write-backs. No latch may be held.
+   * @param frame_ids the frames to write back
+   */
+  void WriteBackFrames(const std::vector<frame_id_t> &frame_ids);
+
+  /**
+   * @return true if the page may be written out under the WAL rule, i.e. all log records up to its LSN are persistent.
+   * Always true when logging is disabled.
+   */
+  bool IsLogPersistent(Page *page);
+
+  /**
+   * Make the log durable up to lsn before a page with that LSN is written out, as the WAL rule requires. Does nothing
+   * when logging is disabled. Must be called without any latch held, it waits for the log flush.
+   */
+  void ForceLog(lsn_t lsn);
+
+  /** Body of the page cleaner thread: run CleanPages every interval, or when woken up by a dirty eviction. */
+  void PageCleanerLoop();
+
+  /**
+   * One round of the page cleaner. Write back dirty, unpinned pages until target_clean_frames frames are clean and no
+   * more than max_dirty_ratio of the pool is dirty, skipping pages whose log records are not persistent yet.
+   * @return number of pages written back
+   */
+  size_t CleanPages(size_t target_clean_frames, double max_dirty_ratio);
+
+  /** Number of pages in the buffer pool. Changed by Resize under latch_. */
+  std::atomic<size_t> pool_size_{0};
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
@@ -130,19 +494,84 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
   std::atomic<page_id_t> next_page_id_ = instance_index_;
 
-  /** Array of buffer pool pages. */
-  Page *pages_;
+  /**
+   * The chunk table, indexed by frame id / FRAME_CHUNK_SIZE. It is read without a latch on every frame access, so a
+   * full table is replaced by a larger copy instead of being reallocated, and the old copies stay in chunk_tables_.
+   * Changed under latch_.
+   */
+  std::atomic<FrameChunk **> chunk_table_{nullptr};
+  /** Holds the data of every frame; declared before the chunks, whose pages point into it. Changed under latch_. */
+  FrameArena frame_arena_;
+  /** Every chunk table so far, the last one is the current one. */
+  std::vector<std::unique_ptr<FrameChunk *[]>> chunk_tables_;
+  /** Number of entries in the current chunk table. */
+  size_t chunk_table_capacity_{0};
+  /** The chunks allocated so far, owned here. The page memory of those past the end of the pool has been released. */
+  std::vector<std::unique_ptr<FrameChunk>> chunks_;
+  /**
+   * Frames at and above this id are leaving the pool: PickFrame does not hand them out and unpinning them wakes up
+   * Resize. Changed under latch_.
+   */
+  std::atomic<size_t> frame_limit_{0};
+  /** Frames PickFrame took out of the replacer and skipped because they are leaving the pool. Protected by latch_. */
+  std::vector<frame_id_t> skipped_frames_;
+  /** Serializes Resize calls, which release latch_ while draining frames. */
+  std::mutex resize_latch_;
   /** Pointer to the disk manager. */
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
   /** Pointer to the log manager. */
-  LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  LogManager *log_manager_;
+  /** Page table for keeping track of buffer pool pages, partitioned into NUM_PAGE_TABLE_SHARDS shards. */
+  std::vector<PageTableShard> shards_;
   /** Replacer to find unpinned pages for replacement. */
-  Replacer *replacer_;
+  std::unique_ptr<Replacer> replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::mutex latch_;
+  /** Size of free_list_, readable without latch_. */
+  std::atomic<size_t> num_free_frames_{0};
+  /** How long latch_ is held, each time it is taken. */
+  LatencyHistogram latch_hold_times_;
+  /**
+   * Protects the free list, victim selection and the reassignment of frames to pages. It is only taken on misses,
+   * NewPage and DeletePage, never on the hit path, and is never held across disk I/O. Lock order is latch_ before
+   * any shard latch.
+   */
+  MeasuredMutex latch_{&latch_hold_times_};
+
+  /** Where page ids come from if not from next_page_id_, see SetPageIdSource. */
+  BufferPoolManager *page_id_source_{nullptr};
+  /** Page ids reserved from page_id_source_ and not handed out yet. Protected by latch_. */
+  Extent source_page_ids_;
+  /** Whether eviction is off, see SetResident. */
+  std::atomic<bool> resident_{false};
+  /** Compressed copies of evicted pages, see SetCompressedCacheSize. */
+  std::unique_ptr<CompressedPageCache> compressed_cache_;
+
+  /** Fetches served from the pool. */
+  ShardedCounter hits_;
+  /** Fetches that read the page from the compressed cache or disk. */
+  ShardedCounter misses_;
+  /** Pages evicted by PickFrame. */
+  ShardedCounter evictions_;
+  /** Dirty victims written back on the NewPage/FetchPage path. */
+  ShardedCounter foreground_write_backs_;
+  /** Pages written back by the page cleaner. */
+  ShardedCounter background_write_backs_;
+  /** Fetches that waited for the I/O of their page's frame. */
+  ShardedCounter pin_waits_;
+  /** Background page cleaner thread, joinable while it runs. */
+  std::thread cleaner_thread_;
+  /** Protects cleaner_stop_, the page cleaner sleeps on cleaner_cv_ with it. */
+  std::mutex cleaner_latch_;
+  /** Signalled to stop the page cleaner, or to start a round early when a dirty page is evicted. */
+  std::condition_variable cleaner_cv_;
+  /** Set to make the page cleaner exit. */
+  bool cleaner_stop_ = false;
+  /** Page cleaner settings, fixed while it runs. See StartPageCleaner. */
+  size_t cleaner_target_clean_frames_ = 0;
+  double cleaner_max_dirty_ratio_ = 1.0;
+  std::chrono::milliseconds cleaner_interval_{0};
+  /** Serves PrefetchPages. */
+  ReadAheadWorker read_ahead_{this};
 };
 }  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_warmer.h
+//
+// Identification: src/include/buffer/buffer_pool_warmer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * BufferPoolWarmer carries the working set of a buffer pool across a restart.
+ *
+ * Dump writes the ids of the resident pages to a file, the ones the replacement policy would keep longest first; a
+ * background dumper can repeat it periodically, so that a crash loses little of the list. On startup, the loader
+ * reads the listed pages back in on a background thread, hottest first, in batches of BATCH_SIZE pages that are sorted
+ * by page id so that neighbouring pages are read together. It only fills free frames, see
+ * BufferPoolManager::LoadPages, so it can run alongside traffic without evicting the pages that traffic reads in.
+ */
+class BufferPoolWarmer {
+ public:
+  /**
+   * Creates a new BufferPoolWarmer.
+   * @param buffer_pool_manager the buffer pool to warm up, must outlive the warmer's threads
+   * @param file_name the file the page ids are kept in
+   */
+  BufferPoolWarmer(BufferPoolManager *buffer_pool_manager, std::string file_name);
+
+  DISALLOW_COPY_AND_MOVE(BufferPoolWarmer);
+
+  /**
+   * Destroys the BufferPoolWarmer, stopping its threads.
+   */
+  ~BufferPoolWarmer() { Stop(); }
+
+  /**
+   * Write the ids of the resident pages to the file. The file is replaced atomically, an interrupted dump leaves the
+   * previous one in place.
+   * @return false if the file could not be written
+   */
+  bool Dump();
+
+  /**
+   * Start dumping periodically on a background thread.
+   * @param interval the time between two dumps
+   */
+  void StartDumper(std::chrono::milliseconds interval);
+
+  /**
+   * Start reading the pages listed in the file back in on a background thread. Pages beyond the size of the pool are
+   * not read.
+   * @return false if there is no readable file, nothing is loaded then
+   */
+  bool StartLoader();
+
+  /** Wait until the loader has read every page it is going to read. */
+  void WaitForLoader();
+
+  /** Stop the dumper and the loader; the loader finishes the batch it is reading. */
+  void Stop();
+
+  /** @return number of pages read in by the loader */
+  uint64_t GetLoadedPages() const { return loaded_pages_; }
+
+  /** Number of pages the loader reads in one disk submission. */
+  static constexpr size_t BATCH_SIZE = 128;
+
+ private:
+  /** Body of the dumper thread. */
+  void RunDumper(std::chrono::milliseconds interval);
+
+  /** Body of the loader thread. */
+  void RunLoader(std::vector<page_id_t> page_ids);
+
+  /**
+   * Read the page ids out of the file.
+   * @return false if the file is missing or malformed
+   */
+  bool ReadFile(std::vector<page_id_t> *page_ids);
+
+  BufferPoolManager *buffer_pool_manager_;
+  std::string file_name_;
+  /** Serializes dumps, which share the temporary file. */
+  std::mutex dump_latch_;
+  /** Protects stop_. */
+  std::mutex latch_;
+  /** Signalled when the threads are stopped. */
+  std::condition_variable cv_;
+  bool stop_ = false;
+  std::thread dumper_thread_;
+  std::thread loader_thread_;
+  std::atomic<uint64_t> loaded_pages_{0};
+};
+
+}  // namespace bustub
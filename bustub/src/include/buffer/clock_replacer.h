@@ -12,17 +12,27 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <vector>
 
 #include "buffer/replacer.h"
 #include "common/config.h"
+#include "common/macros.h"
 
 namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Pin, Unpin and RecordAccess never take a lock: every frame has an atomic state and an atomic reference bit, and
+ * the use of a frame is recorded by a relaxed store to its reference bit when it is unpinned. Only Victim is
+ * serialized, by a latch around the sweep of the clock hand; it takes a frame with a compare-and-swap of its state, so
+ * a frame pinned during the sweep is skipped.
+ *
+ * Frames live in chunks of CHUNK_SIZE that never move, reached through a chunk table that is replaced (and the old one
+ * kept) when the pool grows, so the lock-free operations can run during SetNumFrames.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -43,10 +53,68 @@ class ClockReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void SetNumFrames(size_t num_frames) override;
+
+  /** Lists referenced frames before unreferenced ones, each from just behind the hand backwards. */
+  std::vector<frame_id_t> GetRetentionOrder() override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  enum class FrameState : uint8_t { NONE, PINNED, EVICTABLE };
+
+  /** Per-frame state, one cache line each so that hits on neighbouring frames do not contend. */
+  struct alignas(64) ClockFrame {
+    std::atomic<FrameState> state_{FrameState::NONE};
+    std::atomic<bool> referenced_{false};
+  };
+
+  /**
+   * Evictable frame count of the frames in one stripe, on its own cache line. Signed, because the decrement of a
+   * frame that was just made evictable may land before the increment.
+   */
+  struct alignas(64) SizeStripe {
+    std::atomic<int64_t> count_{0};
+  };
+
+  /** Number of frames per chunk. */
+  static constexpr size_t CHUNK_SIZE = 64;
+  /** Number of stripes the evictable frame count is split into. */
+  static constexpr size_t NUM_SIZE_STRIPES = 16;
+
+  /** @return the state of a frame, which must be below num_frames_ */
+  ClockFrame &GetFrame(frame_id_t frame_id) {
+    return chunk_table_.load(std::memory_order_acquire)[static_cast<size_t>(frame_id) / CHUNK_SIZE]
+                                                       [static_cast<size_t>(frame_id) % CHUNK_SIZE];
+  }
+
+  /** @return the stripe counting a frame */
+  std::atomic<int64_t> &GetStripe(frame_id_t frame_id) {
+    return size_stripes_[static_cast<size_t>(frame_id) % NUM_SIZE_STRIPES].count_;
+  }
+
+  /**
+   * Move a frame from one state to another, keeping the evictable frame count.
+   * @return true if the frame was in state from
+   */
+  bool Transition(frame_id_t frame_id, ClockFrame *frame, FrameState from, FrameState to);
+
+  /** Chunk table, replaced when the pool grows. */
+  std::atomic<ClockFrame **> chunk_table_{nullptr};
+  /** Every chunk table so far, kept because lock-free readers may still use an old one. Protected by latch_. */
+  std::vector<std::unique_ptr<ClockFrame *[]>> chunk_tables_;
+  /** The chunks. Protected by latch_. */
+  std::vector<std::unique_ptr<ClockFrame[]>> chunks_;
+  std::atomic<size_t> num_frames_{0};
+  SizeStripe size_stripes_[NUM_SIZE_STRIPES];
+  /** Position of the clock hand. Protected by latch_. */
+  size_t hand_{0};
+  /** Serializes Victim and SetNumFrames. */
+  std::mutex latch_;
 };
 
 }  // namespace bustub
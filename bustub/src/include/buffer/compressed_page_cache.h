@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache is a second tier behind a buffer pool: it keeps compressed copies of evicted pages within a
+ * memory budget, so that a later miss on one of them is a decompression instead of a disk read.
+ *
+ * It only holds pages whose copy on disk is identical, and a page is in the cache or in the buffer pool but never in
+ * both: Lookup takes the page out. Pages are compressed with LZUtil; one that does not shrink to MAX_COMPRESSED_SIZE
+ * is not kept, because it would cost the budget nearly a frame. When the budget is exceeded the least recently
+ * inserted pages are dropped. Compression and decompression run outside the latch.
+ */
+class CompressedPageCache {
+ public:
+  /**
+   * Create a new CompressedPageCache.
+   * @param budget the number of bytes of compressed pages the cache may hold
+   */
+  explicit CompressedPageCache(size_t budget);
+
+  DISALLOW_COPY_AND_MOVE(CompressedPageCache);
+
+  ~CompressedPageCache() = default;
+
+  /**
+   * Keep a compressed copy of an evicted page, replacing any copy of it already held.
+   * @param page_id the id of the page
+   * @param data the page, PAGE_SIZE bytes
+   */
+  void Insert(page_id_t page_id, const char *data);
+
+  /**
+   * Take a page out of the cache.
+   * @param page_id the id of the page
+   * @param[out] data the decompressed page, PAGE_SIZE bytes
+   * @return true if the page was in the cache
+   */
+  bool Lookup(page_id_t page_id, char *data);
+
+  /** Drop the copy of a page, e.g. because the page was deleted. */
+  void Erase(page_id_t page_id);
+
+  /** @return the number of pages held */
+  size_t GetNumPages();
+
+  /** @return the number of compressed bytes held */
+  size_t GetSize();
+
+  /** @return the number of lookups that found their page */
+  uint64_t GetHits() const { return hits_; }
+
+  /** @return the number of lookups */
+  uint64_t GetLookups() const { return lookups_; }
+
+  /** @return hits over lookups, 0 before the first lookup */
+  double GetHitRatio() const;
+
+  /** @return the size of the pages inserted over their compressed size, 0 before the first insert */
+  double GetCompressionRatio() const;
+
+  /** Largest compressed size of a page worth keeping. */
+  static constexpr size_t MAX_COMPRESSED_SIZE = PAGE_SIZE * 3 / 4;
+
+ private:
+  struct Entry {
+    std::vector<char> data_;
+    std::list<page_id_t>::iterator lru_iter_;
+  };
+
+  /** Drop a page. Must be called with latch_ held. */
+  void EraseLocked(std::unordered_map<page_id_t, Entry>::iterator iter);
+
+  const size_t budget_;
+  /** Held pages; lru_ orders them from the most to the least recently inserted. */
+  std::unordered_map<page_id_t, Entry> entries_;
+  std::list<page_id_t> lru_;
+  /** Total compressed size of the held pages. */
+  size_t size_{0};
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> lookups_{0};
+  /** Pages inserted, and their total compressed size. */
+  std::atomic<uint64_t> num_inserted_{0};
+  std::atomic<uint64_t> compressed_bytes_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the page data of the frames of a buffer pool, apart from their Page headers.
+ *
+ * Frames are mapped in anonymous segments that are aligned to the OS page size, so that they can be the buffers of
+ * direct I/O, and that stay mapped at the same address until the arena is destroyed. With huge pages, every segment is
+ * aligned to HUGE_PAGE_SIZE and marked for transparent huge pages, so that the pool takes a few TLB entries instead of
+ * one per frame; the kernel silently falls back to small pages when it has no huge page to spare.
+ *
+ * Not thread-safe: the buffer pool allocates and releases frames under its own latch.
+ */
+class FrameArena {
+ public:
+  /**
+   * Create a new FrameArena.
+   * @param huge_pages whether to back the frames with transparent huge pages
+   */
+  explicit FrameArena(bool huge_pages = false) : huge_pages_(huge_pages) {}
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** Unmap every segment. */
+  ~FrameArena();
+
+  /**
+   * Map a new segment of zeroed frames.
+   * @param num_frames the number of frames, PAGE_SIZE bytes each
+   * @return the first frame, the others follow it contiguously
+   * @throws Exception if the memory cannot be mapped
+   */
+  char *Allocate(size_t num_frames);
+
+  /**
+   * Give the memory of frames back to the OS. They stay mapped, and read as zeros when they are used again.
+   * @param data the first frame
+   * @param num_frames the number of frames
+   */
+  static void Release(char *data, size_t num_frames);
+
+  /** @return the number of bytes mapped */
+  size_t GetMappedSize() const;
+
+  /** @return whether the segments are marked for transparent huge pages */
+  bool HasHugePages() const { return huge_pages_; }
+
+  /** Size of a transparent huge page on x86-64 and most ARM64 kernels. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+ private:
+  struct Segment {
+    char *data_;
+    size_t size_;
+  };
+
+  bool huge_pages_;
+  std::vector<Segment> segments_;
+};
+
+}  // namespace bustub
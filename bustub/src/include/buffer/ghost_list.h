@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// ghost_list.h
+//
+// Identification: src/include/buffer/ghost_list.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * GhostList remembers the ids of recently evicted pages, most recent first, without their contents. Replacement
+ * policies that adapt to re-references (2Q, ARC) look a page up here when it is read back in. Not thread safe, the
+ * owning replacer latches it.
+ */
+class GhostList {
+ public:
+  /** @return the number of page ids held */
+  size_t Size() const { return pages_.size(); }
+
+  /** Add a page id as the most recent entry. */
+  void PushFront(page_id_t page_id) {
+    if (page_id == INVALID_PAGE_ID || index_.count(page_id) != 0) {
+      return;
+    }
+    pages_.push_front(page_id);
+    index_.emplace(page_id, pages_.begin());
+  }
+
+  /** Drop the least recent entry, if any. */
+  void PopBack() {
+    if (pages_.empty()) {
+      return;
+    }
+    index_.erase(pages_.back());
+    pages_.pop_back();
+  }
+
+  /**
+   * Drop a page id.
+   * @return true if the page id was held
+   */
+  bool Erase(page_id_t page_id) {
+    auto iter = index_.find(page_id);
+    if (iter == index_.end()) {
+      return false;
+    }
+    pages_.erase(iter->second);
+    index_.erase(iter);
+    return true;
+  }
+
+ private:
+  std::list<page_id_t> pages_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> index_;
+};
+
+}  // namespace bustub
@@ -12,65 +12,57 @@
 
 #pragma once
 
-#include <limits>
-#include <list>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <set>
+#include <utility>
 #include <vector>
+
 #include "buffer/replacer.h"
 #include "common/config.h"
-//#include "common/macros.h"
+#include "common/macros.h"
 
 namespace bustub {
 
-enum class AccessType { Unknown = 0, Get, Scan };
-
-class LRUKNode 
-//struct LRUKNode
-{
-  private:
-  // History of last seen K timestamps of this page. Least recent timestamp stored in front. 
-  // Remove maybe_unused if you start using them. Feel free to change the member variables as you want.
-
-    std::list<size_t> history_;
-    size_t k_;
-    frame_id_t fid_;
-    bool is_evictable_{false};
-
-  public:
-    size_t get_history_size()
-    {
-        return history_.size();
-    }
-    bool is_evictable()
-    {
-      return is_evictable_;
-
-    }
-    size_t get_front()
-    {
-      return history_.front();
-    }
-    void setk(size_t k)
-    {
-      k_=k;
-    }
-    void push(size_t time)
-    {
-        if (history_.size()>=k_)
-        {
-          history_.pop_front();
-        }
-        history_.push_back(time);
-    }
-    void set_evictab(bool set_evic)
-    {
-        is_evictable_=set_evic;
+/**
+ * Access history of one frame: a ring holding the timestamps of its last k accesses.
+ */
+class LRUKNode {
+ public:
+  /** @return the number of timestamps held, at most k */
+  size_t HistorySize() const { return size_; }
+
+  /** @return the oldest timestamp held, i.e. the k-th most recent access once the ring is full */
+  size_t OldestTimestamp() const { return history_[head_]; }
+
+  /** Resize the ring to k entries. Only called once, when the replacer is built. */
+  void Init(size_t k) { history_.assign(k, 0); }
+
+  /** Append a timestamp, dropping the oldest one if the ring is full. */
+  void Push(size_t timestamp) {
+    if (size_ < history_.size()) {
+      history_[(head_ + size_) % history_.size()] = timestamp;
+      size_++;
+    } else {
+      history_[head_] = timestamp;
+      head_ = (head_ + 1) % history_.size();
     }
+  }
 
-    
+  /** Forget the whole history. */
+  void Clear() {
+    head_ = 0;
+    size_ = 0;
+    is_evictable_ = false;
+  }
 
+  /** Whether the frame may be evicted. */
+  bool is_evictable_{false};
 
+ private:
+  /** Last k access timestamps, the oldest at head_. */
+  std::vector<size_t> history_;
+  size_t head_{0};
+  size_t size_{0};
 };
 
 /**
@@ -83,30 +75,29 @@ class LRUKNode
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * Evictable frames are kept in two ordered sets keyed by their oldest retained timestamp, one for +inf frames and one
+ * for frames with k references, so every operation is O(log n). Accesses of type Scan are only recorded for a frame
+ * without history: a sequential scan touches each of its pages in one burst, and counting those touches would give
+ * every scanned page k references and push the hot pages out of the pool.
  */
-class LRUKReplacer {
+class LRUKReplacer : public Replacer {
  public:
   /**
-   *
-   * TODO(P1): Add implementation
-   *
    * @brief a new LRUKReplacer.
-   * @param num_frames the maximum number of frames the LRUReplacer will be required to store
+   * @param num_frames the maximum number of frames the LRUKReplacer will be required to store
+   * @param k the number of historical references that are looked back at
    */
   explicit LRUKReplacer(size_t num_frames, size_t k);
 
   DISALLOW_COPY_AND_MOVE(LRUKReplacer);
 
   /**
-   * TODO(P1): Add implementation
-   *
-   * @brief Destroys the LRUReplacer.
+   * @brief Destroys the LRUKReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Find the frame with largest backward k-distance and evict that frame. Only frames
    * that are marked as 'evictable' are candidates for eviction.
    *
@@ -123,23 +114,17 @@ class LRUKReplacer {
   auto Evict(frame_id_t *frame_id) -> bool;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Record the event that the given frame id is accessed at current timestamp.
    * Create a new entry for access history if frame id has not been seen before.
    *
-   * If frame id is invalid (ie. larger than replacer_size_), throw an exception. You can
-   * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
+   * If frame id is invalid (ie. larger than replacer_size_), the process is aborted.
    *
    * @param frame_id id of frame that received a new access.
-   * @param access_type type of access that was received. This parameter is only needed for
-   * leaderboard tests.
+   * @param access_type type of access that was received. Scan accesses do not extend an existing history.
    */
-  void RecordAccess(frame_id_t frame_id);
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Toggle whether a frame is evictable or non-evictable. This function also
    * controls replacer's size. Note that size is equal to number of evictable entries.
    *
@@ -147,9 +132,8 @@ class LRUKReplacer {
    * decrement. If a frame was previously non-evictable and is to be set to evictable,
    * then size should increment.
    *
-   * If frame id is invalid, throw an exception or abort the process.
-   *
-   * For other scenarios, this function should terminate without modifying anything.
+   * If frame id is invalid, abort the process. For a frame without access history, or any
+   * other scenario, this function terminates without modifying anything.
    *
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
@@ -157,8 +141,6 @@ class LRUKReplacer {
   void SetEvictable(frame_id_t frame_id, bool set_evictable);
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Remove an evictable frame from replacer, along with its access history.
    * This function should also decrement replacer's size if removal is successful.
    *
@@ -166,34 +148,48 @@ class LRUKReplacer {
    * with largest backward k-distance. This function removes specified frame id,
    * no matter what its backward k-distance is.
    *
-   * If Remove is called on a non-evictable frame, throw an exception or abort the
-   * process.
+   * If Remove is called on a non-evictable frame, the process is aborted.
    *
    * If specified frame is not found, directly return from this function.
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Return replacer's size, which tracks the number of evictable frames.
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
+
+  void SetNumFrames(size_t num_frames) override;
+
+  std::vector<frame_id_t> GetRetentionOrder() override;
+
+  bool Victim(frame_id_t *frame_id) override { return Evict(frame_id); }
+
+  void Pin(frame_id_t frame_id) override { SetEvictable(frame_id, false); }
+
+  void Unpin(frame_id_t frame_id) override { SetEvictable(frame_id, true); }
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  std::unordered_map<frame_id_t, LRUKNode> node_store_;
+  /** Ordering key of an evictable frame: its oldest retained timestamp, then the frame id. */
+  using FrameKey = std::pair<size_t, frame_id_t>;
+
+  /** @return the set holding the frame while it is evictable. Must be called with latch_ held. */
+  std::set<FrameKey> *EvictableSet(const LRUKNode &node);
+
+  /** Access history of every frame, indexed by frame id. Grows with the buffer pool, never shrinks. */
+  std::vector<LRUKNode> node_store_;
+  /** Evictable frames with fewer than k references, i.e. +inf backward k-distance. */
+  std::set<FrameKey> inf_distance_frames_;
+  /** Evictable frames with k references, largest backward k-distance first. */
+  std::set<FrameKey> k_distance_frames_;
   size_t current_timestamp_{0};
-  size_t curr_size_{0};
-  size_t replacer_size_{0};
+  size_t replacer_size_;
   size_t k_;
   std::mutex latch_;
-  
 };
 
 }  // namespace bustub
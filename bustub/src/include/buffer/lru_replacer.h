@@ -46,6 +46,11 @@ class LRUReplacer : public Replacer {
 
   size_t Size() override;
 
+  void SetNumFrames(size_t num_frames) override;
+
+  /** Lists the unpinned frames only, LRU keeps no history for pinned ones. */
+  std::vector<frame_id_t> GetRetentionOrder() override;
+
   //void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
  private:
@@ -12,18 +12,30 @@
 
 #pragma once
 
+#include <atomic>
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/read_ahead_worker.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
-class ParallelBufferPoolManager : public BufferPoolManager 
-{
+/** How ParallelBufferPoolManager::NewPage picks the instance that creates the page. */
+enum class InstanceSelection {
+  /** The instances take turns. */
+  ROUND_ROBIN,
+  /** Of the instance whose turn it is and the one after it, the one with more free or evictable frames. */
+  LOAD_AWARE,
+  /** The calling thread's own instance while it has a frame to spare, LOAD_AWARE otherwise. */
+  THREAD_AFFINITY,
+};
+
+class ParallelBufferPoolManager : public BufferPoolManager {
  public:
   /**
    * Creates a new ParallelBufferPoolManager.
@@ -43,22 +55,93 @@ class ParallelBufferPoolManager : public BufferPoolManager
   /** @return size of the buffer pool */
   size_t GetPoolSize() override;
 
+  /**
+   * Resize every instance to pool_size frames while the pool is in use, see BufferPoolManagerInstance::Resize. The
+   * number of instances is fixed: a page belongs to the instance its id maps to, so an instance cannot come or go
+   * without moving pages between instances.
+   * @param pool_size the new number of frames of each instance
+   * @param timeout how long each instance waits for pinned pages when shrinking
+   * @return false if an instance timed out shrinking; that one keeps its old size, the others are resized
+   */
+  bool Resize(size_t pool_size, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+
+  /**
+   * Start the background page cleaner of every instance, see BufferPoolManagerInstance::StartPageCleaner.
+   * @param target_clean_frames number of clean frames each instance tries to keep
+   * @param max_dirty_ratio fraction of each instance that may be dirty
+   * @param interval time between two cleaning rounds
+   */
+  void StartPageCleaner(size_t target_clean_frames, double max_dirty_ratio,
+                        std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+  /** Stop the background page cleaner of every instance. */
+  void StopPageCleaner();
+
+  /** @return number of dirty victims written back synchronously, summed over all instances */
+  uint64_t GetForegroundWriteBacks();
+
+  /** @return number of pages written back by the page cleaners, summed over all instances */
+  uint64_t GetBackgroundWriteBacks();
+
+  /**
+   * Read a page chain ahead asynchronously, see BufferPoolManager::PrefetchPages. A chain spans instances, so it is
+   * walked here rather than by one of the instances.
+   */
+  void PrefetchPages(page_id_t page_id, size_t count, next_page_fn next_page) override;
+
+  /**
+   * List the resident pages of every instance, see BufferPoolManager::GetResidentPages. The lists of the instances are
+   * interleaved, so that the pages each one would keep longest come first.
+   */
+  std::vector<page_id_t> GetResidentPages() override;
+
+  /** Hand every page to the instance it belongs to, see BufferPoolManager::LoadPages. */
+  size_t LoadPages(const std::vector<page_id_t> &page_ids) override;
+
+  /** @return the metrics of every instance, see BufferPoolManager::GetMetrics */
+  std::vector<BufferPoolMetrics> GetMetrics() override;
+
+  /** @return the dirty pages of every instance, see BufferPoolManager::GetDirtyPages */
+  std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPages() override;
+
+  /** Hand every page to the instance it belongs to, see BufferPoolManager::WriteBackPages. */
+  size_t WriteBackPages(const std::vector<page_id_t> &page_ids) override;
+
+  /**
+   * Choose how NewPage spreads new pages over the instances. Whatever the choice, NewPage only fails once every
+   * instance has failed to create the page.
+   * @param selection the policy, ROUND_ROBIN by default
+   */
+  void SetInstanceSelection(InstanceSelection selection) { selection_ = selection; }
+
+  /**
+   * Reserve page ids for another buffer pool on the same disk manager, see BufferPoolManager::ReservePageIds. The run
+   * starts past the page ids handed out by every instance, and all of them skip it.
+   */
+  page_id_t ReservePageIds(size_t count) override;
+
+  /**
+   * Have every instance skip the page ids below end, see BufferPoolManager::SkipPageIds.
+   * @return the lowest id an instance would have handed out next before skipping
+   */
+  page_id_t SkipPageIds(page_id_t end) override;
+
+  /** Free the rest of an extent, each page id by the instance owning it, see BufferPoolManager::ReleaseExtent. */
+  void ReleaseExtent(Extent *extent) override;
+
  protected:
-  /** 实例的数量 */
+  /** The number of instances. */
   size_t num_instances_;
-  /** 每个实例的容量 */
-  size_t pool_size_;
-  /** RR法插入页面时，下一个要插入的位置*/
-  size_t next_instance_;
-  /** 锁 */
+  /** Turns of NewPage, the instance whose turn it is when taken modulo num_instances_. */
+  std::atomic<size_t> next_instance_;
+  /** How NewPage picks the instance that creates the page, see SetInstanceSelection. */
+  std::atomic<InstanceSelection> selection_{InstanceSelection::ROUND_ROBIN};
+  /** Only held to reserve page ids across the instances, never while a page is created. */
   std::mutex latch_;
-  /** 实例s */
+  /** The instances, page page_id belongs to managers_[page_id % num_instances_]. */
   std::vector<BufferPoolManagerInstance *> managers_;
-  // BufferPoolManager **managers_;
-  /** Pointer to the disk manager. */
-  // DiskManager *disk_manager_ __attribute__((__unused__));
-  /** Pointer to the log manager. */
-  // LogManager *log_manager_ __attribute__((__unused__));
+  /** Serves PrefetchPages. */
+  ReadAheadWorker read_ahead_{this};
 
   /**
    * @param page_id id of page
@@ -66,12 +149,22 @@ class ParallelBufferPoolManager : public BufferPoolManager
    */
   BufferPoolManager *GetBufferPoolManager(page_id_t page_id);
 
+  /** @return index of the instance NewPage tries first, according to selection_ */
+  size_t PickInstance();
+
+  /**
+   * Reserve count contiguous page ids on behalf of every instance, past the page ids handed out by any of them. Must
+   * be called with latch_ held.
+   */
+  page_id_t ReservePageIdsLocked(size_t count);
+
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
+   * @param access_type how the page is accessed, a hint for the replacement policy
    * @return the requested page
    */
-  Page *FetchPgImp(page_id_t page_id) override;
+  Page *FetchPgImp(page_id_t page_id, AccessType access_type) override;
 
   /**
    * Unpin the target page from the buffer pool.
@@ -89,12 +182,22 @@ class ParallelBufferPoolManager : public BufferPoolManager
   bool FlushPgImp(page_id_t page_id) override;
 
   /**
-   * Creates a new page in the buffer pool.
+   * Creates a new page in the buffer pool. No latch is taken here, instances are picked with an atomic cursor.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page out of an extent. A new extent starts past the page ids handed out by every instance, and all
+   * instances skip it, so the page is created by whichever instance owns its id. Only the extent's latch is taken to
+   * hand out the id, and latch_ only to reserve a new extent.
+   * @param[out] page_id id of created page
+   * @param extent the extent to take the page id from
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgInExtentImp(page_id_t *page_id, Extent *extent) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_worker.h
+//
+// Identification: src/include/buffer/read_ahead_worker.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace bustub {
+
+/**
+ * ReadAheadWorker serves BufferPoolManager::PrefetchPages. A background thread walks each requested page chain through
+ * the buffer pool manager, fetching and unpinning every page, so that the reads run while the requester is still busy
+ * with the pages before them. The thread is started by the first request.
+ */
+class ReadAheadWorker {
+ public:
+  /**
+   * Creates a new ReadAheadWorker.
+   * @param buffer_pool_manager the buffer pool manager pages are read into, must outlive the worker's thread
+   */
+  explicit ReadAheadWorker(BufferPoolManager *buffer_pool_manager) : buffer_pool_manager_(buffer_pool_manager) {}
+
+  /**
+   * Destroys the ReadAheadWorker, dropping the requests that have not been served yet.
+   */
+  ~ReadAheadWorker() { Stop(); }
+
+  /**
+   * Queue a read-ahead request, see BufferPoolManager::PrefetchPages. Requests beyond MAX_PENDING_REQUESTS are dropped.
+   */
+  void Submit(page_id_t page_id, size_t count, BufferPoolManager::next_page_fn next_page);
+
+  /**
+   * Stop the worker thread, dropping the requests that have not been served yet. Owners call this before tearing down
+   * the buffer pool the worker reads into.
+   */
+  void Stop();
+
+  /** @return number of pages fetched by the worker, including those that were already resident */
+  uint64_t GetPrefetchedPages() const { return prefetched_pages_; }
+
+ private:
+  /** A page chain to read ahead. */
+  struct Request {
+    page_id_t page_id_;
+    size_t count_;
+    BufferPoolManager::next_page_fn next_page_;
+  };
+
+  /** Read-ahead is a hint, a worker that falls this far behind drops new requests rather than queueing them. */
+  static constexpr size_t MAX_PENDING_REQUESTS = 16;
+
+  /** Body of the worker thread. */
+  void Run();
+
+  /** Fetch and unpin up to count pages of the chain starting at page_id. */
+  void ReadChain(const Request &request);
+
+  BufferPoolManager *buffer_pool_manager_;
+  /** Protects the queue and stop_. */
+  std::mutex latch_;
+  /** Signalled when a request is queued or the worker is stopped. */
+  std::condition_variable cv_;
+  std::deque<Request> queue_;
+  bool stop_ = false;
+  std::thread thread_;
+  std::atomic<uint64_t> prefetched_pages_{0};
+};
+
+}  // namespace bustub
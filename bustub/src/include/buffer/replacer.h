@@ -12,10 +12,19 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** How a page is being accessed, passed down from FetchPage to the replacement policy. */
+enum class AccessType { Unknown = 0, Get, Scan };
+
+/** The replacement policies a buffer pool can be built with, see MakeReplacer. */
+enum class ReplacerPolicy { LRU, LRU_K, TWO_Q, ARC, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,10 +52,56 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
-  //virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+  /**
+   * Records that the frame was accessed. Policies that do not keep an access history ignore this.
+   * @param frame_id the id of the accessed frame
+   * @param access_type how the frame was accessed
+   */
+  virtual void RecordAccess(frame_id_t frame_id, AccessType access_type) {}
+
+  /**
+   * Records that a page was just read into a frame the replacer holds no history for. The frame stays pinned until it
+   * is unpinned. Policies that remember evicted pages use the page id to recognize one that comes back; the others
+   * treat the load as an access.
+   * @param frame_id the id of the frame the page was read into
+   * @param page_id the id of the page
+   * @param access_type how the page is accessed
+   */
+  virtual void RecordLoad(frame_id_t frame_id, page_id_t page_id, AccessType access_type) {
+    RecordAccess(frame_id, access_type);
+  }
+
+  /**
+   * Forgets the frame entirely, including any access history, e.g. because its page was deleted.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Makes room for frame ids up to num_frames - 1, because the buffer pool grew. Policies that keep per-frame state in
+   * a table sized at construction override this; the table need not shrink with the pool.
+   * @param num_frames the new number of frames
+   */
+  virtual void SetNumFrames(size_t num_frames) {}
+
+  /**
+   * Lists the frames the replacer holds a history for, pinned or not, from the one the policy would keep longest to
+   * its next victim. Used to save the working set of a buffer pool; policies that keep no order list nothing.
+   * @return the frames, most valuable first
+   */
+  virtual std::vector<frame_id_t> GetRetentionOrder() { return {}; }
 
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
 
+/**
+ * Creates a replacer.
+ * @param policy the replacement policy
+ * @param num_frames the maximum number of frames the replacer will be required to store
+ * @param k the number of references LRU-K looks back at, ignored by the other policies
+ * @return the new replacer
+ */
+std::unique_ptr<Replacer> MakeReplacer(ReplacerPolicy policy, size_t num_frames, size_t k);
+
 }  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.h
+//
+// Identification: src/include/buffer/two_q_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/ghost_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TwoQReplacer implements the full 2Q replacement policy (Johnson and Shasha, VLDB '94).
+ *
+ * A page read in for the first time enters A1in, a FIFO of about a quarter of the frames; hits there do not move it.
+ * A page evicted from A1in leaves its id in A1out, a ghost list of about half the frames. A page read in while its id
+ * is in A1out has been referenced twice in a short span and enters Am, which is managed as LRU. Victims come from
+ * A1in while it is over its share, from Am otherwise. Scan accesses neither enter Am nor move pages within it, so a
+ * scan cannot flush it.
+ *
+ * Evictable frames of each queue are kept in an ordered set keyed by a sequence number, so every operation is
+ * O(log n).
+ */
+class TwoQReplacer : public Replacer {
+ public:
+  /**
+   * Create a new TwoQReplacer.
+   * @param num_frames the maximum number of frames the TwoQReplacer will be required to store
+   */
+  explicit TwoQReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(TwoQReplacer);
+
+  ~TwoQReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
+
+  void RecordLoad(frame_id_t frame_id, page_id_t page_id, AccessType access_type = AccessType::Unknown) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void SetNumFrames(size_t num_frames) override;
+
+  std::vector<frame_id_t> GetRetentionOrder() override;
+
+  size_t Size() override;
+
+ private:
+  enum class Queue : uint8_t { NONE, A1IN, AM };
+
+  /** State of one frame. The page id outlives an eviction, so that a victim that is hit again keeps it. */
+  struct FrameNode {
+    Queue queue_{Queue::NONE};
+    size_t seq_{0};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    bool is_evictable_{false};
+  };
+
+  /** Ordering key of an evictable frame: the sequence number it entered its position with, then the frame id. */
+  using FrameKey = std::pair<size_t, frame_id_t>;
+
+  /** Put an untracked frame at the most recent end of a queue, keeping its evictable state. Needs latch_ held. */
+  void Track(frame_id_t frame_id, Queue queue, bool is_evictable);
+
+  /** Take a tracked frame out of its queue. Must be called with latch_ held. */
+  void Untrack(frame_id_t frame_id);
+
+  /** @return the evictable frames of a queue */
+  std::set<FrameKey> *EvictableSet(Queue queue) { return queue == Queue::A1IN ? &a1in_frames_ : &am_frames_; }
+
+  /** Recompute the queue shares for a pool of num_frames_. Must be called with latch_ held. */
+  void SetShares();
+
+  std::vector<FrameNode> nodes_;
+  /** Evictable frames of A1in, oldest first. */
+  std::set<FrameKey> a1in_frames_;
+  /** Evictable frames of Am, least recently used first. */
+  std::set<FrameKey> am_frames_;
+  /** Ids of pages recently evicted from A1in. */
+  GhostList a1out_;
+  /** Number of frames in A1in, pinned or not. */
+  size_t a1in_size_{0};
+  /** Share of the frames A1in may hold before it is preferred for eviction. */
+  size_t kin_{0};
+  /** Number of page ids A1out remembers. */
+  size_t kout_{0};
+  size_t num_frames_;
+  size_t next_seq_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
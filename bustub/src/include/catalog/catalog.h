@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "catalog/schema.h"
 #include "container/hash/hash_function.h"
 #include "storage/index/extendible_hash_table_index.h"
@@ -96,6 +97,10 @@ struct IndexInfo {
  * The Catalog is a non-persistent catalog that is designed for
  * use by executors within the DBMS execution engine. It handles
  * table creation, table lookup, index creation, and index lookup.
+ *
+ * Tables and indexes share the buffer pool the catalog is built with, unless they are created in a named partition:
+ * a buffer pool of its own, with its own size and replacement policy, so that a large scan elsewhere cannot evict
+ * them. Partitions take their page ids from the shared buffer pool, which has to support ReservePageIds.
  */
 class Catalog {
  public:
@@ -110,24 +115,84 @@ class Catalog {
    * @param bpm The buffer pool manager backing tables created by this catalog
    * @param lock_manager The lock manager in use by the system
    * @param log_manager The log manager in use by the system
+   * @param disk_manager The disk manager behind bpm, needed to create partitions
    */
-  Catalog(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager)
-      : bpm_{bpm}, lock_manager_{lock_manager}, log_manager_{log_manager} {}
+  Catalog(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager,
+          DiskManager *disk_manager = nullptr)
+      : bpm_{bpm}, lock_manager_{lock_manager}, log_manager_{log_manager}, disk_manager_{disk_manager} {}
+
+  /**
+   * Destroy the catalog, writing back the dirty pages of its partitions.
+   */
+  ~Catalog() {
+    for (auto &partition : partitions_) {
+      partition.second->FlushAllPages();
+    }
+  }
+
+  /**
+   * Create a named buffer pool partition for tables and indexes.
+   * @param name The name of the partition
+   * @param pool_size The number of frames of the partition
+   * @param policy The replacement policy of the partition
+   * @param replacer_k The number of references its LRU-K replacement policy looks back at, 1 for plain LRU
+   * @param resident Whether pages never leave the partition; once it is full, new pages fail instead of evicting
+   * @return A (non-owning) pointer to the partition, nullptr if one with that name exists or there is no disk manager
+   */
+  BufferPoolManagerInstance *CreatePartition(const std::string &name, size_t pool_size,
+                                             ReplacerPolicy policy = ReplacerPolicy::LRU_K, size_t replacer_k = 2,
+                                             bool resident = false) {
+    if (disk_manager_ == nullptr || name.empty() || partitions_.count(name) != 0) {
+      return nullptr;
+    }
+    auto partition =
+        std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager_, log_manager_, policy, replacer_k);
+    partition->SetPageIdSource(bpm_);
+    partition->SetResident(resident);
+    auto *tmp = partition.get();
+    partitions_.emplace(name, std::move(partition));
+    return tmp;
+  }
+
+  /**
+   * Query a partition by name.
+   * @param name The name of the partition
+   * @return A (non-owning) pointer to the partition, nullptr if there is none with that name
+   */
+  BufferPoolManagerInstance *GetPartition(const std::string &name) {
+    auto partition = partitions_.find(name);
+    return partition == partitions_.end() ? nullptr : partition->second.get();
+  }
+
+  /**
+   * Get the hit ratio of every partition, see BufferPoolManagerInstance::GetHitRatio.
+   * @return A map partition name -> hit ratio
+   */
+  std::unordered_map<std::string, double> GetPartitionHitRatios() {
+    std::unordered_map<std::string, double> hit_ratios;
+    for (const auto &partition : partitions_) {
+      hit_ratios.emplace(partition.first, partition.second->GetHitRatio());
+    }
+    return hit_ratios;
+  }
 
   /**
    * Create a new table and return its metadata.
    * @param txn The transaction in which the table is being created
    * @param table_name The name of the new table
    * @param schema The schema of the new table
+   * @param partition The name of the buffer pool partition for the table, empty for the shared buffer pool
    * @return A (non-owning) pointer to the metadata for the table
    */
-  TableInfo *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) {
-    if (table_names_.count(table_name) != 0) {
+  TableInfo *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema,
+                         const std::string &partition = "") {
+    auto *bpm = GetBufferPool(partition);
+    if (table_names_.count(table_name) != 0 || bpm == nullptr) {
       return NULL_TABLE_INFO;
     }
 
     // Construct the table heap
-    auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn);
+    auto table = std::make_unique<TableHeap>(bpm, lock_manager_, log_manager_, txn);
 
     // Fetch the table OID for the new table
     const auto table_oid = next_table_oid_.fetch_add(1);
@@ -186,14 +251,16 @@ class Catalog {
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
+   * @param partition The name of the buffer pool partition for the index, empty for the shared buffer pool
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
-                         std::size_t keysize, HashFunction<KeyType> hash_function) {
-    // Reject the creation request for nonexistent table
-    if (table_names_.find(table_name) == table_names_.end()) {
+                         std::size_t keysize, HashFunction<KeyType> hash_function, const std::string &partition = "") {
+    // Reject the creation request for nonexistent table or partition
+    auto *bpm = GetBufferPool(partition);
+    if (table_names_.find(table_name) == table_names_.end() || bpm == nullptr) {
       return NULL_INDEX_INFO;
     }
 
@@ -214,7 +281,7 @@ class Catalog {
     // TODO(Kyle): We should update the API for CreateIndex
     // to allow specification of the index type itself, not
     // just the key, value, and comparator types
-    auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
+    auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm,
                                                                                                hash_function);
 
     // Populate the index with all tuples in table heap
@@ -323,9 +390,25 @@ class Catalog {
   }
 
  private:
+  /**
+   * @param partition The name of a partition, empty for the shared buffer pool
+   * @return The buffer pool of the partition, nullptr if there is no such partition
+   */
+  BufferPoolManager *GetBufferPool(const std::string &partition) {
+    return partition.empty() ? bpm_ : GetPartition(partition);
+  }
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
+  [[maybe_unused]] DiskManager *disk_manager_;
+
+  /**
+   * Map partition name -> partition. Declared before the tables and indexes, so that they go first.
+   *
+   * NOTE: `partitions_` owns all partitions.
+   */
+  std::unordered_map<std::string, std::unique_ptr<BufferPoolManagerInstance>> partitions_;
 
   /**
    * Map table identifier -> table metadata.
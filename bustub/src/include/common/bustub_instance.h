@@ -11,8 +11,10 @@
 //===----------------------------------------------------------------------===//
 
 #include <string>
+#include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/buffer_pool_warmer.h"
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
 #include "recovery/checkpoint_manager.h"
@@ -34,18 +36,27 @@ class BustubInstance {
 
     buffer_pool_manager_ = new BufferPoolManagerInstance(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
 
+    // read the working set saved at the last shutdown back in, while serving
+    const std::string warm_file_name = db_file_name.substr(0, db_file_name.rfind('.')) + ".warm";
+    buffer_pool_warmer_ = new BufferPoolWarmer(buffer_pool_manager_, warm_file_name);
+    buffer_pool_warmer_->StartLoader();
+
     // txn related
     lock_manager_ = new LockManager();
     transaction_manager_ = new TransactionManager(lock_manager_, log_manager_);
 
     // checkpoints
-    checkpoint_manager_ = new CheckpointManager(transaction_manager_, log_manager_, buffer_pool_manager_);
+    checkpoint_manager_ =
+        new CheckpointManager(transaction_manager_, log_manager_, buffer_pool_manager_, disk_manager_);
   }
 
   ~BustubInstance() {
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
+    buffer_pool_warmer_->Stop();
+    buffer_pool_warmer_->Dump();
+    delete buffer_pool_warmer_;
     delete checkpoint_manager_;
     delete log_manager_;
     delete buffer_pool_manager_;
@@ -54,8 +65,26 @@ class BustubInstance {
     delete disk_manager_;
   }
 
+  /**
+   * Take a snapshot of the buffer pool and disk metrics, e.g. for a periodic dump to a log.
+   * @return one line per buffer pool instance, then one per disk latency histogram
+   */
+  std::string DumpMetrics() const {
+    std::string dump;
+    const std::vector<BufferPoolMetrics> metrics = buffer_pool_manager_->GetMetrics();
+    for (size_t i = 0; i < metrics.size(); ++i) {
+      dump += "buffer pool instance " + std::to_string(i) + ": " + metrics[i].ToString() + "\n";
+    }
+    dump += disk_manager_->GetMetrics().ToString() + "\n";
+    if (log_manager_ != nullptr) {
+      dump += log_manager_->GetMetrics().ToString() + "\n";
+    }
+    return dump;
+  }
+
   DiskManager *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
+  BufferPoolWarmer *buffer_pool_warmer_;
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics.h
+//
+// Identification: src/include/common/metrics.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/** Number of shards of a ShardedCounter or LatencyHistogram. */
+static constexpr size_t NUM_METRIC_SHARDS = 16;
+
+/** Size of a cache line, metric shards are aligned to it so that two threads never write to the same line. */
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @return the metric shard the calling thread updates. Threads are assigned shards round robin on their first update,
+ * so that up to NUM_METRIC_SHARDS threads never share one.
+ */
+size_t GetMetricShard();
+
+/**
+ * A counter that is cheap to bump from many threads at once: each thread adds to its own cache line with a relaxed
+ * atomic add, and reading the counter sums the shards. Reads are only as consistent as a relaxed load of each shard,
+ * which is all a metric needs.
+ */
+class ShardedCounter {
+ public:
+  ShardedCounter() = default;
+
+  DISALLOW_COPY_AND_MOVE(ShardedCounter);
+
+  /** Add n to the counter. */
+  void Add(uint64_t n = 1) { shards_[GetMetricShard()].value_.fetch_add(n, std::memory_order_relaxed); }
+
+  /** @return the value of the counter */
+  uint64_t Get() const;
+
+ private:
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    std::atomic<uint64_t> value_{0};
+  };
+
+  std::array<Shard, NUM_METRIC_SHARDS> shards_;
+};
+
+/** A copy of the buckets of a LatencyHistogram, see LatencyHistogram::GetSnapshot. */
+struct HistogramSnapshot {
+  /** Bucket 0 counts latencies under 1ns, bucket i > 0 those in [2^(i-1), 2^i) ns; the last one everything above. */
+  static constexpr size_t NUM_BUCKETS = 40;
+
+  std::array<uint64_t, NUM_BUCKETS> buckets_{};
+  /** Number of latencies recorded. */
+  uint64_t count_{0};
+  /** Sum of the latencies recorded, in nanoseconds. */
+  uint64_t sum_ns_{0};
+
+  /** Add the latencies of another snapshot to this one. */
+  void Merge(const HistogramSnapshot &other);
+
+  /** @return the mean latency in nanoseconds, 0 if nothing was recorded */
+  double GetMeanNs() const;
+
+  /**
+   * @param fraction the quantile, between 0 and 1
+   * @return an upper bound, within a factor of 2, of the latency that fraction of the recorded latencies are under, in
+   * nanoseconds; 0 if nothing was recorded
+   */
+  uint64_t GetPercentileNs(double fraction) const;
+
+  /** @return the count, mean and p50/p99/p99.9/max of the latencies on one line, in microseconds */
+  std::string ToString() const;
+};
+
+/**
+ * A histogram of latencies in power-of-two buckets, sharded like ShardedCounter so that recording one is a couple of
+ * relaxed atomic adds to the calling thread's cache line.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram() = default;
+
+  DISALLOW_COPY_AND_MOVE(LatencyHistogram);
+
+  /** Record one latency. */
+  void Record(std::chrono::nanoseconds latency);
+
+  /** Record the time elapsed since start. */
+  void RecordSince(std::chrono::steady_clock::time_point start) { Record(std::chrono::steady_clock::now() - start); }
+
+  /** @return a copy of the buckets, summed over the shards */
+  HistogramSnapshot GetSnapshot() const;
+
+ private:
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    std::array<std::atomic<uint64_t>, HistogramSnapshot::NUM_BUCKETS> buckets_{};
+    std::atomic<uint64_t> sum_ns_{0};
+  };
+
+  std::array<Shard, NUM_METRIC_SHARDS> shards_;
+};
+
+/**
+ * A std::mutex that records how long it is held in a LatencyHistogram. It is Lockable, so it works with
+ * std::unique_lock and std::scoped_lock; the time it was taken at is only touched by its holder.
+ */
+class MeasuredMutex {
+ public:
+  /** @param hold_times the histogram the hold times are recorded in, must outlive the mutex */
+  explicit MeasuredMutex(LatencyHistogram *hold_times) : hold_times_(hold_times) {}
+
+  DISALLOW_COPY_AND_MOVE(MeasuredMutex);
+
+  void lock() {  // NOLINT
+    mutex_.lock();
+    acquired_at_ = std::chrono::steady_clock::now();
+  }
+
+  bool try_lock() {  // NOLINT
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+    acquired_at_ = std::chrono::steady_clock::now();
+    return true;
+  }
+
+  void unlock() {  // NOLINT
+    hold_times_->RecordSince(acquired_at_);
+    mutex_.unlock();
+  }
+
+ private:
+  std::mutex mutex_;
+  LatencyHistogram *hold_times_;
+  std::chrono::steady_clock::time_point acquired_at_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,50 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_util.h
+//
+// Identification: src/include/common/util/lz_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * LZUtil is a fast LZ77 block codec in the style of LZ4, for compressing pages in memory.
+ *
+ * A block is a series of sequences. Each sequence is a token byte (literal count in the high nibble, match length
+ * minus 4 in the low nibble, 15 meaning more length bytes follow), the literals, and a match: a 2-byte little endian
+ * offset back into the output and the match length bytes. The last sequence has literals only. Matches are found
+ * through a hash table of 4-byte prefixes without any search, trading ratio for speed.
+ */
+class LZUtil {
+ public:
+  /**
+   * Compress a block.
+   * @param src the data to compress, at most 64 KB
+   * @param size the size of src
+   * @param[out] dst the compressed block
+   * @param capacity the size of dst
+   * @return the size of the compressed block, 0 if it does not fit in capacity
+   */
+  static size_t Compress(const char *src, size_t size, char *dst, size_t capacity);
+
+  /**
+   * Decompress a block produced by Compress.
+   * @param src the compressed block
+   * @param size the size of the compressed block
+   * @param[out] dst the decompressed data
+   * @param capacity the size of dst
+   * @return the size of the decompressed data, 0 if the block is malformed or does not fit in capacity
+   */
+  static size_t Decompress(const char *src, size_t size, char *dst, size_t capacity);
+};
+
+}  // namespace bustub
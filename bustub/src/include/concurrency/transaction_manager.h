@@ -13,9 +13,12 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>  // NOLINT
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
@@ -44,11 +47,19 @@ class TransactionManager {
   Transaction *Begin(Transaction *txn = nullptr, IsolationLevel isolation_level = IsolationLevel::REPEATABLE_READ);
 
   /**
-   * Commits a transaction.
+   * Commits a transaction. With logging enabled, this waits for the commit record to be durable unless the
+   * transaction commits asynchronously, see Transaction::SetAsyncCommit.
    * @param txn the transaction to commit
    */
   void Commit(Transaction *txn);
 
+  /**
+   * Set whether the transactions created by Begin commit asynchronously, see Transaction::SetAsyncCommit. Each
+   * transaction may still be switched on its own.
+   * @param async_commit true for asynchronous commits
+   */
+  void SetAsyncCommit(bool async_commit) { async_commit_ = async_commit; }
+
   /**
    * Aborts a transaction
    * @param txn the transaction to abort
@@ -83,6 +94,13 @@ class TransactionManager {
   /** Resumes all transactions, used for checkpointing. */
   void ResumeTransactions();
 
+  /**
+   * Take the active transaction table of a fuzzy checkpoint. A transaction that is not listed either began after the
+   * call, or has appended its commit or abort record before it.
+   * @return the transactions that have logged their begin record but not their end, and the LSN of their begin record
+   */
+  std::vector<std::pair<txn_id_t, lsn_t>> GetActiveTransactions();
+
  private:
   /**
    * Releases all the locks held by the given transaction.
@@ -103,10 +121,17 @@ class TransactionManager {
 
   std::atomic<txn_id_t> next_txn_id_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
+  /** True if the transactions created by Begin commit asynchronously. */
+  std::atomic<bool> async_commit_{false};
 
   /** The global transaction latch is used for checkpointing. */
   ReaderWriterLatch global_txn_latch_;
+
+  /** Protects active_txns_, and is held while a begin record is appended so that no checkpoint misses it. */
+  std::mutex active_txns_latch_;
+  /** The transactions between their begin and end records, and the LSN of their begin record. */
+  std::unordered_map<txn_id_t, lsn_t> active_txns_;
 };
 
 }  // namespace bustub
@@ -44,6 +44,9 @@ class ExtendibleHashTable {
   explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
 
+  /** Frees the page ids of the extent that were not used. */
+  ~ExtendibleHashTable();
+
   /**
    * Inserts a key-value pair into the hash table.
    *
@@ -172,6 +175,8 @@ class ExtendibleHashTable {
   // member variables
   page_id_t directory_page_id_;
   BufferPoolManager *buffer_pool_manager_;
+  /** The extent the directory and bucket pages are taken from. */
+  Extent extent_;
   KeyComparator comparator_;
 
   // Readers includes inserts and removes, writers are splits and merges
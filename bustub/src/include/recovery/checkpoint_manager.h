@@ -12,32 +12,60 @@
 
 #pragma once
 
+#include <cstdint>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 /**
- * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ * CheckpointManager takes ARIES-style fuzzy checkpoints, which never block transactions. A checkpoint logs the active
+ * transaction table and the dirty page table with the recLSN of each page between a CHECKPOINT_BEGIN and a
+ * CHECKPOINT_END record, then writes the dirty pages back in the background. Recovery reads the log from the lowest of
+ * the recLSNs and begin LSNs instead of from its start, and skips the redo of changes that are already on disk. The
+ * sooner the dirty pages are written, the further the next checkpoint moves that point.
  */
 class CheckpointManager {
  public:
   CheckpointManager(TransactionManager *transaction_manager, LogManager *log_manager,
-                    BufferPoolManager *buffer_pool_manager)
+                    BufferPoolManager *buffer_pool_manager, DiskManager *disk_manager)
       : transaction_manager_(transaction_manager),
         log_manager_(log_manager),
-        buffer_pool_manager_(buffer_pool_manager) {}
+        buffer_pool_manager_(buffer_pool_manager),
+        disk_manager_(disk_manager) {}
 
-  ~CheckpointManager() = default;
+  ~CheckpointManager();
 
+  /**
+   * Take a checkpoint: log the tables, make the log durable up to its end and point the master record at it, then
+   * start writing the dirty pages back in the background. Transactions keep running throughout. Waits for the
+   * write-back of the previous checkpoint first. With logging disabled, this flushes the buffer pool instead.
+   */
   void BeginCheckpoint();
+
+  /** Wait until the write-back started by BeginCheckpoint is done. */
   void EndCheckpoint();
 
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** Wait for the write-back thread, if there is one. Must be called with latch_ held. */
+  void JoinWriteBack();
+
+  /** Number of pages the write-back thread hands to the buffer pool at a time. */
+  static constexpr size_t WRITE_BACK_BATCH_SIZE = 64;
+
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  DiskManager *disk_manager_;
+  /** Serializes checkpoints. */
+  std::mutex latch_;
+  /** Writes back the dirty pages of the last checkpoint. Protected by latch_. */
+  std::thread write_back_thread_;
 };
 
 }  // namespace bustub
@@ -13,32 +13,91 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>              // NOLINT
 #include <condition_variable>  // NOLINT
+#include <deque>
 #include <future>              // NOLINT
 #include <mutex>               // NOLINT
+#include <string>
+#include <thread>              // NOLINT
+#include <utility>
 
+#include "common/metrics.h"
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
+/** Where recovery finds the last checkpoint, kept by the disk manager, see DiskManager::WriteMasterRecord. */
+struct CheckpointMasterRecord {
+  /** Offset in the log file at or before the checkpoint's CHECKPOINT_BEGIN record. */
+  int64_t begin_offset_;
+  /** Offset in the log file at or before the record with redo_lsn_. */
+  int64_t redo_offset_;
+  /** LSN of the checkpoint's CHECKPOINT_BEGIN record. */
+  lsn_t begin_lsn_;
+  /** The lowest recLSN of the dirty page table and begin LSN of the active transaction table, at most begin_lsn_. */
+  lsn_t redo_lsn_;
+};
+
+/** How far the log on disk is behind the log records appended, see LogManager::GetDurabilityLag. */
+struct DurabilityLag {
+  /** Bytes of log records that are not persistent yet. */
+  size_t bytes_{0};
+  /** Time since the oldest log record that is not persistent yet was appended, zero if there is none. */
+  std::chrono::nanoseconds time_{0};
+};
+
+/** Log manager metrics, see LogManager::GetMetrics. */
+struct LogMetrics {
+  /** The durability lag when the metrics were taken. */
+  DurabilityLag lag_;
+  /** Log writes, from sealing a buffer to the end of its DiskManager::WriteLog. */
+  HistogramSnapshot writes_;
+  /** Time spent by FlushUntil callers, e.g. synchronous commits, waiting for their records to be persistent. */
+  HistogramSnapshot flush_waits_;
+
+  /** @return the metrics, one line each */
+  std::string ToString() const {
+    return "log lag: " + std::to_string(lag_.bytes_) + " bytes, " +
+           std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(lag_.time_).count()) +
+           "us\nlog writes: " + writes_.ToString() + "\nlog flush waits: " + flush_waits_.ToString();
+  }
+};
+
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * The log is double buffered for group commit: appenders copy their records into one buffer while the flush thread
+ * writes the other to disk, then the two are swapped. A committing transaction asks for a flush and only waits until
+ * persistent_lsn_ reaches its commit record, so every commit that arrives during one write goes to disk with the next
+ * one, in a single DiskManager::WriteLog call.
+ *
+ * Appending takes no lock. The next LSN, the active buffer and the number of bytes reserved in it are packed into one
+ * atomic word, log_state_; an appender reserves its LSN and its room together with a compare-and-swap on it, copies
+ * its record in, and then adds its size to the bytes filled in the buffer. The flusher seals the active buffer by
+ * switching log_state_ to the other one, and waits for the filled bytes to catch up with the reserved ones.
  */
 class LogManager {
  public:
   explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+      : log_offset_(disk_manager->GetLogFileSize()), flush_thread_(nullptr), disk_manager_(disk_manager) {
+    // LSNs go on from the log on disk, a page flushed in an earlier session must not have an LSN above the new records
+    const lsn_t next_lsn = ScanNextLSN();
+    log_state_ = MakeState(next_lsn, 0, 0);
+    persistent_lsn_ = next_lsn - 1;
+    first_lsn_ = next_lsn;
+    log_buffers_[0] = new char[LOG_BUFFER_SIZE];
+    log_buffers_[1] = new char[LOG_BUFFER_SIZE];
   }
 
   ~LogManager() {
-    delete[] log_buffer_;
-    delete[] flush_buffer_;
-    log_buffer_ = nullptr;
-    flush_buffer_ = nullptr;
+    StopFlushThread();
+    delete[] log_buffers_[0];
+    delete[] log_buffers_[1];
+    log_buffers_[0] = nullptr;
+    log_buffers_[1] = nullptr;
   }
 
   void RunFlushThread();
@@ -46,29 +105,157 @@ class LogManager {
 
   lsn_t AppendLogRecord(LogRecord *log_record);
 
-  inline lsn_t GetNextLSN() { return next_lsn_; }
+  /**
+   * Make every log record up to and including lsn durable. Wakes the flush thread up at once instead of waiting for
+   * the timeout, and returns as soon as persistent_lsn_ reaches lsn; records appended meanwhile go along with the same
+   * write. Without a flush thread, the caller writes the buffer out itself.
+   * @param lsn the LSN to wait for
+   */
+  void FlushUntil(lsn_t lsn);
+
+  /**
+   * Make lsn durable within the durability lag bound, see SetMaxDurabilityLag, instead of at once. Returns without
+   * waiting while the durability lag is within the bound, and waits like FlushUntil otherwise, so that the callers
+   * cannot run further ahead of the log on disk. Without a flush thread, this is FlushUntil.
+   * @param lsn the LSN that must become durable
+   */
+  void FlushWithinLag(lsn_t lsn);
+
+  /**
+   * Bound the durability lag of the records that are not waited for, e.g. asynchronous commits. The flush thread
+   * starts writing a record out at most max_time after it was appended, and as soon as max_bytes are waiting for a
+   * write; FlushWithinLag blocks while the lag is over either bound. A record is thus lost in a crash only if it was
+   * appended less than max_time and max_bytes before, plus one log write. Both default to zero, which leaves only
+   * the bounds of the log timeout and of the log buffer size.
+   * @param max_time the longest a record waits for its log write to start
+   * @param max_bytes the most bytes of the log that may be waiting for a write
+   */
+  void SetMaxDurabilityLag(std::chrono::milliseconds max_time, size_t max_bytes);
+
+  /** @return how far the log on disk is behind the log records appended */
+  DurabilityLag GetDurabilityLag();
+
+  /** @return the durability lag, and the latencies of log writes and of waits for them */
+  LogMetrics GetMetrics();
+
+  /**
+   * Find where to start reading the log to see the record with lsn, e.g. for recovery from a checkpoint. Only the
+   * start of one written buffer every LOG_OFFSET_GRANULE bytes is remembered, so the offset may be up to that far
+   * before the record.
+   * @param lsn the LSN of a record appended since this log manager was created
+   * @return the offset in the log file of a record at or before the record with lsn
+   */
+  int64_t GetLogOffset(lsn_t lsn);
+
+  /**
+   * Forget the offsets that GetLogOffset only needs for records before lsn, once nothing will look for those again.
+   * @param lsn the lowest LSN that GetLogOffset will still be asked for
+   */
+  void TruncateLogOffsets(lsn_t lsn);
+
+  inline lsn_t GetNextLSN() { return StateLSN(log_state_); }
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
-  inline char *GetLogBuffer() { return log_buffer_; }
+  inline char *GetLogBuffer() { return log_buffers_[StateBuffer(log_state_)]; }
 
  private:
-  // TODO(students): you may add your own member variables
+  /** Bit of log_state_ that selects the active buffer; the bits below count the bytes reserved in it. */
+  static constexpr uint64_t STATE_BUFFER_BIT = uint64_t{1} << 31;
+  /** The next LSN is in the upper half of log_state_. */
+  static constexpr int STATE_LSN_SHIFT = 32;
+  static_assert(LOG_BUFFER_SIZE < STATE_BUFFER_BIT, "the bytes reserved in a log buffer must fit below the buffer bit");
+
+  static uint64_t MakeState(lsn_t next_lsn, size_t buffer, size_t reserved) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(next_lsn)) << STATE_LSN_SHIFT) |
+           (buffer == 0 ? 0 : STATE_BUFFER_BIT) | reserved;
+  }
+  static lsn_t StateLSN(uint64_t state) { return static_cast<lsn_t>(state >> STATE_LSN_SHIFT); }
+  static size_t StateBuffer(uint64_t state) { return (state & STATE_BUFFER_BIT) == 0 ? 0 : 1; }
+  static size_t StateReserved(uint64_t state) { return state & (STATE_BUFFER_BIT - 1); }
+
+  /** Bytes of the log between two offsets remembered for GetLogOffset, at least. */
+  static constexpr int64_t LOG_OFFSET_GRANULE = 1 << 20;
+
+  /**
+   * @return the LSN after the highest one in the log file, 0 if it is empty. The log is read from the last checkpoint
+   * on, see CheckpointMasterRecord, or from its start if there is none.
+   */
+  lsn_t ScanNextLSN();
+
+  /** Body of the flush thread: write the log buffer out on every timeout and every flush request. */
+  void FlushLoop();
+
+  /**
+   * @return when the flush thread has to write the active buffer out: a log timeout after the last write, or earlier
+   * if the oldest record in it would exceed the durability lag bound in time. Must be called with latch_ held.
+   */
+  std::chrono::steady_clock::time_point FlushDeadline();
 
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /** Wake the flush thread up to write the log out now. */
+  void RequestFlush();
+
+  /** @return the steady clock as an integer, for the atomic timestamps below */
+  static int64_t NowNs() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+
+  /**
+   * Seal the active buffer and write it out, then advance persistent_lsn_. Must be called with latch_ held through
+   * lock, which is released during the write.
+   */
+  void FlushBuffer(std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Wait until the buffer that was active in state is sealed, because a record of the given size did not fit in it.
+   * Without a flush thread, the caller seals and writes it out itself.
+   */
+  void WaitForRoom(uint64_t state, size_t size);
+
+  /** Write the record to data, which has room for log_record->size_ bytes. */
+  static void SerializeLogRecord(LogRecord *log_record, char *data);
+
+  /** The next LSN, the active buffer and the bytes reserved in it, see MakeState. */
+  std::atomic<uint64_t> log_state_;
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
-  char *log_buffer_;
-  char *flush_buffer_;
+  /** The two log buffers, the active one is selected by log_state_. */
+  char *log_buffers_[2];
+  /** Bytes of the records copied into each buffer, it is complete when this reaches the bytes reserved in it. */
+  std::atomic<size_t> log_buffer_filled_[2]{};
+  /** When the first record was appended to each buffer since it became active (NowNs), 0 until it is known. */
+  std::atomic<int64_t> log_buffer_first_append_[2]{};
+  /** Bytes of the sealed buffer being written, 0 if there is no write. */
+  std::atomic<size_t> flushing_bytes_{0};
+  /** The durability lag bound in time, in nanoseconds, and in bytes; 0 if there is none. */
+  std::atomic<int64_t> max_lag_ns_{0};
+  std::atomic<size_t> max_lag_bytes_{0};
+  /** Offset in the log file of the active buffer, and the LSN of its first record. Protected by latch_. */
+  int64_t log_offset_;
+  lsn_t first_lsn_{0};
+  /** The first LSN and the file offset of some of the buffers written, see GetLogOffset. Protected by latch_. */
+  std::deque<std::pair<lsn_t, int64_t>> log_offsets_;
+  /** When the last write of the log was started, for the log timeout. Protected by latch_. */
+  std::chrono::steady_clock::time_point last_flush_;
+  /** Set by a commit or a full buffer, to flush before the timeout. */
+  bool flush_requested_{false};
+  /** Set while a sealed buffer is being written, there is one write at a time. */
+  bool flushing_{false};
+  /** Set to make the flush thread exit. */
+  bool stop_flush_{false};
 
+  /** Protects the flags above; appenders only take it when the active buffer is full. */
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_;
 
+  /** Wakes up the flush thread. */
   std::condition_variable cv_;
+  /** Signalled when a buffer is sealed, making room for appenders, and when persistent_lsn_ advances. */
+  std::condition_variable flushed_cv_;
+
+  DiskManager *disk_manager_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  LatencyHistogram write_latencies_;
+  LatencyHistogram flush_wait_latencies_;
 };
 
 }  // namespace bustub
@@ -14,6 +14,8 @@
 
 #include <cassert>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "storage/table/tuple.h"
@@ -32,6 +34,14 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** The start of a fuzzy checkpoint, see CheckpointManager. */
+  CHECKPOINT_BEGIN,
+  /** Part of the active transaction table and the dirty page table of a checkpoint. */
+  CHECKPOINT_TABLES,
+  /** The end of a checkpoint, once all of its tables are logged. */
+  CHECKPOINT_END,
+  /** Compensation log record: the change made by recovery to undo a record of a transaction that did not finish. */
+  CLR,
 };
 
 /**
@@ -54,9 +64,20 @@ enum class LogRecordType {
  * | HEADER | tuple_rid | tuple_size | old_tuple_data | tuple_size | new_tuple_data |
  *-----------------------------------------------------------------------------------
  * For new page type log record
- *--------------------------
- * | HEADER | prev_page_id |
- *--------------------------
+ *--------------------------------------
+ * | HEADER | prev_page_id | page_id |
+ *--------------------------------------
+ * For checkpoint tables type log record, the active transactions with the LSN of their BEGIN record and the dirty
+ * pages with their recLSN
+ *-------------------------------------------------------------------------------------------
+ * | HEADER | num_txns | (txn_id, begin_lsn) ... | num_pages | (page_id, rec_lsn) ... |
+ *-------------------------------------------------------------------------------------------
+ * CHECKPOINT_BEGIN and CHECKPOINT_END are only the header.
+ * For compensation log record, the LSN of the next record of the transaction to undo and the change made by the
+ * undo, which is laid out like a record of the compensation type after the header
+ *------------------------------------------------------------------------
+ * | HEADER | undo_next_lsn | compensation_type | payload of that type |
+ *------------------------------------------------------------------------
  */
 class LogRecord {
   friend class LogManager;
@@ -110,8 +131,35 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
   }
 
+  // constructor for CHECKPOINT_TABLES type
+  LogRecord(std::vector<std::pair<txn_id_t, lsn_t>> active_txns, std::vector<std::pair<page_id_t, lsn_t>> dirty_pages)
+      : txn_id_(INVALID_TXN_ID),
+        log_record_type_(LogRecordType::CHECKPOINT_TABLES),
+        active_txns_(std::move(active_txns)),
+        dirty_pages_(std::move(dirty_pages)) {
+    size_ = HEADER_SIZE + 2 * sizeof(int32_t) + active_txns_.size() * sizeof(active_txns_[0]) +
+            dirty_pages_.size() * sizeof(dirty_pages_[0]);
+  }
+
+  // constructor for CLR type, compensation is an INSERT, DELETE or UPDATE type record of the change made by the undo
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, lsn_t undo_next_lsn, const LogRecord &compensation)
+      : LogRecord(compensation) {
+    size_ = compensation.size_ + sizeof(lsn_t) + sizeof(LogRecordType);
+    lsn_ = INVALID_LSN;
+    txn_id_ = txn_id;
+    prev_lsn_ = prev_lsn;
+    log_record_type_ = LogRecordType::CLR;
+    undo_next_lsn_ = undo_next_lsn;
+    compensation_type_ = compensation.log_record_type_;
+  }
+
   ~LogRecord() = default;
 
+  /** @return how many table entries, active transactions and dirty pages alike, fit in one CHECKPOINT_TABLES record */
+  static constexpr size_t MaxCheckpointEntries() {
+    return (LOG_BUFFER_SIZE - HEADER_SIZE - 2 * sizeof(int32_t)) / sizeof(std::pair<page_id_t, lsn_t>);
+  }
+
   inline Tuple &GetDeleteTuple() { return delete_tuple_; }
 
   inline RID &GetDeleteRID() { return delete_rid_; }
@@ -128,6 +176,10 @@ class LogRecord {
 
   inline page_id_t GetNewPageRecord() { return prev_page_id_; }
 
+  inline std::vector<std::pair<txn_id_t, lsn_t>> &GetActiveTxns() { return active_txns_; }
+
+  inline std::vector<std::pair<page_id_t, lsn_t>> &GetDirtyPages() { return dirty_pages_; }
+
   inline int32_t GetSize() { return size_; }
 
   inline lsn_t GetLSN() { return lsn_; }
@@ -176,6 +228,14 @@ class LogRecord {
   // case4: for new page operation
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
+
+  // case5: for compensation log records, with the fields of the compensation type above
+  lsn_t undo_next_lsn_{INVALID_LSN};
+  LogRecordType compensation_type_{LogRecordType::INVALID};
+
+  // case6: for checkpoint tables
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages_;
   static const int HEADER_SIZE = 20;
 };  // namespace bustub
 
@@ -13,23 +13,54 @@
 #pragma once
 
 #include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
 #include "recovery/log_record.h"
 
 namespace bustub {
 
 /**
  * Read log file from disk, redo and undo.
+ *
+ * Redo reads the log once, in large chunks with the next one read ahead while the current one is parsed. The same
+ * pass does the analysis: it tracks the active transactions and the records of those that did not finish, which Undo
+ * rolls back. The records that change pages are handed to redo threads partitioned by page id, so that the records of
+ * a page are redone in log order while different pages are redone in parallel.
+ *
+ * If the master record points at a complete checkpoint, see CheckpointManager, the pass starts at the checkpoint's
+ * redo point instead of the start of the log, with the checkpoint's active transactions, and the changes logged
+ * before the checkpoint to pages that are not in its dirty page table, or older than their recLSN, are not redone.
+ *
+ * Undo logs a CLR for every record it rolls back and an ABORT for every transaction once it is rolled back, and
+ * flushes them before the pages they changed may be written back. A later recovery thus skips what was undone, even
+ * if it crashed halfway through Undo.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
+  /**
+   * @param disk_manager the disk manager of the log
+   * @param buffer_pool_manager the buffer pool the pages are redone and undone in
+   * @param log_manager the log manager of the log, which the undo is logged in
+   * @param num_redo_threads the number of redo threads, at most the buffer pool size as each keeps a page pinned
+   */
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager,
+              size_t num_redo_threads = std::max(1U, std::thread::hardware_concurrency()))
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        log_manager_(log_manager),
+        num_redo_threads_(std::max<size_t>(1, std::min(num_redo_threads, buffer_pool_manager->GetPoolSize()))),
+        offset_(0) {
+    log_buffer_ = new char[2 * LOG_READ_BUFFER_SIZE];
   }
 
   ~LogRecovery() {
@@ -42,15 +73,79 @@ class LogRecovery {
   bool DeserializeLogRecord(const char *data, LogRecord *log_record);
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** Bytes of the log read at once. */
+  static constexpr size_t LOG_CHUNK_SIZE = 4 << 20;
+  /**
+   * log_buffer_ holds two chunks, the one parsed and the one read ahead. Each is preceded by room for the start of a
+   * record cut off at the end of the chunk before, and a record is never larger than the log manager's buffer.
+   */
+  static constexpr size_t LOG_READ_BUFFER_SIZE = LOG_BUFFER_SIZE + LOG_CHUNK_SIZE;
+  /** Records handed to a redo thread at once. */
+  static constexpr size_t REDO_BATCH_SIZE = 512;
+  /** Batches queued for a redo thread before the log scan waits for it, bounding the memory of the records. */
+  static constexpr size_t MAX_QUEUED_BATCHES = 64;
+
+  /** The batches of records waiting for a redo thread. */
+  struct RedoQueue {
+    std::mutex latch_;
+    /** Signalled when a batch is queued or taken, or when the scan is over. */
+    std::condition_variable cv_;
+    std::deque<std::vector<LogRecord>> batches_;
+    /** Set when the log scan is over, the thread exits once the queue is empty. */
+    bool done_{false};
+  };
+
+  /** @return the redo thread that redoes the records of page_id */
+  size_t RedoThreadOf(page_id_t page_id) const { return static_cast<size_t>(page_id) % num_redo_threads_; }
+
+  /**
+   * Find the last checkpoint and read its tables, seeding active_txn_ with its active transactions.
+   * @param[out] master_record the master record of the checkpoint
+   * @param[out] dirty_pages the dirty page table of the checkpoint, with the recLSN of each page
+   * @return false if there is no checkpoint or it is incomplete, the log is then read from its start
+   */
+  bool ReadCheckpoint(CheckpointMasterRecord *master_record, std::unordered_map<page_id_t, lsn_t> *dirty_pages);
+
+  /** Queue a full batch for its redo thread, waiting while the thread is too far behind. */
+  void QueueBatch(RedoQueue *queue, std::vector<LogRecord> *batch);
+
+  /** Body of a redo thread. */
+  void RedoLoop(RedoQueue *queue, size_t thread);
+
+  /**
+   * Redo one record if the page it changes is older. A NEWPAGE record changes the new page and the page before it,
+   * which may belong to two redo threads; each redoes its own part.
+   */
+  void RedoLogRecord(LogRecord *log_record, size_t thread);
+
+  /** Roll back one record of a transaction that did not finish, and log a CLR for it. */
+  void UndoLogRecord(LogRecord *log_record);
+
+  /** Fetch a page to undo a record in, it stays pinned until FlushUndo. */
+  Page *FetchUndoPage(page_id_t page_id);
+
+  /** Flush the log up to the last record of the undo, then unpin the pages it changed. */
+  void FlushUndo();
+
+  /** Fetch a page, waiting for a frame if every one is pinned for the moment. */
+  Page *FetchPage(page_id_t page_id);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  const size_t num_redo_threads_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
-  /** Mapping the log sequence number to log file offset for undos. */
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  /** Mapping the log sequence number to log file offset for undos, for the transactions that did not finish. */
+  std::unordered_map<lsn_t, int64_t> lsn_mapping_;
+
+  /** The pages changed by Undo since the last FlushUndo, and the LSN of the last record it logged. */
+  std::unordered_map<page_id_t, Page *> undo_pages_;
+  lsn_t undo_lsn_{INVALID_LSN};
 
-  int offset_ __attribute__((__unused__));
+  /** Offset of the first byte of the log not parsed yet. */
+  int64_t offset_;
   char *log_buffer_;
 };
 
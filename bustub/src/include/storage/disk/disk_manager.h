@@ -13,15 +13,60 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "common/metrics.h"
+#include "storage/disk/io_uring_queue.h"
 
 namespace bustub {
 
+/** How the DiskManager accesses the database file. */
+enum class DiskIoMode {
+  /** One std::fstream behind a latch: every page I/O is a seek plus a read or write, and every write is flushed. */
+  STREAM,
+  /**
+   * A file descriptor used with pread/pwrite, so any number of threads read and write pages at once. The file size is
+   * cached, and written pages are only guaranteed to be on disk after SyncPages.
+   */
+  POSITIONAL,
+  /**
+   * POSITIONAL, and SubmitPageIo runs its batches on a Linux io_uring. If io_uring is not available, SubmitPageIo
+   * falls back to synchronous pread/pwrite.
+   */
+  IO_URING,
+};
+
+/** A page read or write for DiskManager::SubmitPageIo. */
+struct PageIoRequest {
+  /** true to write data_ to the page, false to read the page into data_ */
+  bool is_write_;
+  page_id_t page_id_;
+  char *data_;
+};
+
+/** A snapshot of the latencies of the page I/O of a DiskManager, see DiskManager::GetMetrics. */
+struct DiskMetrics {
+  /** Page reads, one latency per page. */
+  HistogramSnapshot reads_;
+  /** Page writes, one latency per page or per vectored write of a run of adjacent pages. */
+  HistogramSnapshot writes_;
+  /** SyncPages calls. */
+  HistogramSnapshot syncs_;
+
+  /** @return the metrics, one line per histogram */
+  std::string ToString() const {
+    return "reads: " + reads_.ToString() + "\nwrites: " + writes_.ToString() + "\nsyncs: " + syncs_.ToString();
+  }
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
@@ -31,10 +76,15 @@ class DiskManager {
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param io_mode how pages are read and written, see DiskIoMode
+   * @param direct_io true to open the db file with O_DIRECT unless in STREAM mode, so that page reads and writes
+   * bypass the OS page cache and pages are not cached twice, once by the buffer pool and once by the OS. Buffers that
+   * are not aligned to DIRECT_IO_ALIGNMENT are copied through an aligned one. If the file system does not support
+   * direct I/O, the file is opened without it. The log and the free space map are never opened for direct I/O.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, DiskIoMode io_mode = DiskIoMode::STREAM, bool direct_io = false);
 
-  ~DiskManager() = default;
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -55,6 +105,73 @@ class DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Write a run of consecutive pages with a single vectored write.
+   * @param first_page_id id of the first page of the run
+   * @param pages raw page data, pages[i] is written to page first_page_id + i
+   */
+  void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages);
+
+  /**
+   * Start a batch of page reads and writes with a single submission. With an io_uring they run asynchronously and many
+   * of them are in flight at once; otherwise they are done one by one before this returns. The parts of a page the
+   * file does not contain read as zeros. Writes to consecutive pages that follow each other in the batch are merged
+   * into one vectored write, so a batch sorted by page id costs one write per run of adjacent pages.
+   * @param requests the reads and writes, their buffers must stay valid until the batch completes
+   * @param ordered true to run the requests one after the other in order, e.g. writing a frame back before reading
+   * another page into it; such a batch holds at most a few requests
+   * @return a future that is ready once every request of the batch has completed
+   */
+  std::future<void> SubmitPageIo(std::vector<PageIoRequest> requests, bool ordered = false);
+
+  /** @return true if SubmitPageIo runs asynchronously, i.e. the io_uring backend is in use */
+  bool HasAsyncIo() const { return io_uring_ != nullptr; }
+
+  /**
+   * Make every page written so far durable. Unless in STREAM mode, this is the only point where pages are forced to
+   * disk.
+   */
+  void SyncPages();
+
+  /** @return how pages are read and written */
+  DiskIoMode GetIoMode() const { return io_mode_; }
+
+  /** @return true if page reads and writes bypass the OS page cache */
+  bool HasDirectIo() const { return direct_io_; }
+
+  /** Alignment of the buffers, file offsets and lengths of direct I/O; a multiple of the logical block size. */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+  /**
+   * Take a free page for reuse, the lowest one first so that the file stays compact. With a ParallelBufferPoolManager
+   * page page_id belongs to instance page_id % num_instances, so only pages of the calling instance are handed out.
+   * Only the bitmap in memory changes, the free space map file is written by the next SyncPages; a reused page whose
+   * allocation did not reach it before a crash is taken off the free list again by ClaimPage during recovery.
+   * @param num_instances number of buffer pool instances sharing the file
+   * @param instance_index index of the calling instance
+   * @return a free page owned by the instance, or INVALID_PAGE_ID if there is none
+   */
+  page_id_t AllocateFreePage(uint32_t num_instances = 1, uint32_t instance_index = 0);
+
+  /**
+   * Take a page off the free list if it is on it, for recovery to redo the allocation of a page.
+   * @param page_id id of the page
+   */
+  void ClaimPage(page_id_t page_id);
+
+  /**
+   * Record that a page is no longer used, so that AllocateFreePage can hand it out again. Free pages are kept in a
+   * bitmap in the free space map file next to the db file (<db>.fsm), which is written by SyncPages and ShutDown.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return the number of free pages */
+  size_t GetNumFreePages();
+
+  /** @return the size of the db file in bytes */
+  int64_t GetDbFileSize();
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -69,7 +186,26 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  bool ReadLog(char *log_data, int size, int offset);
+  bool ReadLog(char *log_data, int size, int64_t offset);
+
+  /** @return the size of the log file in bytes */
+  int64_t GetLogFileSize();
+
+  /**
+   * Durably replace the master record, which tells recovery where the last checkpoint is. It is kept in a file next
+   * to the db file (<db>.ckpt), and dropped along with the log.
+   * @param data the record
+   * @param size size of the record
+   */
+  void WriteMasterRecord(const char *data, size_t size);
+
+  /**
+   * Read the master record.
+   * @param[out] data output buffer
+   * @param size size of the record
+   * @return true if there is a master record of that size, false otherwise
+   */
+  bool ReadMasterRecord(char *data, size_t size);
 
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
@@ -80,6 +216,14 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /**
+   * Take a snapshot of the page I/O latencies. Synchronous I/O is timed around the system call, asynchronous I/O from
+   * its submission to its completion.
+   */
+  DiskMetrics GetMetrics() const {
+    return {read_latencies_.GetSnapshot(), write_latencies_.GetSnapshot(), sync_latencies_.GetSnapshot()};
+  }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -90,19 +234,85 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
-  int GetFileSize(const std::string &file_name);
+  int64_t GetFileSize(const std::string &file_name);
+  /** WritePage in STREAM mode. */
+  void WritePageStream(page_id_t page_id, const char *page_data);
+  /** ReadPage in STREAM mode. */
+  void ReadPageStream(page_id_t page_id, char *page_data);
+  /** WritePage in POSITIONAL mode, no latch taken. */
+  void WritePagePositional(page_id_t page_id, const char *page_data);
+  /** ReadPage in POSITIONAL mode, no latch taken. */
+  void ReadPagePositional(page_id_t page_id, char *page_data);
+  /** @return true if data cannot be the buffer of a direct I/O and has to be copied through an aligned one */
+  bool NeedsBounceBuffer(const char *data) const {
+    return direct_io_ && reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT != 0;
+  }
+  /** Grow the cached file size to end, if it is smaller. */
+  void GrowFileSize(int64_t end);
+  /** @return the end of the run of writes to consecutive pages that starts at requests[begin] */
+  static size_t WriteRunEnd(const std::vector<PageIoRequest> &requests, size_t begin);
+  /** Completion of a SubmitPageIo request on the io_uring: handles short and failed transfers. */
+  void FinishPageIo(const IoUringQueue::Op &op, int result);
+  /** Open the free space map file and load it, dropping it if the db file is new. */
+  void OpenFreeSpaceMap();
+  /** Write the changed parts of the free-page bitmap to the free space map file. */
+  void WriteFreeSpaceMap();
+  /** Write a copy of one page of the free-page bitmap, the caller holds fsm_io_latch_. @return false on an I/O error */
+  bool WriteFreeSpaceMapPage(size_t fsm_page, const std::vector<uint8_t> &data);
+  /** Clear the free bit of a page and mark its bitmap page dirty, the caller holds fsm_latch_. */
+  void ClearFreeBitLocked(page_id_t page_id);
+
+  /** Number of pages one page of the free-page bitmap covers. */
+  static constexpr size_t FSM_BITS_PER_PAGE = PAGE_SIZE * 8;
+  /** Longest run of pages merged into one vectored write. */
+  static constexpr size_t MAX_PAGES_PER_WRITE = 64;
+
+  /** Submission queue size of the io_uring. */
+  static constexpr uint32_t IO_URING_ENTRIES = 128;
   // stream to write log file
   std::fstream log_io_;
+  // file descriptor of the log file, only used to sync what log_io_ wrote
+  int log_fd_{-1};
   std::string log_name_;
   // stream to write db file
   std::fstream db_io_;
   std::string file_name_;
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
   // With multiple buffer pool instances, need to protect file access
   std::mutex db_io_latch_;
+  DiskIoMode io_mode_;
+  // file descriptor of the db file unless in STREAM mode, -1 otherwise
+  int db_fd_{-1};
+  // true if db_fd_ was opened with O_DIRECT
+  bool direct_io_{false};
+  // size of the db file unless in STREAM mode, grown by every write past its end
+  std::atomic<int64_t> db_file_size_{0};
+  // the io_uring in IO_URING mode, nullptr if it is not available
+  std::unique_ptr<IoUringQueue> io_uring_;
+  // master record file, see WriteMasterRecord
+  std::string master_name_;
+  // free space map file
+  std::string fsm_name_;
+  int fsm_fd_{-1};
+  // protects the free-page bitmap, free_pages_, num_free_pages_ and fsm_dirty_pages_; only held in memory
+  std::mutex fsm_latch_;
+  // serializes writing and syncing the free space map file, which happens without fsm_latch_
+  std::mutex fsm_io_latch_;
+  // bit page_id is set if the page is free, persisted in the free space map file
+  std::vector<uint8_t> fsm_bitmap_;
+  // the free pages of each buffer pool instance, page page_id is in free_pages_[page_id % free_pages_.size()]; each
+  // set is ordered so that allocation reuses the lowest pages first
+  std::vector<std::set<page_id_t>> free_pages_ = std::vector<std::set<page_id_t>>(1);
+  size_t num_free_pages_{0};
+  // bitmap pages changed since the free space map was last written
+  std::set<size_t> fsm_dirty_pages_;
+  // latencies of page reads, page writes and syncs, see GetMetrics
+  LatencyHistogram read_latencies_;
+  LatencyHistogram write_latencies_;
+  LatencyHistogram sync_latencies_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring_queue.h
+//
+// Identification: src/include/storage/disk/io_uring_queue.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <functional>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * IoUringQueue submits batches of reads and writes on one file to a Linux io_uring, talking to the kernel through the
+ * raw system calls. Any number of threads may submit; a completion thread reaps the results and resolves the future of
+ * each batch once all of its operations are done. If the kernel (or the build) has no io_uring, IsOpen() is false and
+ * the queue must not be used.
+ */
+class IoUringQueue {
+ public:
+  /** One read or write of a batch. */
+  struct Op {
+    /** true to write data_ to the file, false to read into data_ */
+    bool is_write_;
+    char *data_;
+    /** length of the transfer, the sum of the iovecs_ lengths for a vectored one */
+    uint32_t len_;
+    int64_t offset_;
+    /** if not empty, the buffers of a vectored transfer, used instead of data_ */
+    std::vector<iovec> iovecs_{};
+  };
+
+  /**
+   * Called on the completion thread for every finished operation.
+   * @param op the operation
+   * @param result number of bytes transferred, or a negative errno
+   */
+  using completion_fn = std::function<void(const Op &op, int result)>;
+
+  /**
+   * Creates a new IoUringQueue.
+   * @param fd the file the operations read and write, must stay open while the queue exists
+   * @param entries size of the submission queue, the completion queue is twice as large
+   */
+  IoUringQueue(int fd, uint32_t entries);
+
+  /**
+   * Waits for the operations in flight and releases the ring.
+   */
+  ~IoUringQueue();
+
+  DISALLOW_COPY_AND_MOVE(IoUringQueue);
+
+  /** @return true if the ring was set up and the queue can be used */
+  bool IsOpen() const { return ring_fd_ >= 0; }
+
+  /**
+   * Submit a batch of operations with as few system calls as possible.
+   * @param ops the operations, their buffers must stay valid until the batch completes
+   * @param linked true to run the operations one after the other, in order; at most GetEntries() of them
+   * @param on_complete called for every operation once it finishes; for those that cannot be submitted, with the
+   * negated errno by Submit itself, without any latch held
+   * @return a future that is ready once on_complete has returned for every operation of the batch
+   */
+  std::future<void> Submit(std::vector<Op> ops, bool linked, completion_fn on_complete);
+
+  /** @return the size of the submission queue */
+  uint32_t GetEntries() const { return sq_entries_; }
+
+ private:
+  struct Batch;
+
+  /** Body of the completion thread. */
+  void ReapCompletions();
+
+  /**
+   * Queue the submission entries that fit into the submission queue and hand them to the kernel. The operations that
+   * do not fit or that the kernel refuses are left to the caller, to be completed with the error once latch_ is
+   * released. Must be called with latch_ held.
+   * @param[out] error the error of the operations that were not submitted
+   * @return the index of the first operation that was not submitted, end if all were
+   */
+  size_t SubmitLocked(Batch *batch, size_t begin, size_t end, bool linked, int *error);
+
+  /** Queue a no-op whose completion wakes up the completion thread. Must be called with latch_ held. */
+  void SubmitWakeUpLocked();
+
+  /**
+   * Hand every queued entry to the kernel, retrying until it has consumed them all or fails. Must be called with
+   * latch_ held.
+   * @return the number of entries the kernel consumed, errno is set if that is fewer than were queued
+   */
+  uint32_t Enter();
+
+  const int fd_;
+  int ring_fd_{-1};
+  uint32_t sq_entries_{0};
+  uint32_t cq_entries_{0};
+
+  /** Memory shared with the kernel, and the ring fields inside it. */
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  void *sqes_{nullptr};
+  size_t sqes_size_{0};
+  uint32_t *sq_head_{nullptr};
+  uint32_t *sq_tail_{nullptr};
+  uint32_t *sq_mask_{nullptr};
+  uint32_t *sq_array_{nullptr};
+  uint32_t *cq_head_{nullptr};
+  uint32_t *cq_tail_{nullptr};
+  uint32_t *cq_mask_{nullptr};
+  void *cqes_{nullptr};
+
+  /** Protects the submission queue and in_flight_. The completion thread takes it to reap. */
+  std::mutex latch_;
+  /** Signalled when completions free up room in the completion queue. */
+  std::condition_variable cv_;
+  /** Operations submitted and not reaped yet, kept below the completion queue size so that it never overflows. */
+  size_t in_flight_{0};
+  /** Set to make the completion thread exit at the next wake-up. */
+  bool stop_{false};
+  std::thread completion_thread_;
+};
+
+}  // namespace bustub
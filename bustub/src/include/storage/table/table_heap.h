@@ -22,13 +22,15 @@ namespace bustub {
 
 /**
  * TableHeap represents a physical table on disk.
- * This is just a doubly-linked list of pages.
+ * This is just a doubly-linked list of pages. The pages are allocated in extents, so that a table that grows along
+ * with others still sits in long contiguous runs on disk.
  */
 class TableHeap {
   friend class TableIterator;
 
  public:
-  ~TableHeap() = default;
+  /** Frees the page ids of the extent that were not used. */
+  ~TableHeap();
 
   /**
    * Create a table heap without a transaction. (open table)
@@ -95,9 +97,10 @@ class TableHeap {
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
+   * @param access_type how the page is accessed, AccessType::Scan when called from a sequential scan
    * @return true if the read was successful (i.e. the tuple exists)
    */
-  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
+  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, AccessType access_type = AccessType::Unknown);
 
   /** @return the begin iterator of this table */
   TableIterator Begin(Transaction *txn);
@@ -113,6 +116,8 @@ class TableHeap {
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** The extent new pages are taken from. After the table is reopened, growing it starts a new extent. */
+  Extent extent_;
 };
 
 }  // namespace bustub
@@ -21,6 +21,7 @@
 namespace bustub {
 
 class TableHeap;
+class TablePage;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
@@ -32,7 +33,11 @@ class TableIterator {
   TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        read_ahead_window_(other.read_ahead_window_),
+        pages_until_read_ahead_(other.pages_until_read_ahead_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +57,32 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    read_ahead_window_ = other.read_ahead_window_;
+    pages_until_read_ahead_ = other.pages_until_read_ahead_;
     return *this;
   }
 
  private:
+  /** Read-ahead window of the first prefetch, in pages. */
+  static constexpr size_t MIN_READ_AHEAD_PAGES = 4;
+  /** Largest read-ahead window, in pages. It is also capped at a quarter of the buffer pool. */
+  static constexpr size_t MAX_READ_AHEAD_PAGES = 64;
+
+  /**
+   * Called each time the scan moves on to the next page of the heap. Prefetches the pages after it once the scan has
+   * used up half of the previous window, doubling the window every time: the longer the scan runs, the further ahead
+   * it reads.
+   * @param page the page the scan just moved to
+   */
+  void ReadAhead(TablePage *page);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Size of the last read-ahead window, 0 before the first one. */
+  size_t read_ahead_window_{0};
+  /** Page switches left before the next read-ahead is issued. */
+  size_t pages_until_read_ahead_{0};
 };
 
 }  // namespace bustub
@@ -12,7 +12,46 @@
 
 #include "recovery/log_manager.h"
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
 namespace bustub {
+lsn_t LogManager::ScanNextLSN() {
+  CheckpointMasterRecord master_record{0, 0, INVALID_LSN, INVALID_LSN};
+  const int64_t log_size = disk_manager_->GetLogFileSize();
+  int64_t offset = 0;
+  if (disk_manager_->ReadMasterRecord(reinterpret_cast<char *>(&master_record), sizeof(CheckpointMasterRecord)) &&
+      master_record.begin_offset_ >= 0 && master_record.begin_offset_ < log_size) {
+    offset = master_record.begin_offset_;
+  }
+  // larger than a record, so that every read gets at least one complete record
+  std::vector<char> buffer(2 * LOG_BUFFER_SIZE);
+  lsn_t max_lsn = INVALID_LSN;
+  while (offset < log_size && disk_manager_->ReadLog(buffer.data(), static_cast<int>(buffer.size()), offset)) {
+    size_t pos = 0;
+    while (buffer.size() - pos >= static_cast<size_t>(LogRecord::HEADER_SIZE)) {
+      // only the header is needed: size, lsn, txn id, prev lsn and type
+      LogRecord header;
+      memcpy(reinterpret_cast<char *>(&header), buffer.data() + pos, LogRecord::HEADER_SIZE);
+      if (header.size_ < LogRecord::HEADER_SIZE || header.size_ > static_cast<int32_t>(LOG_BUFFER_SIZE) ||
+          header.lsn_ == INVALID_LSN || header.log_record_type_ == LogRecordType::INVALID) {
+        // past the end of the log, which reads as zeros
+        return max_lsn + 1;
+      }
+      if (buffer.size() - pos < static_cast<size_t>(header.size_)) {
+        // cut off by the end of the buffer, read again from its start
+        break;
+      }
+      max_lsn = std::max(max_lsn, header.lsn_);
+      pos += header.size_;
+    }
+    offset += pos;
+  }
+  return max_lsn + 1;
+}
+
 /*
  * set enable_logging = true
  * Start a separate thread to execute flush to disk operation periodically
@@ -22,33 +61,334 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::scoped_lock lock(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  stop_flush_ = false;
+  flush_thread_ = new std::thread(&LogManager::FlushLoop, this);
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    std::scoped_lock lock(latch_);
+    if (flush_thread_ == nullptr || stop_flush_) {
+      return;
+    }
+    stop_flush_ = true;
+    flush_thread = flush_thread_;
+  }
+  cv_.notify_one();
+  flush_thread->join();
+  delete flush_thread;
+  std::unique_lock lock(latch_);
+  flush_thread_ = nullptr;
+  stop_flush_ = false;
+  enable_logging = false;
+  // whatever was appended after the last write of the flush thread
+  FlushBuffer(&lock);
+  // waiters for the flush thread now flush by themselves
+  flushed_cv_.notify_all();
+}
+
+void LogManager::FlushLoop() {
+  std::unique_lock lock(latch_);
+  last_flush_ = std::chrono::steady_clock::now();
+  while (!stop_flush_) {
+    const auto deadline = FlushDeadline();
+    if (!flush_requested_ && std::chrono::steady_clock::now() < deadline) {
+      // woken up early, a record may have brought the deadline forward
+      cv_.wait_until(lock, deadline);
+      continue;
+    }
+    FlushBuffer(&lock);
+  }
+  FlushBuffer(&lock);
+}
+
+std::chrono::steady_clock::time_point LogManager::FlushDeadline() {
+  auto deadline = last_flush_ + log_timeout;
+  const int64_t max_lag_ns = max_lag_ns_.load(std::memory_order_relaxed);
+  const uint64_t state = log_state_.load(std::memory_order_acquire);
+  if (max_lag_ns > 0 && StateReserved(state) > 0) {
+    const int64_t first_append = log_buffer_first_append_[StateBuffer(state)].load(std::memory_order_relaxed);
+    if (first_append != 0) {
+      const std::chrono::steady_clock::time_point lag_deadline{std::chrono::nanoseconds(first_append + max_lag_ns)};
+      deadline = std::min(deadline, lag_deadline);
+    }
+  }
+  return deadline;
+}
+
+void LogManager::RequestFlush() {
+  {
+    std::scoped_lock lock(latch_);
+    flush_requested_ = true;
+  }
+  cv_.notify_one();
+}
+
+void LogManager::FlushBuffer(std::unique_lock<std::mutex> *lock) {
+  // one write at a time, the other buffer is still in use until it finishes
+  flushed_cv_.wait(*lock, [&] { return !flushing_; });
+  flush_requested_ = false;
+  last_flush_ = std::chrono::steady_clock::now();
+  uint64_t state = log_state_.load(std::memory_order_acquire);
+  if (StateReserved(state) == 0) {
+    return;
+  }
+  flushing_ = true;
+  const size_t buffer = StateBuffer(state);
+  // The other buffer was written out by the last flush, so it can take records again. Appenders only reserve room in
+  // this one until the switch below, which only fails because they did.
+  log_buffer_filled_[1 - buffer].store(0, std::memory_order_relaxed);
+  log_buffer_first_append_[1 - buffer].store(0, std::memory_order_relaxed);
+  while (!log_state_.compare_exchange_weak(state, MakeState(StateLSN(state), 1 - buffer, 0),
+                                           std::memory_order_acq_rel, std::memory_order_acquire)) {
+  }
+  const size_t size = StateReserved(state);
+  const lsn_t last_lsn = StateLSN(state) - 1;
+  if (log_offsets_.empty() || log_offset_ >= log_offsets_.back().second + LOG_OFFSET_GRANULE) {
+    log_offsets_.emplace_back(first_lsn_, log_offset_);
+  }
+  log_offset_ += static_cast<int64_t>(size);
+  first_lsn_ = StateLSN(state);
+  flushing_bytes_ = size;
+  // appenders waiting for room can go on filling the other buffer during the write
+  flushed_cv_.notify_all();
+
+  lock->unlock();
+  // The appenders that reserved room in the sealed buffer may still be copying their records in; none of them blocks
+  // before it is done, so this is a short wait.
+  while (log_buffer_filled_[buffer].load(std::memory_order_acquire) != size) {
+    std::this_thread::yield();
+  }
+  disk_manager_->WriteLog(log_buffers_[buffer], static_cast<int>(size));
+  lock->lock();
+  write_latencies_.RecordSince(last_flush_);
+
+  persistent_lsn_ = last_lsn;
+  flushing_bytes_ = 0;
+  flushing_ = false;
+  flushed_cv_.notify_all();
+}
+
+void LogManager::FlushUntil(lsn_t lsn) {
+  std::unique_lock lock(latch_);
+  // Nothing past the last record appended can be waited for; a zeroed page has LSN 0 even if there is no log yet.
+  lsn = std::min<lsn_t>(lsn, GetNextLSN() - 1);
+  if (persistent_lsn_ >= lsn) {
+    return;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  while (persistent_lsn_ < lsn) {
+    if (flush_thread_ == nullptr || stop_flush_) {
+      FlushBuffer(&lock);
+      continue;
+    }
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+  flush_wait_latencies_.RecordSince(start);
+}
+
+void LogManager::FlushWithinLag(lsn_t lsn) {
+  bool has_flush_thread;
+  {
+    std::scoped_lock lock(latch_);
+    has_flush_thread = flush_thread_ != nullptr && !stop_flush_;
+  }
+  if (!has_flush_thread) {
+    FlushUntil(lsn);
+    return;
+  }
+  // Appending may outrun the flush thread; then the commit waits like a synchronous one, which holds the committers
+  // back until the log catches up.
+  const DurabilityLag lag = GetDurabilityLag();
+  const size_t max_lag_bytes = max_lag_bytes_.load(std::memory_order_relaxed);
+  const int64_t max_lag_ns = max_lag_ns_.load(std::memory_order_relaxed);
+  if ((max_lag_bytes > 0 && lag.bytes_ > max_lag_bytes) || (max_lag_ns > 0 && lag.time_.count() > max_lag_ns)) {
+    FlushUntil(lsn);
+  }
+}
+
+void LogManager::SetMaxDurabilityLag(std::chrono::milliseconds max_time, size_t max_bytes) {
+  max_lag_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(max_time).count();
+  max_lag_bytes_ = max_bytes;
+  // the flush thread may be waiting for a later deadline
+  { std::scoped_lock lock(latch_); }
+  cv_.notify_one();
+}
+
+DurabilityLag LogManager::GetDurabilityLag() {
+  const uint64_t state = log_state_.load(std::memory_order_acquire);
+  const size_t buffer = StateBuffer(state);
+  const size_t flushing_bytes = flushing_bytes_.load();
+  DurabilityLag lag;
+  lag.bytes_ = StateReserved(state) + flushing_bytes;
+  // The oldest record is in the buffer being written if there is one, in the active buffer otherwise.
+  int64_t oldest = 0;
+  if (flushing_bytes > 0) {
+    oldest = log_buffer_first_append_[1 - buffer].load(std::memory_order_relaxed);
+  } else if (StateReserved(state) > 0) {
+    oldest = log_buffer_first_append_[buffer].load(std::memory_order_relaxed);
+  }
+  if (oldest != 0) {
+    lag.time_ = std::chrono::nanoseconds(std::max<int64_t>(NowNs() - oldest, 0));
+  }
+  return lag;
+}
+
+int64_t LogManager::GetLogOffset(lsn_t lsn) {
+  std::scoped_lock lock(latch_);
+  // the last sampled buffer that starts at or before lsn
+  auto iter = std::upper_bound(log_offsets_.begin(), log_offsets_.end(), lsn,
+                               [](lsn_t key, const std::pair<lsn_t, int64_t> &entry) { return key < entry.first; });
+  if (iter != log_offsets_.begin()) {
+    return std::prev(iter)->second;
+  }
+  // nothing before lsn was written yet, it is in the active buffer
+  return log_offsets_.empty() ? log_offset_ : log_offsets_.front().second;
+}
+
+void LogManager::TruncateLogOffsets(lsn_t lsn) {
+  std::scoped_lock lock(latch_);
+  while (log_offsets_.size() > 1 && log_offsets_[1].first <= lsn) {
+    log_offsets_.pop_front();
+  }
+}
+
+LogMetrics LogManager::GetMetrics() {
+  LogMetrics metrics;
+  metrics.lag_ = GetDurabilityLag();
+  metrics.writes_ = write_latencies_.GetSnapshot();
+  metrics.flush_waits_ = flush_wait_latencies_.GetSnapshot();
+  return metrics;
+}
+
+void LogManager::WaitForRoom(uint64_t state, size_t size) {
+  std::unique_lock lock(latch_);
+  while (true) {
+    const uint64_t current = log_state_.load(std::memory_order_acquire);
+    if (StateBuffer(current) != StateBuffer(state) || StateReserved(current) + size <= LOG_BUFFER_SIZE) {
+      return;
+    }
+    if (flush_thread_ == nullptr || stop_flush_) {
+      FlushBuffer(&lock);
+      continue;
+    }
+    // have the flush thread seal the buffer without waiting for the timeout
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
  */
-lsn_t LogManager::AppendLogRecord(LogRecord *log_record) { return INVALID_LSN; }
+lsn_t LogManager::AppendLogRecord(LogRecord *log_record) {
+  const auto size = static_cast<size_t>(log_record->size_);
+  BUSTUB_ASSERT(size <= LOG_BUFFER_SIZE, "log record is larger than the log buffer");
+  // Reserve the next LSN and the room for the record at once, so that records are in LSN order in the log.
+  uint64_t state = log_state_.load(std::memory_order_acquire);
+  while (true) {
+    if (StateReserved(state) + size > LOG_BUFFER_SIZE) {
+      WaitForRoom(state, size);
+      state = log_state_.load(std::memory_order_acquire);
+      continue;
+    }
+    const uint64_t reserved = state + (uint64_t{1} << STATE_LSN_SHIFT) + size;
+    if (log_state_.compare_exchange_weak(state, reserved, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      break;
+    }
+  }
+  // The room is ours until the filled bytes are bumped, the flusher does not write the buffer before that.
+  const size_t buffer = StateBuffer(state);
+  const size_t offset = StateReserved(state);
+  log_record->lsn_ = StateLSN(state);
+  SerializeLogRecord(log_record, log_buffers_[buffer] + offset);
+  if (offset == 0) {
+    // The first record of the buffer starts the clock of the durability lag bound; the flush thread has to learn of
+    // its deadline, once per buffer.
+    log_buffer_first_append_[buffer].store(NowNs(), std::memory_order_relaxed);
+    if (max_lag_ns_.load(std::memory_order_relaxed) > 0) {
+      { std::scoped_lock lock(latch_); }
+      cv_.notify_one();
+    }
+  }
+  log_buffer_filled_[buffer].fetch_add(size, std::memory_order_release);
+  // The record that brings the buffer to the bound in bytes has it written out without waiting for the deadline.
+  const size_t max_lag_bytes = max_lag_bytes_.load(std::memory_order_relaxed);
+  if (max_lag_bytes > 0 && offset < max_lag_bytes && offset + size >= max_lag_bytes) {
+    RequestFlush();
+  }
+  return log_record->lsn_;
+}
+
+void LogManager::SerializeLogRecord(LogRecord *log_record, char *data) {
+  // the must have fields: size, lsn, txn id, prev lsn and type
+  memcpy(data, log_record, LogRecord::HEADER_SIZE);
+  size_t pos = LogRecord::HEADER_SIZE;
+
+  LogRecordType payload_type = log_record->log_record_type_;
+  if (payload_type == LogRecordType::CLR) {
+    memcpy(data + pos, &log_record->undo_next_lsn_, sizeof(lsn_t));
+    pos += sizeof(lsn_t);
+    memcpy(data + pos, &log_record->compensation_type_, sizeof(LogRecordType));
+    pos += sizeof(LogRecordType);
+    payload_type = log_record->compensation_type_;
+  }
+  switch (payload_type) {
+    case LogRecordType::INSERT:
+      memcpy(data + pos, &log_record->insert_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->insert_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(data + pos, &log_record->delete_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->delete_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(data + pos, &log_record->update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->old_tuple_.SerializeTo(data + pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(data + pos, &log_record->prev_page_id_, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      memcpy(data + pos, &log_record->page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::CHECKPOINT_TABLES: {
+      const auto num_txns = static_cast<int32_t>(log_record->active_txns_.size());
+      memcpy(data + pos, &num_txns, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      memcpy(data + pos, log_record->active_txns_.data(), num_txns * sizeof(log_record->active_txns_[0]));
+      pos += num_txns * sizeof(log_record->active_txns_[0]);
+      const auto num_pages = static_cast<int32_t>(log_record->dirty_pages_.size());
+      memcpy(data + pos, &num_pages, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      memcpy(data + pos, log_record->dirty_pages_.data(), num_pages * sizeof(log_record->dirty_pages_[0]));
+      break;
+    }
+    default:
+      // BEGIN, COMMIT, ABORT and the checkpoint's BEGIN and END are only the header
+      break;
+  }
+}
 
 }  // namespace bustub
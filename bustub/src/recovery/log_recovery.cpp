@@ -12,6 +12,10 @@
 
 #include "recovery/log_recovery.h"
 
+#include <cstring>
+#include <future>  // NOLINT
+
+#include "recovery/checkpoint_manager.h"
 #include "storage/page/table_page.h"
 
 namespace bustub {
@@ -20,21 +24,547 @@ namespace bustub {
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
  */
-bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) { return false; }
+bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) {
+  // the must have fields: size, lsn, txn id, prev lsn and type
+  memcpy(reinterpret_cast<char *>(log_record), data, LogRecord::HEADER_SIZE);
+  if (log_record->size_ < LogRecord::HEADER_SIZE || log_record->lsn_ == INVALID_LSN ||
+      log_record->log_record_type_ == LogRecordType::INVALID) {
+    // past the end of the log, which reads as zeros
+    return false;
+  }
+  const char *pos = data + LogRecord::HEADER_SIZE;
+
+  LogRecordType payload_type = log_record->log_record_type_;
+  if (payload_type == LogRecordType::CLR) {
+    memcpy(&log_record->undo_next_lsn_, pos, sizeof(lsn_t));
+    pos += sizeof(lsn_t);
+    memcpy(&log_record->compensation_type_, pos, sizeof(LogRecordType));
+    pos += sizeof(LogRecordType);
+    payload_type = log_record->compensation_type_;
+  }
+  switch (payload_type) {
+    case LogRecordType::INSERT:
+      memcpy(&log_record->insert_rid_, pos, sizeof(RID));
+      log_record->insert_tuple_.DeserializeFrom(pos + sizeof(RID));
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(&log_record->delete_rid_, pos, sizeof(RID));
+      log_record->delete_tuple_.DeserializeFrom(pos + sizeof(RID));
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(&log_record->update_rid_, pos, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->old_tuple_.DeserializeFrom(pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.DeserializeFrom(pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(&log_record->prev_page_id_, pos, sizeof(page_id_t));
+      memcpy(&log_record->page_id_, pos + sizeof(page_id_t), sizeof(page_id_t));
+      break;
+    case LogRecordType::CHECKPOINT_TABLES: {
+      int32_t num_txns;
+      memcpy(&num_txns, pos, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      log_record->active_txns_.resize(num_txns);
+      memcpy(reinterpret_cast<char *>(log_record->active_txns_.data()), pos,
+             num_txns * sizeof(log_record->active_txns_[0]));
+      pos += num_txns * sizeof(log_record->active_txns_[0]);
+      int32_t num_pages;
+      memcpy(&num_pages, pos, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      log_record->dirty_pages_.resize(num_pages);
+      memcpy(reinterpret_cast<char *>(log_record->dirty_pages_.data()), pos,
+             num_pages * sizeof(log_record->dirty_pages_[0]));
+      break;
+    }
+    default:
+      // BEGIN, COMMIT, ABORT and the checkpoint's BEGIN and END are only the header
+      break;
+  }
+  return true;
+}
+
+/*
+ * find the last checkpoint through the master record and read its tables
+ * @return: false if there is no complete checkpoint to start from
+ */
+bool LogRecovery::ReadCheckpoint(CheckpointMasterRecord *master_record,
+                                 std::unordered_map<page_id_t, lsn_t> *dirty_pages) {
+  if (!disk_manager_->ReadMasterRecord(reinterpret_cast<char *>(master_record), sizeof(CheckpointMasterRecord))) {
+    return false;
+  }
+  // The master record points at or before the checkpoint's begin record, the tables follow it.
+  int64_t offset = master_record->begin_offset_;
+  bool in_checkpoint = false;
+  while (disk_manager_->ReadLog(log_buffer_, LOG_READ_BUFFER_SIZE, offset)) {
+    size_t pos = 0;
+    while (LOG_READ_BUFFER_SIZE - pos >= LogRecord::HEADER_SIZE) {
+      int32_t record_size;
+      memcpy(&record_size, log_buffer_ + pos, sizeof(int32_t));
+      if (record_size > static_cast<int32_t>(LOG_BUFFER_SIZE)) {
+        return false;
+      }
+      if (record_size > 0 && LOG_READ_BUFFER_SIZE - pos < static_cast<size_t>(record_size)) {
+        // cut off by the end of the buffer, read again from its start
+        break;
+      }
+      LogRecord log_record;
+      if (!DeserializeLogRecord(log_buffer_ + pos, &log_record)) {
+        return false;
+      }
+      pos += record_size;
+      if (!in_checkpoint) {
+        if (log_record.log_record_type_ == LogRecordType::CHECKPOINT_BEGIN &&
+            log_record.lsn_ == master_record->begin_lsn_) {
+          in_checkpoint = true;
+        } else if (log_record.lsn_ > master_record->begin_lsn_) {
+          return false;
+        }
+        continue;
+      }
+      switch (log_record.log_record_type_) {
+        case LogRecordType::CHECKPOINT_TABLES:
+          for (const auto &[txn_id, begin_lsn] : log_record.active_txns_) {
+            active_txn_.emplace(txn_id, begin_lsn);
+          }
+          dirty_pages->insert(log_record.dirty_pages_.begin(), log_record.dirty_pages_.end());
+          break;
+        case LogRecordType::CHECKPOINT_END:
+          return true;
+        default:
+          // records of transactions running during the checkpoint, the redo pass reads them
+          break;
+      }
+    }
+    offset += static_cast<int64_t>(pos);
+  }
+  return false;
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
- *read log file from the beginning to end (you must prefetch log records into
+ *read log file from the last checkpoint's redo point to end (you must prefetch log records into
  *log buffer to reduce unnecessary I/O operations), remember to compare page's
  *LSN with log_record's sequence number, and also build active_txn_ table &
  *lsn_mapping_ table
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  active_txn_.clear();
+  lsn_mapping_.clear();
+  // The records of each active transaction, with their offsets, until it commits or aborts.
+  std::unordered_map<txn_id_t, std::vector<std::pair<lsn_t, int64_t>>> txn_records;
+  // For the transactions that an earlier recovery began to undo, the LSN of the next record to undo.
+  std::unordered_map<txn_id_t, lsn_t> undo_next;
+  page_id_t max_page_id = INVALID_PAGE_ID;
+
+  // With a checkpoint, the log before its redo point is not read, and a change logged before the checkpoint is only
+  // redone if its page is in the dirty page table and the change is not older than the page's recLSN.
+  CheckpointMasterRecord master_record{0, 0, INVALID_LSN, INVALID_LSN};
+  std::unordered_map<page_id_t, lsn_t> dirty_pages;
+  if (!ReadCheckpoint(&master_record, &dirty_pages)) {
+    master_record = {0, 0, INVALID_LSN, INVALID_LSN};
+    active_txn_.clear();
+    dirty_pages.clear();
+  }
+  for (const auto &[page_id, rec_lsn] : dirty_pages) {
+    max_page_id = std::max(max_page_id, page_id);
+  }
+  auto needs_redo = [&](page_id_t page_id, lsn_t lsn) {
+    if (lsn >= master_record.begin_lsn_) {
+      return true;
+    }
+    auto iter = dirty_pages.find(page_id);
+    return iter != dirty_pages.end() && lsn >= iter->second;
+  };
+
+  std::vector<std::unique_ptr<RedoQueue>> queues;
+  std::vector<std::vector<LogRecord>> batches(num_redo_threads_);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_redo_threads_; ++i) {
+    queues.push_back(std::make_unique<RedoQueue>());
+    batches[i].reserve(REDO_BATCH_SIZE);
+    threads.emplace_back(&LogRecovery::RedoLoop, this, queues[i].get(), i);
+  }
+  auto dispatch = [&](const LogRecord &log_record, page_id_t page_id) {
+    std::vector<LogRecord> &batch = batches[RedoThreadOf(page_id)];
+    batch.push_back(log_record);
+    if (batch.size() == REDO_BATCH_SIZE) {
+      QueueBatch(queues[RedoThreadOf(page_id)].get(), &batch);
+    }
+  };
+
+  // Each half of log_buffer_ is a chunk of the log preceded by the cut off start of a record from the chunk before.
+  auto chunk_of = [this](size_t half) { return log_buffer_ + half * LOG_READ_BUFFER_SIZE + LOG_BUFFER_SIZE; };
+  auto read_chunk = [this](char *chunk, int64_t chunk_offset) {
+    return disk_manager_->ReadLog(chunk, LOG_CHUNK_SIZE, chunk_offset);
+  };
+  offset_ = master_record.redo_offset_;
+  int64_t chunk_offset = offset_;
+  size_t half = 0;
+  size_t carry = 0;
+  bool has_chunk = read_chunk(chunk_of(half), chunk_offset);
+  while (has_chunk) {
+    std::future<bool> next_chunk =
+        std::async(std::launch::async, read_chunk, chunk_of(1 - half), chunk_offset + LOG_CHUNK_SIZE);
+    const char *data = chunk_of(half) - carry;
+    const size_t size = carry + LOG_CHUNK_SIZE;
+    size_t pos = 0;
+    bool end_of_log = false;
+    while (size - pos >= LogRecord::HEADER_SIZE) {
+      int32_t record_size;
+      memcpy(&record_size, data + pos, sizeof(int32_t));
+      if (record_size > static_cast<int32_t>(LOG_BUFFER_SIZE)) {
+        // not a record the log manager could have written
+        end_of_log = true;
+        break;
+      }
+      if (record_size > 0 && size - pos < static_cast<size_t>(record_size)) {
+        // cut off by the end of the chunk
+        break;
+      }
+      LogRecord log_record;
+      if (!DeserializeLogRecord(data + pos, &log_record)) {
+        end_of_log = true;
+        break;
+      }
+      const int64_t record_offset = offset_ + static_cast<int64_t>(pos);
+      pos += record_size;
+
+      // analysis
+      const txn_id_t txn_id = log_record.txn_id_;
+      switch (log_record.log_record_type_) {
+        case LogRecordType::COMMIT:
+        case LogRecordType::ABORT:
+          // An aborted transaction logged its rollback, which is redone like the rest of the history.
+          active_txn_.erase(txn_id);
+          txn_records.erase(txn_id);
+          undo_next.erase(txn_id);
+          continue;
+        case LogRecordType::BEGIN:
+          active_txn_[txn_id] = log_record.lsn_;
+          continue;
+        case LogRecordType::CHECKPOINT_BEGIN:
+        case LogRecordType::CHECKPOINT_TABLES:
+        case LogRecordType::CHECKPOINT_END:
+          continue;
+        case LogRecordType::CLR:
+          // Its change is redone like any other, and the records it compensates are not undone again.
+          active_txn_[txn_id] = log_record.lsn_;
+          undo_next[txn_id] = log_record.undo_next_lsn_;
+          log_record.log_record_type_ = log_record.compensation_type_;
+          break;
+        default:
+          active_txn_[txn_id] = log_record.lsn_;
+          txn_records[txn_id].emplace_back(log_record.lsn_, record_offset);
+          break;
+      }
+
+      // redo, by the thread of the page
+      switch (log_record.log_record_type_) {
+        case LogRecordType::INSERT:
+          max_page_id = std::max(max_page_id, log_record.insert_rid_.GetPageId());
+          if (needs_redo(log_record.insert_rid_.GetPageId(), log_record.lsn_)) {
+            dispatch(log_record, log_record.insert_rid_.GetPageId());
+          }
+          break;
+        case LogRecordType::UPDATE:
+          if (needs_redo(log_record.update_rid_.GetPageId(), log_record.lsn_)) {
+            dispatch(log_record, log_record.update_rid_.GetPageId());
+          }
+          break;
+        case LogRecordType::NEWPAGE:
+          max_page_id = std::max(max_page_id, log_record.page_id_);
+          // A reused page may still be free in the free space map, which is only written by SyncPages.
+          disk_manager_->ClaimPage(log_record.page_id_);
+          if (!needs_redo(log_record.page_id_, log_record.lsn_) &&
+              !needs_redo(log_record.prev_page_id_, log_record.lsn_)) {
+            break;
+          }
+          dispatch(log_record, log_record.page_id_);
+          if (log_record.prev_page_id_ != INVALID_PAGE_ID &&
+              RedoThreadOf(log_record.prev_page_id_) != RedoThreadOf(log_record.page_id_)) {
+            dispatch(log_record, log_record.prev_page_id_);
+          }
+          break;
+        default:
+          if (needs_redo(log_record.delete_rid_.GetPageId(), log_record.lsn_)) {
+            dispatch(log_record, log_record.delete_rid_.GetPageId());
+          }
+          break;
+      }
+    }
+    has_chunk = next_chunk.get() && !end_of_log;
+    if (!has_chunk) {
+      break;
+    }
+    // Move the cut off record in front of the next chunk.
+    carry = size - pos;
+    memcpy(chunk_of(1 - half) - carry, data + pos, carry);
+    offset_ += static_cast<int64_t>(pos);
+    chunk_offset += LOG_CHUNK_SIZE;
+    half = 1 - half;
+  }
+
+  for (size_t i = 0; i < num_redo_threads_; ++i) {
+    if (!batches[i].empty()) {
+      QueueBatch(queues[i].get(), &batches[i]);
+    }
+    {
+      std::scoped_lock lock(queues[i]->latch_);
+      queues[i]->done_ = true;
+    }
+    queues[i]->cv_.notify_all();
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // The pages of the log may never have been written, they must not be handed out again.
+  if (max_page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->SkipPageIds(max_page_id + 1);
+  }
+  for (const auto &[txn_id, records] : txn_records) {
+    auto iter = undo_next.find(txn_id);
+    for (const auto &[lsn, record_offset] : records) {
+      if (iter == undo_next.end() || lsn <= iter->second) {
+        lsn_mapping_[lsn] = record_offset;
+      }
+    }
+  }
+}
+
+void LogRecovery::QueueBatch(RedoQueue *queue, std::vector<LogRecord> *batch) {
+  {
+    std::unique_lock lock(queue->latch_);
+    queue->cv_.wait(lock, [&] { return queue->batches_.size() < MAX_QUEUED_BATCHES; });
+    queue->batches_.push_back(std::move(*batch));
+  }
+  queue->cv_.notify_all();
+  batch->clear();
+  batch->reserve(REDO_BATCH_SIZE);
+}
+
+void LogRecovery::RedoLoop(RedoQueue *queue, size_t thread) {
+  while (true) {
+    std::vector<LogRecord> batch;
+    {
+      std::unique_lock lock(queue->latch_);
+      queue->cv_.wait(lock, [&] { return !queue->batches_.empty() || queue->done_; });
+      if (queue->batches_.empty()) {
+        return;
+      }
+      batch = std::move(queue->batches_.front());
+      queue->batches_.pop_front();
+    }
+    queue->cv_.notify_all();
+    for (LogRecord &log_record : batch) {
+      RedoLogRecord(&log_record, thread);
+    }
+  }
+}
+
+void LogRecovery::RedoLogRecord(LogRecord *log_record, size_t thread) {
+  const lsn_t lsn = log_record->lsn_;
+  if (log_record->log_record_type_ == LogRecordType::NEWPAGE) {
+    const page_id_t page_id = log_record->page_id_;
+    const page_id_t prev_page_id = log_record->prev_page_id_;
+    if (RedoThreadOf(page_id) == thread) {
+      auto *page = reinterpret_cast<TablePage *>(FetchPage(page_id));
+      page->WLatch();
+      const bool redo = page->GetLSN() < lsn;
+      if (redo) {
+        page->Init(page_id, PAGE_SIZE, prev_page_id, nullptr, nullptr);
+        page->SetLSN(lsn);
+      }
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page_id, redo);
+    }
+    if (prev_page_id != INVALID_PAGE_ID && RedoThreadOf(prev_page_id) == thread) {
+      // The link from the page before is logged with the new page, and takes the LSN of its record.
+      auto *prev_page = reinterpret_cast<TablePage *>(FetchPage(prev_page_id));
+      prev_page->WLatch();
+      const bool redo = prev_page->GetLSN() < lsn;
+      if (redo) {
+        prev_page->SetNextPageId(page_id);
+        prev_page->SetLSN(lsn);
+      }
+      prev_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(prev_page_id, redo);
+    }
+    return;
+  }
+
+  RID rid;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      rid = log_record->insert_rid_;
+      break;
+    case LogRecordType::UPDATE:
+      rid = log_record->update_rid_;
+      break;
+    default:
+      rid = log_record->delete_rid_;
+      break;
+  }
+  auto *page = reinterpret_cast<TablePage *>(FetchPage(rid.GetPageId()));
+  page->WLatch();
+  const bool redo = page->GetLSN() < lsn;
+  if (redo) {
+    switch (log_record->log_record_type_) {
+      case LogRecordType::INSERT: {
+        // The page is as it was when the tuple was inserted, so it lands in the same slot.
+        RID new_rid;
+        page->InsertTuple(log_record->insert_tuple_, &new_rid, nullptr, nullptr, nullptr);
+        break;
+      }
+      case LogRecordType::MARKDELETE:
+        page->MarkDelete(rid, nullptr, nullptr, nullptr);
+        break;
+      case LogRecordType::APPLYDELETE:
+        page->ApplyDelete(rid, nullptr, nullptr);
+        break;
+      case LogRecordType::ROLLBACKDELETE:
+        page->RollbackDelete(rid, nullptr, nullptr);
+        break;
+      case LogRecordType::UPDATE: {
+        Tuple old_tuple;
+        page->UpdateTuple(log_record->new_tuple_, &old_tuple, rid, nullptr, nullptr, nullptr);
+        break;
+      }
+      default:
+        break;
+    }
+    page->SetLSN(lsn);
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(rid.GetPageId(), redo);
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
  *iterate through active txn map and undo each operation
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  // Newest first, across all the transactions that did not finish.
+  std::vector<std::pair<lsn_t, int64_t>> records(lsn_mapping_.begin(), lsn_mapping_.end());
+  std::sort(records.begin(), records.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+  for (const auto &[lsn, record_offset] : records) {
+    int32_t record_size;
+    if (!disk_manager_->ReadLog(log_buffer_, sizeof(int32_t), record_offset)) {
+      continue;
+    }
+    memcpy(&record_size, log_buffer_, sizeof(int32_t));
+    LogRecord log_record;
+    if (!disk_manager_->ReadLog(log_buffer_, record_size, record_offset) ||
+        !DeserializeLogRecord(log_buffer_, &log_record)) {
+      continue;
+    }
+    BUSTUB_ASSERT(log_record.lsn_ == lsn, "the log record is not where the log scan found it");
+    UndoLogRecord(&log_record);
+  }
+  // The next recovery finds these transactions finished, and leaves them alone.
+  for (const auto &[txn_id, last_lsn] : active_txn_) {
+    LogRecord log_record(txn_id, last_lsn, LogRecordType::ABORT);
+    undo_lsn_ = log_manager_->AppendLogRecord(&log_record);
+  }
+  FlushUndo();
+  active_txn_.clear();
+  lsn_mapping_.clear();
+}
+
+void LogRecovery::UndoLogRecord(LogRecord *log_record) {
+  RID rid;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      rid = log_record->insert_rid_;
+      break;
+    case LogRecordType::UPDATE:
+      rid = log_record->update_rid_;
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      rid = log_record->delete_rid_;
+      break;
+    default:
+      // a new page stays allocated, it is just empty
+      return;
+  }
+  const txn_id_t txn_id = log_record->txn_id_;
+  auto *page = reinterpret_cast<TablePage *>(FetchUndoPage(rid.GetPageId()));
+  page->WLatch();
+  // the change made by the undo, logged as a CLR
+  LogRecord compensation;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      page->ApplyDelete(rid, nullptr, nullptr);
+      compensation = LogRecord(txn_id, INVALID_LSN, LogRecordType::APPLYDELETE, rid, log_record->insert_tuple_);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->RollbackDelete(rid, nullptr, nullptr);
+      compensation = LogRecord(txn_id, INVALID_LSN, LogRecordType::ROLLBACKDELETE, rid, log_record->delete_tuple_);
+      break;
+    case LogRecordType::APPLYDELETE: {
+      RID new_rid;
+      page->InsertTuple(log_record->delete_tuple_, &new_rid, nullptr, nullptr, nullptr);
+      compensation = LogRecord(txn_id, INVALID_LSN, LogRecordType::INSERT, new_rid, log_record->delete_tuple_);
+      break;
+    }
+    case LogRecordType::ROLLBACKDELETE:
+      page->MarkDelete(rid, nullptr, nullptr, nullptr);
+      compensation = LogRecord(txn_id, INVALID_LSN, LogRecordType::MARKDELETE, rid, log_record->delete_tuple_);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple new_tuple;
+      page->UpdateTuple(log_record->old_tuple_, &new_tuple, rid, nullptr, nullptr, nullptr);
+      compensation =
+          LogRecord(txn_id, INVALID_LSN, LogRecordType::UPDATE, rid, log_record->new_tuple_, log_record->old_tuple_);
+      break;
+    }
+    default:
+      break;
+  }
+  LogRecord clr(txn_id, active_txn_[txn_id], log_record->prev_lsn_, compensation);
+  undo_lsn_ = log_manager_->AppendLogRecord(&clr);
+  active_txn_[txn_id] = undo_lsn_;
+  page->SetLSN(undo_lsn_);
+  page->WUnlatch();
+}
+
+Page *LogRecovery::FetchUndoPage(page_id_t page_id) {
+  auto iter = undo_pages_.find(page_id);
+  if (iter != undo_pages_.end()) {
+    return iter->second;
+  }
+  Page *page;
+  while ((page = buffer_pool_manager_->FetchPage(page_id)) == nullptr) {
+    // every frame holds an undone page, they can go once their CLRs are on disk
+    FlushUndo();
+  }
+  undo_pages_.emplace(page_id, page);
+  return page;
+}
+
+void LogRecovery::FlushUndo() {
+  if (undo_lsn_ != INVALID_LSN) {
+    log_manager_->FlushUntil(undo_lsn_);
+  }
+  for (const auto &[page_id, page] : undo_pages_) {
+    buffer_pool_manager_->UnpinPage(page_id, true);
+  }
+  undo_pages_.clear();
+}
+
+Page *LogRecovery::FetchPage(page_id_t page_id) {
+  Page *page;
+  while ((page = buffer_pool_manager_->FetchPage(page_id)) == nullptr) {
+    // every frame is pinned by the other redo threads for the moment
+    std::this_thread::yield();
+  }
+  return page;
+}
 
 }  // namespace bustub
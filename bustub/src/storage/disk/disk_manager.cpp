@@ -10,13 +10,23 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -26,18 +36,31 @@ namespace bustub {
 
 static char *buffer_used;
 
+static_assert(PAGE_SIZE % DiskManager::DIRECT_IO_ALIGNMENT == 0, "pages must be whole blocks of direct I/O");
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, DiskIoMode io_mode, bool direct_io)
+    : file_name_(db_file),
+      num_flushes_(0),
+      num_writes_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr),
+      io_mode_(io_mode) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  fsm_name_ = file_name_.substr(0, n) + ".fsm";
+  master_name_ = file_name_.substr(0, n) + ".ckpt";
+  // a master record left behind by an earlier database of the same name points into a log that is gone
+  if (GetFileSize(log_name_) <= 0) {
+    unlink(master_name_.c_str());
+  }
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -52,6 +75,39 @@ DiskManager::DiskManager(const std::string &db_file)
       throw Exception("can't open dblog file");
     }
   }
+  log_fd_ = open(log_name_.c_str(), O_WRONLY);
+  if (log_fd_ < 0) {
+    throw Exception("can't open dblog file");
+  }
+
+  if (io_mode_ != DiskIoMode::STREAM) {
+#ifdef O_DIRECT
+    if (direct_io) {
+      db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+      if (db_fd_ < 0 && errno == EINVAL) {
+        // e.g. tmpfs, which has no direct I/O
+        LOG_DEBUG("direct I/O is not supported for the db file, falling back to buffered I/O");
+      }
+      direct_io_ = db_fd_ >= 0;
+    }
+#endif
+    if (db_fd_ < 0) {
+      db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+    if (db_fd_ < 0) {
+      throw Exception("can't open db file");
+    }
+    db_file_size_ = GetFileSize(db_file);
+    if (io_mode_ == DiskIoMode::IO_URING) {
+      auto io_uring = std::make_unique<IoUringQueue>(db_fd_, IO_URING_ENTRIES);
+      if (io_uring->IsOpen()) {
+        io_uring_ = std::move(io_uring);
+      }
+    }
+    OpenFreeSpaceMap();
+    buffer_used = nullptr;
+    return;
+  }
 
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
@@ -67,24 +123,104 @@ DiskManager::DiskManager(const std::string &db_file)
       throw Exception("can't open db file");
     }
   }
+  OpenFreeSpaceMap();
   buffer_used = nullptr;
 }
 
+/**
+ * Open the free space map file and load the free-page bitmap
+ */
+void DiskManager::OpenFreeSpaceMap() {
+  fsm_fd_ = open(fsm_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fsm_fd_ < 0) {
+    throw Exception("can't open free space map file");
+  }
+  // a map left behind by an earlier database of the same name does not describe a new, empty db file
+  if (GetFileSize(file_name_) <= 0) {
+    if (ftruncate(fsm_fd_, 0) != 0) {
+      LOG_DEBUG("I/O error while truncating the free space map");
+    }
+    return;
+  }
+  const int64_t fsm_size = GetFileSize(fsm_name_);
+  fsm_bitmap_.resize(fsm_size > 0 ? fsm_size : 0);
+  size_t read_count = 0;
+  while (read_count < fsm_bitmap_.size()) {
+    ssize_t rc = pread(fsm_fd_, fsm_bitmap_.data() + read_count, fsm_bitmap_.size() - read_count, read_count);
+    if (rc <= 0) {
+      if (rc < 0 && errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while reading the free space map");
+      fsm_bitmap_.resize(read_count);
+      break;
+    }
+    read_count += rc;
+  }
+  for (size_t i = 0; i < fsm_bitmap_.size() * 8; ++i) {
+    if ((fsm_bitmap_[i / 8] & (1U << (i % 8))) != 0) {
+      free_pages_[0].insert(static_cast<page_id_t>(i));
+      num_free_pages_++;
+    }
+  }
+}
+
+DiskManager::~DiskManager() {
+  io_uring_.reset();
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  if (fsm_fd_ >= 0) {
+    close(fsm_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
+  io_uring_.reset();
+  SyncPages();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (fsm_fd_ >= 0) {
+    close(fsm_fd_);
+    fsm_fd_ = -1;
+  }
   {
     std::scoped_lock scoped_db_io_latch(db_io_latch_);
     db_io_.close();
   }
   log_io_.close();
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  const auto start = std::chrono::steady_clock::now();
+  if (io_mode_ != DiskIoMode::STREAM) {
+    num_writes_ += 1;
+    WritePagePositional(page_id, page_data);
+  } else {
+    WritePageStream(page_id, page_data);
+  }
+  write_latencies_.RecordSince(start);
+}
+
+/**
+ * Write a page through the fstream, flushing it
+ */
+void DiskManager::WritePageStream(page_id_t page_id, const char *page_data) {
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
   // set write cursor to offset
@@ -104,12 +240,26 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  const auto start = std::chrono::steady_clock::now();
+  if (io_mode_ != DiskIoMode::STREAM) {
+    ReadPagePositional(page_id, page_data);
+  } else {
+    ReadPageStream(page_id, page_data);
+  }
+  read_latencies_.RecordSince(start);
+}
+
+/**
+ * Read a page through the fstream, checking the file size first
+ */
+void DiskManager::ReadPageStream(page_id_t page_id, char *page_data) {
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   int offset = page_id * PAGE_SIZE;
   // check if read beyond file length
   if (offset > GetFileSize(file_name_)) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
+    // a page that was allocated but never written, e.g. before a crash, reads as zeros like in the io_uring mode
+    memset(page_data, 0, PAGE_SIZE);
   } else {
     // set read cursor to offset
     db_io_.seekp(offset);
@@ -129,6 +279,389 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   }
 }
 
+/**
+ * Write a run of consecutive pages: one seek and one flush in STREAM mode, pwritev calls otherwise
+ */
+void DiskManager::WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) {
+  if (pages.empty()) {
+    return;
+  }
+  num_writes_ += static_cast<int>(pages.size());
+  const int64_t offset = static_cast<int64_t>(first_page_id) * PAGE_SIZE;
+  if (io_mode_ == DiskIoMode::STREAM) {
+    const auto start = std::chrono::steady_clock::now();
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    db_io_.seekp(offset);
+    for (const char *page_data : pages) {
+      db_io_.write(page_data, PAGE_SIZE);
+    }
+    if (db_io_.bad()) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    db_io_.flush();
+    write_latencies_.RecordSince(start);
+    return;
+  }
+  for (size_t begin = 0; begin < pages.size(); begin += MAX_PAGES_PER_WRITE) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t end = std::min(pages.size(), begin + MAX_PAGES_PER_WRITE);
+    std::vector<iovec> iovecs;
+    iovecs.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+      iovecs.push_back({const_cast<char *>(pages[i]), static_cast<size_t>(PAGE_SIZE)});
+    }
+    // with direct I/O, a run holding an unaligned buffer is written page by page through the bounce buffer
+    const bool aligned = std::none_of(pages.begin() + begin, pages.begin() + end,
+                                      [this](const char *page_data) { return NeedsBounceBuffer(page_data); });
+    ssize_t rc = -1;
+    while (aligned) {
+      rc = pwritev(db_fd_, iovecs.data(), static_cast<int>(iovecs.size()), offset + begin * PAGE_SIZE);
+      if (rc >= 0 || errno != EINTR) {
+        break;
+      }
+    }
+    // only what made it to the file grows its size, the pages a failed or short write did not get to are written
+    // one by one and grow it themselves
+    const size_t written_pages = rc < 0 ? 0 : static_cast<size_t>(rc) / PAGE_SIZE;
+    if (written_pages > 0) {
+      GrowFileSize(offset + (begin + written_pages) * PAGE_SIZE);
+    }
+    for (size_t i = begin + written_pages; i < end; ++i) {
+      WritePagePositional(first_page_id + static_cast<page_id_t>(i), pages[i]);
+    }
+    write_latencies_.RecordSince(start);
+  }
+}
+
+/**
+ * Write a page with pwrite, which does not move a shared file offset and so needs no latch
+ */
+void DiskManager::WritePagePositional(page_id_t page_id, const char *page_data) {
+  const int64_t offset = static_cast<int64_t>(page_id) * PAGE_SIZE;
+  alignas(DIRECT_IO_ALIGNMENT) char bounce[PAGE_SIZE];
+  if (NeedsBounceBuffer(page_data)) {
+    memcpy(bounce, page_data, PAGE_SIZE);
+    page_data = bounce;
+  }
+  size_t written = 0;
+  while (written < static_cast<size_t>(PAGE_SIZE)) {
+    ssize_t rc = pwrite(db_fd_, page_data + written, PAGE_SIZE - written, offset + written);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+  GrowFileSize(offset + PAGE_SIZE);
+}
+
+/**
+ * Grow the cached file size if a write ends past it
+ */
+void DiskManager::GrowFileSize(int64_t end) {
+  int64_t file_size = db_file_size_.load();
+  while (file_size < end && !db_file_size_.compare_exchange_weak(file_size, end)) {
+  }
+}
+
+/**
+ * Read a page with pread, checking the cached file size instead of calling stat
+ */
+void DiskManager::ReadPagePositional(page_id_t page_id, char *page_data) {
+  const int64_t offset = static_cast<int64_t>(page_id) * PAGE_SIZE;
+  // check if read beyond file length
+  if (offset >= db_file_size_.load()) {
+    LOG_DEBUG("I/O error reading past end of file");
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  alignas(DIRECT_IO_ALIGNMENT) char bounce[PAGE_SIZE];
+  char *buffer = NeedsBounceBuffer(page_data) ? bounce : page_data;
+  size_t read_count = 0;
+  while (read_count < static_cast<size_t>(PAGE_SIZE)) {
+    ssize_t rc = pread(db_fd_, buffer + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while reading");
+      return;
+    }
+    if (rc == 0) {
+      break;
+    }
+    read_count += rc;
+  }
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, read_count);
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < static_cast<size_t>(PAGE_SIZE)) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+}
+
+/**
+ * Start a batch of page reads and writes: on the io_uring if there is one, synchronously otherwise
+ */
+std::future<void> DiskManager::SubmitPageIo(std::vector<PageIoRequest> requests, bool ordered) {
+  if (io_uring_ == nullptr) {
+    for (size_t i = 0; i < requests.size();) {
+      const auto &request = requests[i];
+      if (!request.is_write_) {
+        ReadPage(request.page_id_, request.data_);
+        i++;
+        continue;
+      }
+      const size_t end = WriteRunEnd(requests, i);
+      std::vector<const char *> pages;
+      for (; i < end; ++i) {
+        pages.push_back(requests[i].data_);
+      }
+      WritePages(request.page_id_, pages);
+    }
+    std::promise<void> done;
+    done.set_value();
+    return done.get_future();
+  }
+
+  std::vector<IoUringQueue::Op> ops;
+  ops.reserve(requests.size());
+  for (size_t i = 0; i < requests.size();) {
+    const auto &request = requests[i];
+    const int64_t offset = static_cast<int64_t>(request.page_id_) * PAGE_SIZE;
+    if (!request.is_write_) {
+      ops.push_back({false, request.data_, static_cast<uint32_t>(PAGE_SIZE), offset});
+      i++;
+      continue;
+    }
+    const size_t end = WriteRunEnd(requests, i);
+    IoUringQueue::Op op{true, request.data_, static_cast<uint32_t>((end - i) * PAGE_SIZE), offset};
+    if (end - i > 1) {
+      for (size_t j = i; j < end; ++j) {
+        op.iovecs_.push_back({requests[j].data_, static_cast<size_t>(PAGE_SIZE)});
+      }
+    }
+    num_writes_ += static_cast<int>(end - i);
+    GrowFileSize(offset + op.len_);
+    ops.push_back(std::move(op));
+    i = end;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  return io_uring_->Submit(std::move(ops), ordered, [this, start](const IoUringQueue::Op &op, int result) {
+    FinishPageIo(op, result);
+    (op.is_write_ ? write_latencies_ : read_latencies_).RecordSince(start);
+  });
+}
+
+/**
+ * Find where a run of writes to consecutive pages ends, capped at MAX_PAGES_PER_WRITE pages
+ */
+size_t DiskManager::WriteRunEnd(const std::vector<PageIoRequest> &requests, size_t begin) {
+  size_t end = begin + 1;
+  while (end < requests.size() && end - begin < MAX_PAGES_PER_WRITE && requests[end].is_write_ &&
+         requests[end].page_id_ == requests[end - 1].page_id_ + 1) {
+    end++;
+  }
+  return end;
+}
+
+/**
+ * Called on the io_uring completion thread for each finished page I/O. With direct I/O, an op on an unaligned buffer
+ * fails with EINVAL and is redone here, synchronously through the bounce buffer.
+ */
+void DiskManager::FinishPageIo(const IoUringQueue::Op &op, int result) {
+  if (result == static_cast<int>(op.len_)) {
+    return;
+  }
+  const auto page_id = static_cast<page_id_t>(op.offset_ / PAGE_SIZE);
+  if (op.is_write_) {
+    // a failed or short write is redone synchronously, from the first page it did not get to
+    LOG_DEBUG("asynchronous write failed, retrying synchronously");
+    if (op.iovecs_.empty()) {
+      WritePagePositional(page_id, op.data_);
+      return;
+    }
+    const size_t written_pages = result < 0 ? 0 : static_cast<size_t>(result) / PAGE_SIZE;
+    for (size_t i = written_pages; i < op.iovecs_.size(); ++i) {
+      WritePagePositional(page_id + static_cast<page_id_t>(i), static_cast<const char *>(op.iovecs_[i].iov_base));
+    }
+  } else if (result >= 0) {
+    // the file ends before this page does
+    memset(op.data_ + result, 0, PAGE_SIZE - result);
+  } else {
+    // a failed read, or one cancelled because the write before it in the chain failed
+    memset(op.data_, 0, PAGE_SIZE);
+    ReadPagePositional(page_id, op.data_);
+  }
+}
+
+/**
+ * Force all written pages to disk
+ */
+void DiskManager::SyncPages() {
+  WriteFreeSpaceMap();
+  const auto start = std::chrono::steady_clock::now();
+  if (io_mode_ != DiskIoMode::STREAM) {
+    if (db_fd_ >= 0 && fsync(db_fd_) != 0) {
+      LOG_DEBUG("I/O error while syncing");
+    }
+  } else {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    db_io_.flush();
+  }
+  sync_latencies_.RecordSince(start);
+}
+
+/**
+ * Hand out the lowest free page that belongs to the given buffer pool instance
+ */
+page_id_t DiskManager::AllocateFreePage(uint32_t num_instances, uint32_t instance_index) {
+  std::scoped_lock scoped_fsm_latch(fsm_latch_);
+  if (free_pages_.size() != num_instances) {
+    // the free pages are split by instance once, on the first allocation of a parallel buffer pool
+    std::vector<std::set<page_id_t>> free_pages(num_instances);
+    for (const auto &instance_free_pages : free_pages_) {
+      for (page_id_t page_id : instance_free_pages) {
+        free_pages[page_id % num_instances].insert(page_id);
+      }
+    }
+    free_pages_ = std::move(free_pages);
+  }
+  auto &instance_free_pages = free_pages_[instance_index];
+  if (instance_free_pages.empty()) {
+    return INVALID_PAGE_ID;
+  }
+  const page_id_t page_id = *instance_free_pages.begin();
+  instance_free_pages.erase(instance_free_pages.begin());
+  num_free_pages_--;
+  ClearFreeBitLocked(page_id);
+  return page_id;
+}
+
+/**
+ * Take a page off the free list if it is on it
+ */
+void DiskManager::ClaimPage(page_id_t page_id) {
+  std::scoped_lock scoped_fsm_latch(fsm_latch_);
+  if (page_id < 0 || static_cast<size_t>(page_id / 8) >= fsm_bitmap_.size() ||
+      (fsm_bitmap_[page_id / 8] & (1U << (page_id % 8))) == 0) {
+    return;
+  }
+  free_pages_[page_id % free_pages_.size()].erase(page_id);
+  num_free_pages_--;
+  ClearFreeBitLocked(page_id);
+}
+
+/**
+ * Clear the free bit of a page, SyncPages writes it
+ */
+void DiskManager::ClearFreeBitLocked(page_id_t page_id) {
+  fsm_bitmap_[page_id / 8] &= static_cast<uint8_t>(~(1U << (page_id % 8)));
+  fsm_dirty_pages_.insert(page_id / FSM_BITS_PER_PAGE);
+}
+
+/**
+ * Mark a page free in the free space map
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  if (page_id < 0) {
+    return;
+  }
+  std::scoped_lock scoped_fsm_latch(fsm_latch_);
+  if (!free_pages_[page_id % free_pages_.size()].insert(page_id).second) {
+    LOG_DEBUG("page %d deallocated twice", page_id);
+    return;
+  }
+  num_free_pages_++;
+  // the bitmap grows a whole bitmap page at a time, which is also the unit it is written in
+  const size_t fsm_page = page_id / FSM_BITS_PER_PAGE;
+  if (fsm_bitmap_.size() < (fsm_page + 1) * PAGE_SIZE) {
+    fsm_bitmap_.resize((fsm_page + 1) * PAGE_SIZE);
+  }
+  fsm_bitmap_[page_id / 8] |= static_cast<uint8_t>(1U << (page_id % 8));
+  fsm_dirty_pages_.insert(fsm_page);
+}
+
+/**
+ * Returns the number of free pages
+ */
+size_t DiskManager::GetNumFreePages() {
+  std::scoped_lock scoped_fsm_latch(fsm_latch_);
+  return num_free_pages_;
+}
+
+/**
+ * Returns the size of the db file in bytes
+ */
+int64_t DiskManager::GetDbFileSize() {
+  if (io_mode_ != DiskIoMode::STREAM) {
+    return db_file_size_;
+  }
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  return GetFileSize(file_name_);
+}
+
+/**
+ * Write the bitmap pages changed since the last call to the free space map file and sync it. The pages are copied
+ * under fsm_latch_ and written without it, so allocations never wait for the disk.
+ */
+void DiskManager::WriteFreeSpaceMap() {
+  std::scoped_lock scoped_fsm_io_latch(fsm_io_latch_);
+  std::vector<std::pair<size_t, std::vector<uint8_t>>> fsm_pages;
+  {
+    std::scoped_lock scoped_fsm_latch(fsm_latch_);
+    if (fsm_fd_ < 0 || fsm_dirty_pages_.empty()) {
+      return;
+    }
+    for (size_t fsm_page : fsm_dirty_pages_) {
+      const size_t offset = fsm_page * PAGE_SIZE;
+      const size_t size = std::min<size_t>(PAGE_SIZE, fsm_bitmap_.size() - offset);
+      fsm_pages.emplace_back(fsm_page, std::vector<uint8_t>(fsm_bitmap_.begin() + offset,
+                                                            fsm_bitmap_.begin() + offset + size));
+    }
+    fsm_dirty_pages_.clear();
+  }
+  for (const auto &[fsm_page, data] : fsm_pages) {
+    if (!WriteFreeSpaceMapPage(fsm_page, data)) {
+      // the next call writes them again
+      std::scoped_lock scoped_fsm_latch(fsm_latch_);
+      for (const auto &fsm_page_copy : fsm_pages) {
+        fsm_dirty_pages_.insert(fsm_page_copy.first);
+      }
+      return;
+    }
+  }
+  if (fsync(fsm_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing the free space map");
+  }
+}
+
+/**
+ * Write one page of the free-page bitmap to the free space map file
+ */
+bool DiskManager::WriteFreeSpaceMapPage(size_t fsm_page, const std::vector<uint8_t> &data) {
+  const size_t offset = fsm_page * PAGE_SIZE;
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t rc = pwrite(fsm_fd_, data.data() + written, data.size() - written, offset + written);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while writing the free space map");
+      return false;
+    }
+    written += rc;
+  }
+  return true;
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -160,6 +693,10 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
   // needs to flush to keep disk file in sync
   log_io_.flush();
+  // and to sync it for the log records to survive a crash, committed transactions wait for this
+  if (fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing log");
+  }
   flush_log_ = false;
 }
 
@@ -168,7 +705,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-bool DiskManager::ReadLog(char *log_data, int size, int offset) {
+bool DiskManager::ReadLog(char *log_data, int size, int64_t offset) {
   if (offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
@@ -191,6 +728,68 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
   return true;
 }
 
+/**
+ * Returns the size of the log file in bytes, 0 if there is none
+ */
+int64_t DiskManager::GetLogFileSize() { return std::max<int64_t>(GetFileSize(log_name_), 0); }
+
+/**
+ * Replace the master record: write it to a temporary file, sync it and rename it over the old one, so that a crash
+ * leaves either the old or the new record behind
+ */
+void DiskManager::WriteMasterRecord(const char *data, size_t size) {
+  const std::string tmp_name = master_name_ + ".tmp";
+  int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't open master record file");
+    return;
+  }
+  size_t written = 0;
+  while (written < size) {
+    ssize_t rc = pwrite(fd, data + written, size - written, written);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while writing the master record");
+      close(fd);
+      return;
+    }
+    written += rc;
+  }
+  if (fsync(fd) != 0) {
+    LOG_DEBUG("I/O error while syncing the master record");
+  }
+  close(fd);
+  if (rename(tmp_name.c_str(), master_name_.c_str()) != 0) {
+    LOG_DEBUG("I/O error while renaming the master record");
+  }
+}
+
+/**
+ * Read the master record written by WriteMasterRecord
+ * @return: false if there is none
+ */
+bool DiskManager::ReadMasterRecord(char *data, size_t size) {
+  int fd = open(master_name_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t rc = pread(fd, data + read_count, size - read_count, read_count);
+    if (rc <= 0) {
+      if (rc < 0 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    read_count += rc;
+  }
+  close(fd);
+  return read_count == size;
+}
+
 /**
  * Returns number of flushes made so far
  */
@@ -209,10 +808,10 @@ bool DiskManager::GetFlushState() const { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
 }
 
 }  // namespace bustub
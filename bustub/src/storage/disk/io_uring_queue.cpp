@@ -0,0 +1,322 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring_queue.cpp
+//
+// Identification: src/storage/disk/io_uring_queue.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_uring_queue.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BUSTUB_HAS_IO_URING
+#endif
+
+#include "common/logger.h"
+
+namespace bustub {
+
+/** A submitted batch, alive until its last operation is reaped. */
+struct IoUringQueue::Batch {
+  /** What an entry's user_data points to: the batch and the index of the operation. */
+  struct Slot {
+    Batch *batch_;
+    size_t index_;
+  };
+
+  std::vector<Op> ops_;
+  std::vector<Slot> slots_;
+  completion_fn on_complete_;
+  /** Operations not completed yet. The batch is resolved and deleted by whoever completes the last one. */
+  std::atomic<size_t> pending_{0};
+  std::promise<void> done_;
+};
+
+#ifdef BUSTUB_HAS_IO_URING
+
+namespace {
+
+/** user_data of the no-op that wakes up the completion thread. */
+constexpr uint64_t WAKE_UP_USER_DATA = 0;
+
+}  // namespace
+
+IoUringQueue::IoUringQueue(int fd, uint32_t entries) : fd_(fd) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (ring_fd < 0) {
+    LOG_DEBUG("io_uring is not available");
+    return;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  cq_ring_ = single_mmap ? sq_ring_
+                         : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                                IORING_OFF_CQ_RING);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+    LOG_DEBUG("io_uring ring mapping failed");
+    for (auto [ptr, size] : {std::pair{sq_ring_, sq_ring_size_}, std::pair{sqes_, sqes_size_}}) {
+      if (ptr != MAP_FAILED) {
+        munmap(ptr, size);
+      }
+    }
+    if (!single_mmap && cq_ring_ != MAP_FAILED) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    close(ring_fd);
+    return;
+  }
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<uint32_t *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  sq_entries_ = params.sq_entries;
+  cq_entries_ = params.cq_entries;
+  ring_fd_ = ring_fd;
+  completion_thread_ = std::thread(&IoUringQueue::ReapCompletions, this);
+}
+
+IoUringQueue::~IoUringQueue() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    // Operations in flight still use their buffers, let them finish first.
+    cv_.wait(lock, [&] { return in_flight_ == 0; });
+    stop_ = true;
+    SubmitWakeUpLocked();
+  }
+  completion_thread_.join();
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+}
+
+std::future<void> IoUringQueue::Submit(std::vector<Op> ops, bool linked, completion_fn on_complete) {
+  BUSTUB_ASSERT(IsOpen(), "io_uring is not available.");
+  BUSTUB_ASSERT(!linked || ops.size() <= sq_entries_, "A linked batch must fit into the submission queue.");
+  auto *batch = new Batch();
+  batch->ops_ = std::move(ops);
+  batch->on_complete_ = std::move(on_complete);
+  std::future<void> done = batch->done_.get_future();
+  const size_t count = batch->ops_.size();
+  if (count == 0) {
+    batch->done_.set_value();
+    delete batch;
+    return done;
+  }
+  batch->pending_ = count;
+  for (size_t i = 0; i < count; ++i) {
+    batch->slots_.push_back({batch, i});
+  }
+
+  // The operations that could not be submitted, with their error.
+  std::vector<std::pair<size_t, int>> failed;
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    const size_t chunk_size = linked ? count : std::min<size_t>(sq_entries_, cq_entries_ / 2);
+    for (size_t begin = 0; begin < count; begin += chunk_size) {
+      const size_t end = std::min(count, begin + chunk_size);
+      // Leave room for the wake-up no-op, and never let more completions pile up than the completion queue holds.
+      cv_.wait(lock, [&] { return in_flight_ + (end - begin) + 1 <= cq_entries_; });
+      int error = 0;
+      for (size_t i = SubmitLocked(batch, begin, end, linked, &error); i < end; ++i) {
+        failed.emplace_back(i, error);
+      }
+    }
+  }
+  if (failed.empty()) {
+    return done;
+  }
+  // The owner falls back to synchronous I/O, which must not hold up the other submitters and the completion thread.
+  for (const auto &[index, error] : failed) {
+    batch->on_complete_(batch->ops_[index], -error);
+  }
+  // The completion thread never sees these, so the batch is resolved here if nothing else is outstanding.
+  if (batch->pending_.fetch_sub(failed.size()) == failed.size()) {
+    batch->done_.set_value();
+    delete batch;
+  }
+  return done;
+}
+
+size_t IoUringQueue::SubmitLocked(Batch *batch, size_t begin, size_t end, bool linked, int *error) {
+  // Entries the kernel has not consumed yet must not be overwritten. Each submission hands all of its entries to the
+  // kernel or takes them back, so the queue is normally empty here; only what fits is queued, and a linked batch goes
+  // in whole or not at all.
+  uint32_t tail = *sq_tail_;
+  const uint32_t free_slots = sq_entries_ - (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE));
+  size_t queue_end = std::min<size_t>(end, begin + free_slots);
+  if (linked && queue_end < end) {
+    queue_end = begin;
+  }
+  auto *sqes = static_cast<io_uring_sqe *>(sqes_);
+  for (size_t i = begin; i < queue_end; ++i) {
+    const Op &op = batch->ops_[i];
+    const uint32_t index = tail & *sq_mask_;
+    io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = fd_;
+    if (op.iovecs_.empty()) {
+      sqe->opcode = op.is_write_ ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe->addr = reinterpret_cast<uint64_t>(op.data_);
+      sqe->len = op.len_;
+    } else {
+      sqe->opcode = op.is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+      sqe->addr = reinterpret_cast<uint64_t>(op.iovecs_.data());
+      sqe->len = static_cast<uint32_t>(op.iovecs_.size());
+    }
+    sqe->off = static_cast<uint64_t>(op.offset_);
+    sqe->user_data = reinterpret_cast<uint64_t>(&batch->slots_[i]);
+    if (linked && i + 1 < queue_end) {
+      sqe->flags |= IOSQE_IO_LINK;
+    }
+    sq_array_[index] = index;
+    tail++;
+  }
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+  *error = EBUSY;
+  const uint32_t submitted = Enter();
+  if (submitted < queue_end - begin) {
+    *error = errno;
+  }
+  in_flight_ += submitted;
+  // What the kernel did not consume is taken back, and what did not fit is not queued at all.
+  __atomic_store_n(sq_tail_, __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+  return begin + submitted;
+}
+
+void IoUringQueue::SubmitWakeUpLocked() {
+  uint32_t tail = *sq_tail_;
+  if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == sq_entries_) {
+    LOG_DEBUG("io_uring submission queue full, no room for the wake-up");
+    return;
+  }
+  const uint32_t index = tail & *sq_mask_;
+  io_uring_sqe *sqe = &static_cast<io_uring_sqe *>(sqes_)[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_NOP;
+  sqe->user_data = WAKE_UP_USER_DATA;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  if (Enter() == 0) {
+    LOG_DEBUG("io_uring wake-up failed");
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    return;
+  }
+  in_flight_++;
+}
+
+uint32_t IoUringQueue::Enter() {
+  uint32_t submitted = 0;
+  while (true) {
+    // The kernel advances the head past every entry it consumes, the ones between it and the tail are still queued.
+    const uint32_t queued = *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (queued == 0) {
+      return submitted;
+    }
+    int rc = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, queued, 0, 0, nullptr, 0));
+    if (rc < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        std::this_thread::yield();
+        continue;
+      }
+      return submitted;
+    }
+    submitted += rc;
+  }
+}
+
+void IoUringQueue::ReapCompletions() {
+  std::vector<std::pair<Batch::Slot *, int>> completed;
+  bool stop = false;
+  while (!stop) {
+    int rc = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (rc < 0 && errno != EINTR) {
+      LOG_DEBUG("io_uring wait failed");
+    }
+    {
+      // Taking the latch also orders this thread after the submitters of the batches being reaped.
+      std::scoped_lock lock{latch_};
+      uint32_t head = *cq_head_;
+      const uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      auto *cqes = static_cast<io_uring_cqe *>(cqes_);
+      for (; head != tail; ++head) {
+        const io_uring_cqe &cqe = cqes[head & *cq_mask_];
+        if (cqe.user_data == WAKE_UP_USER_DATA) {
+          stop = stop_;
+        } else {
+          completed.emplace_back(reinterpret_cast<Batch::Slot *>(cqe.user_data), cqe.res);
+        }
+        in_flight_--;
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+    cv_.notify_all();
+
+    for (const auto &[slot, result] : completed) {
+      Batch *batch = slot->batch_;
+      batch->on_complete_(batch->ops_[slot->index_], result);
+      if (batch->pending_.fetch_sub(1) == 1) {
+        batch->done_.set_value();
+        delete batch;
+      }
+    }
+    completed.clear();
+  }
+}
+
+#else
+
+IoUringQueue::IoUringQueue(int fd, uint32_t entries) : fd_(fd) {}
+
+IoUringQueue::~IoUringQueue() = default;
+
+std::future<void> IoUringQueue::Submit(std::vector<Op> ops, bool linked, completion_fn on_complete) {
+  UNREACHABLE("io_uring is not available.");
+}
+
+size_t IoUringQueue::SubmitLocked(Batch *batch, size_t begin, size_t end, bool linked, int *error) { return begin; }
+
+void IoUringQueue::SubmitWakeUpLocked() {}
+
+uint32_t IoUringQueue::Enter() { return 0; }
+
+void IoUringQueue::ReapCompletions() {}
+
+#endif
+
+}  // namespace bustub
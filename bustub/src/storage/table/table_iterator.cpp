@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
 
 #include "storage/table/table_heap.h"
@@ -19,7 +20,7 @@ namespace bustub {
 TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
     : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, AccessType::Scan);
   }
 }
 
@@ -36,7 +37,7 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId(), AccessType::Scan));
   cur_page->RLatch();
   assert(cur_page != nullptr);  // all pages are pinned
 
@@ -44,11 +45,13 @@ TableIterator &TableIterator::operator++() {
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+      auto next_page =
+          static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId(), AccessType::Scan));
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
       cur_page->RLatch();
+      ReadAhead(cur_page);
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -57,7 +60,7 @@ TableIterator &TableIterator::operator++() {
   tuple_->rid_ = next_tuple_rid;
 
   if (*this != table_heap_->End()) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, AccessType::Scan);
   }
   // release until copy the tuple
   cur_page->RUnlatch();
@@ -65,6 +68,25 @@ TableIterator &TableIterator::operator++() {
   return *this;
 }
 
+void TableIterator::ReadAhead(TablePage *page) {
+  if (pages_until_read_ahead_ > 0) {
+    pages_until_read_ahead_--;
+    return;
+  }
+  page_id_t next_page_id = page->GetNextPageId();
+  if (next_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  // Pages read too far ahead would be evicted again before the scan gets to them.
+  const size_t max_window = std::max<size_t>(1, std::min(MAX_READ_AHEAD_PAGES, buffer_pool_manager->GetPoolSize() / 4));
+  read_ahead_window_ = std::min(std::max(MIN_READ_AHEAD_PAGES, read_ahead_window_ * 2), max_window);
+  buffer_pool_manager->PrefetchPages(next_page_id, read_ahead_window_, [](Page *next_page) {
+    return static_cast<TablePage *>(next_page)->GetNextPageId();
+  });
+  pages_until_read_ahead_ = read_ahead_window_ / 2;
+}
+
 TableIterator TableIterator::operator++(int) {
   TableIterator clone(*this);
   ++(*this);
@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer_test.cpp
+//
+// Identification: test/buffer/arc_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(ArcReplacerTest, SampleTest) {
+  ArcReplacer replacer(4);
+  for (frame_id_t frame_id = 0; frame_id < 4; ++frame_id) {
+    replacer.RecordLoad(frame_id, frame_id);
+    replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(4, replacer.Size());
+
+  // Pages 0 and 1 are referenced again and move to T2. T1 is above its target of 0 and gives the victim.
+  replacer.RecordAccess(0);
+  replacer.RecordAccess(1);
+  frame_id_t value;
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Page 2 comes back while B1 remembers it: T1 was too small.
+  replacer.RecordLoad(2, 2);
+  replacer.Unpin(2);
+  EXPECT_EQ(1, replacer.GetTarget());
+
+  // T1 (page 3) is at its target, so T2 gives the victim, least recently used first.
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Page 0 comes back while B2 remembers it: T2 was too small.
+  replacer.RecordLoad(0, 0);
+  replacer.Unpin(0);
+  EXPECT_EQ(0, replacer.GetTarget());
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // A scan leaves its page in T1, even when it is touched again.
+  replacer.RecordLoad(3, 10, AccessType::Scan);
+  replacer.RecordAccess(3, AccessType::Scan);
+  replacer.Unpin(3);
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // T2 holds frames 1, 2, 0. Pinned frames are skipped, removed ones are forgotten.
+  replacer.Pin(1);
+  replacer.Remove(2);
+  EXPECT_EQ(1, replacer.Size());
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  EXPECT_FALSE(replacer.Victim(&value));
+  replacer.Unpin(1);
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(0, replacer.Size());
+}
+
+TEST(ArcReplacerTest, ScanResistanceTest) {
+  // A hot set of four pages referenced twice sits in T2; a long scan of one-time pages only cycles through T1.
+  ArcReplacer replacer(8);
+  for (frame_id_t frame_id = 0; frame_id < 4; ++frame_id) {
+    replacer.RecordLoad(frame_id, frame_id);
+    replacer.RecordAccess(frame_id);
+    replacer.Unpin(frame_id);
+  }
+  for (frame_id_t frame_id = 4; frame_id < 8; ++frame_id) {
+    replacer.RecordLoad(frame_id, frame_id);
+    replacer.Unpin(frame_id);
+  }
+  frame_id_t value;
+  for (page_id_t page_id = 100; page_id < 200; ++page_id) {
+    ASSERT_TRUE(replacer.Victim(&value));
+    EXPECT_LE(4, value);
+    replacer.RecordLoad(value, page_id);
+    replacer.Unpin(value);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,294 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_benchmark_test.cpp
+//
+// Identification: test/buffer/buffer_pool_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// The benchmarks are disabled in the unit tests, run them with --gtest_also_run_disabled_tests.
+
+namespace {
+
+/**
+ * Run op(thread_id, rng) ops_per_thread times on each of num_threads threads.
+ * @return the aggregate throughput in operations per second
+ */
+template <class Op>
+double RunThreads(size_t num_threads, size_t ops_per_thread, Op op) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&op, tid, ops_per_thread] {
+      std::default_random_engine rng(tid);
+      for (size_t i = 0; i < ops_per_thread; ++i) {
+        op(tid, &rng);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(num_threads * ops_per_thread) / elapsed.count();
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+// Random fetches from a table 64 times larger than the pool, so that nearly every fetch is a miss, with a write-back
+// for every fourth one. Compares the disk manager modes: STREAM (latched fstream), POSITIONAL (pread/pwrite) and
+// IO_URING (write-back and read of a miss as one linked submission).
+TEST(DISABLED_BufferPoolBenchmarkTest, MissPathTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 64 * static_cast<int>(buffer_pool_size);
+  const size_t ops_per_thread = 2000;
+
+  remove(db_name.c_str());
+  {
+    DiskManager disk_manager(db_name, DiskIoMode::POSITIONAL);
+    char buf[PAGE_SIZE] = {0};
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      disk_manager.WritePage(page_id, buf);
+    }
+    disk_manager.ShutDown();
+  }
+
+  std::cout << "threads  stream(ops/s)  positional(ops/s)  io_uring(ops/s)" << std::endl;
+  for (size_t num_threads : {1, 4, 16, 32}) {
+    std::cout << num_threads;
+    for (DiskIoMode io_mode : {DiskIoMode::STREAM, DiskIoMode::POSITIONAL, DiskIoMode::IO_URING}) {
+      auto *disk_manager = new DiskManager(db_name, io_mode);
+      auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+      auto miss = [bpm, num_pages](size_t tid, std::default_random_engine *rng) {
+        auto page_id = static_cast<page_id_t>((*rng)() % num_pages);
+        Page *page = bpm->FetchPage(page_id);
+        if (page != nullptr) {
+          bpm->UnpinPage(page_id, page_id % 4 == 0);
+        }
+      };
+      double rate = RunThreads(num_threads, ops_per_thread, miss);
+      std::cout << "  " << static_cast<uint64_t>(rate);
+      delete bpm;
+      disk_manager->ShutDown();
+      delete disk_manager;
+    }
+    std::cout << std::endl;
+  }
+
+  remove(db_name.c_str());
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+// Fetch/unpin of resident pages from many threads. The "single latch" column wraps every call in one global mutex,
+// which is what the hit path cost when the page table shared the instance latch.
+TEST(DISABLED_BufferPoolBenchmarkTest, HitPathTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t ops_per_thread = 20000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    ASSERT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  auto hit = [bpm, buffer_pool_size](size_t tid, std::default_random_engine *rng) {
+    auto page_id = static_cast<page_id_t>((*rng)() % buffer_pool_size);
+    Page *page = bpm->FetchPage(page_id);
+    EXPECT_NE(nullptr, page);
+    bpm->UnpinPage(page_id, false);
+  };
+  std::mutex global_latch;
+  auto hit_single_latch = [&global_latch, &hit](size_t tid, std::default_random_engine *rng) {
+    std::scoped_lock lock{global_latch};
+    hit(tid, rng);
+  };
+
+  std::cout << "threads  sharded(ops/s)  single latch(ops/s)" << std::endl;
+  for (size_t num_threads : {1, 2, 4, 8, 16}) {
+    double sharded = RunThreads(num_threads, ops_per_thread, hit);
+    double single = RunThreads(num_threads, ops_per_thread, hit_single_latch);
+    std::cout << num_threads << "  " << static_cast<uint64_t>(sharded) << "  " << static_cast<uint64_t>(single)
+              << std::endl;
+  }
+
+  // No pin may leak: every page is fetched exactly once more.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    Page *page = bpm->FetchPage(static_cast<page_id_t>(i));
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(true, bpm->UnpinPage(static_cast<page_id_t>(i), false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// New pages from many threads on a parallel buffer pool, the allocation path of an insert-heavy workload. The
+// "global latch" column wraps every NewPage in one mutex, which is what allocation cost when NewPgImp took latch_.
+TEST(DISABLED_BufferPoolBenchmarkTest, NewPageTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 16;
+  const size_t buffer_pool_size = 64;
+  const size_t ops_per_thread = 2000;
+
+  std::cout << "threads  global latch  round robin  load aware  thread affinity (ops/s)" << std::endl;
+  for (size_t num_threads : {1, 4, 16, 32}) {
+    std::cout << num_threads;
+    for (int column = 0; column < 4; ++column) {
+      remove(db_name.c_str());
+      auto *disk_manager = new DiskManager(db_name, DiskIoMode::POSITIONAL);
+      auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+      const InstanceSelection selections[] = {InstanceSelection::ROUND_ROBIN, InstanceSelection::ROUND_ROBIN,
+                                              InstanceSelection::LOAD_AWARE, InstanceSelection::THREAD_AFFINITY};
+      bpm->SetInstanceSelection(selections[column]);
+      std::mutex global_latch;
+      auto new_page = [bpm, column, &global_latch](size_t tid, std::default_random_engine *rng) {
+        page_id_t page_id;
+        Page *page;
+        if (column == 0) {
+          std::scoped_lock lock{global_latch};
+          page = bpm->NewPage(&page_id);
+        } else {
+          page = bpm->NewPage(&page_id);
+        }
+        if (page != nullptr) {
+          bpm->UnpinPage(page_id, false);
+        }
+      };
+      double rate = RunThreads(num_threads, ops_per_thread, new_page);
+      std::cout << "  " << static_cast<uint64_t>(rate);
+      delete bpm;
+      disk_manager->ShutDown();
+      delete disk_manager;
+    }
+    std::cout << std::endl;
+  }
+
+  remove(db_name.c_str());
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+// Random fetches from a table of text pages four times larger than the pool, without and with a compressed cache as
+// large as the pool itself. With the cache, the misses that it absorbs are a decompression instead of a disk read;
+// every eviction costs a compression though, so against a file the OS keeps in memory the cache is slower, and it pays
+// off once a read costs more than a few microseconds.
+TEST(DISABLED_BufferPoolBenchmarkTest, CompressedCacheTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 4 * static_cast<int>(buffer_pool_size);
+  const size_t ops = 20000;
+
+  remove(db_name.c_str());
+  {
+    DiskManager disk_manager(db_name, DiskIoMode::POSITIONAL);
+    char buf[PAGE_SIZE] = {0};
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      size_t offset = 0;
+      for (int i = 0; offset + 64 < PAGE_SIZE; ++i) {
+        offset += snprintf(buf + offset, 64, "%d|customer#%d|street %d|%s;", i, page_id * 100 + i, i % 37,
+                           i % 3 == 0 ? "BUILDING" : "MACHINERY");
+      }
+      disk_manager.WritePage(page_id, buf);
+    }
+    disk_manager.ShutDown();
+  }
+
+  std::cout << "cache(bytes)  ops/s  pool_hit%  cache_hit%  compression" << std::endl;
+  for (size_t budget : {static_cast<size_t>(0), buffer_pool_size * PAGE_SIZE}) {
+    auto *disk_manager = new DiskManager(db_name, DiskIoMode::POSITIONAL);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+    bpm->SetCompressedCacheSize(budget);
+    auto fetch = [bpm, num_pages](size_t tid, std::default_random_engine *rng) {
+      auto page_id = static_cast<page_id_t>((*rng)() % num_pages);
+      if (bpm->FetchPage(page_id) != nullptr) {
+        bpm->UnpinPage(page_id, false);
+      }
+    };
+    double rate = RunThreads(1, ops, fetch);
+    CompressedPageCache *cache = bpm->GetCompressedCache();
+    std::cout << budget << "  " << static_cast<uint64_t>(rate) << "  " << bpm->GetHitRatio() * 100 << "  "
+              << (cache == nullptr ? 0 : cache->GetHitRatio() * 100) << "  "
+              << (cache == nullptr ? 0 : cache->GetCompressionRatio()) << std::endl;
+    delete bpm;
+    disk_manager->ShutDown();
+    delete disk_manager;
+  }
+
+  remove(db_name.c_str());
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+// Fetch/unpin of random resident pages of a large pool, reading a random word of each page, with the frame arena on
+// small pages and on transparent huge pages. The pool spans far more 4 KiB pages than the TLB holds.
+TEST(DISABLED_BufferPoolBenchmarkTest, FrameArenaTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16384;
+  const size_t ops_per_thread = 200000;
+
+  std::cout << "threads  small_pages(ops/s)  huge_pages(ops/s)" << std::endl;
+  for (size_t num_threads : {1, 4}) {
+    std::cout << num_threads;
+    for (bool huge_pages : {false, true}) {
+      auto *disk_manager = new DiskManager(db_name);
+      auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::LRU_K, 2,
+                                                huge_pages);
+      page_id_t page_id;
+      for (size_t i = 0; i < buffer_pool_size; ++i) {
+        bpm->NewPage(&page_id);
+        bpm->UnpinPage(page_id, false);
+      }
+      std::atomic<uint64_t> sum{0};
+      auto hit = [bpm, &sum](size_t tid, std::default_random_engine *rng) {
+        const uint64_t r = (*rng)();
+        auto page_id = static_cast<page_id_t>(r % buffer_pool_size);
+        Page *page = bpm->FetchPage(page_id);
+        sum.fetch_add(page->GetData()[(r >> 20) % PAGE_SIZE], std::memory_order_relaxed);
+        bpm->UnpinPage(page_id, false);
+      };
+      double rate = RunThreads(num_threads, ops_per_thread, hit);
+      std::cout << "  " << static_cast<uint64_t>(rate);
+      delete bpm;
+      disk_manager->ShutDown();
+      delete disk_manager;
+      remove(db_name.c_str());
+    }
+    std::cout << std::endl;
+  }
+
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -11,9 +11,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -141,4 +146,757 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Many threads missing on a pool much smaller than the working set: every fetch evicts a dirty victim, so reads and
+// write-backs run concurrently with the latch released. Every page must still come back with its own contents.
+TEST(BufferPoolManagerInstanceTest, ConcurrentMissTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 64;
+  const int num_threads = 4;
+  const int rounds = 200;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<int> page_dist(0, num_pages - 1);
+      char expected[PAGE_SIZE];
+      for (int i = 0; i < rounds; ++i) {
+        page_id_t page_id = page_dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          // All frames are momentarily pinned by the other threads.
+          continue;
+        }
+        snprintf(expected, PAGE_SIZE, "page %d", page_id);
+        page->RLatch();
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        page->RUnlatch();
+        // Dirty every other unpin so that evictions keep having to write back.
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, i % 2 == 0));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Every frame is unpinned again, so all of them can be handed out.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Every replacement policy keeps pages intact and leaks no frame under concurrent misses, hits and scans.
+TEST(BufferPoolManagerInstanceTest, ReplacerPolicyTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 32;
+  const int num_threads = 4;
+  const int rounds = 200;
+
+  for (ReplacerPolicy policy : {ReplacerPolicy::LRU, ReplacerPolicy::LRU_K, ReplacerPolicy::TWO_Q, ReplacerPolicy::ARC,
+                                ReplacerPolicy::CLOCK}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, policy);
+
+    for (int i = 0; i < num_pages; ++i) {
+      page_id_t page_id_temp;
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    }
+
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([bpm, tid] {
+        std::default_random_engine rng(tid);
+        // Half of the fetches go to a hot set of four pages, the rest are scans over the whole table.
+        std::uniform_int_distribution<int> page_dist(0, num_pages - 1);
+        char expected[PAGE_SIZE];
+        for (int i = 0; i < rounds; ++i) {
+          const bool scan = i % 2 == 1;
+          page_id_t page_id = scan ? page_dist(rng) : page_dist(rng) % 4;
+          Page *page = bpm->FetchPage(page_id, scan ? AccessType::Scan : AccessType::Get);
+          if (page == nullptr) {
+            continue;
+          }
+          snprintf(expected, PAGE_SIZE, "page %d", page_id);
+          page->RLatch();
+          EXPECT_EQ(0, strcmp(page->GetData(), expected));
+          page->RUnlatch();
+          EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      page_id_t page_id_temp;
+      EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    }
+
+    disk_manager->ShutDown();
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
+
+// NOLINTNEXTLINE
+// The page cleaner writes back dirty, unpinned pages ahead of eviction, but never a page whose log is not persistent.
+TEST(BufferPoolManagerInstanceTest, PageCleanerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  // The page contents go after the LSN, which sits in the first 8 bytes of the page.
+  const size_t data_offset = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, log_manager);
+
+  // Wait until the cleaner has written back at least count pages, or give up after a few seconds.
+  auto wait_for_write_backs = [bpm](uint64_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (bpm->GetBackgroundWriteBacks() < count && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return bpm->GetBackgroundWriteBacks();
+  };
+
+  // Scenario: fill the pool with dirty pages whose log records (LSN 5) have not been flushed yet.
+  enable_logging = true;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData() + data_offset, PAGE_SIZE - data_offset, "page %d", page_id_temp);
+    page->SetLSN(5);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  // Page 0 stays pinned, the cleaner must leave it alone.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+
+  bpm->StartPageCleaner(buffer_pool_size, 0.0, std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(0U, bpm->GetBackgroundWriteBacks());
+
+  // Scenario: once the log is persistent up to the pages' LSN, the cleaner writes back every unpinned page.
+  log_manager->SetPersistentLSN(5);
+  EXPECT_EQ(buffer_pool_size - 1, wait_for_write_backs(buffer_pool_size - 1));
+  bpm->StopPageCleaner();
+  enable_logging = false;
+
+  // Scenario: new pages now find clean victims, no write-back happens on the foreground path.
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  for (size_t i = 1; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0U, bpm->GetForegroundWriteBacks());
+
+  // Scenario: the cleaned pages were written correctly.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    char expected[PAGE_SIZE];
+    snprintf(expected, PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(0, strcmp(page->GetData() + data_offset, expected));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete log_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// PrefetchPages walks a page chain in the background and leaves its pages resident and unpinned.
+TEST(BufferPoolManagerInstanceTest, PrefetchPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 20;
+
+  // Scenario: write a chain 0 -> 2 -> 4 -> ... -> 18, each page storing the id of the next one.
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    page_id_t next_page_id = i % 2 == 0 && i + 2 < num_pages ? i + 2 : INVALID_PAGE_ID;
+    memcpy(page->GetData(), &next_page_id, sizeof(page_id_t));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // Scenario: read ahead five pages of the chain into a cold buffer pool.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto next_page = [](Page *page) { return *reinterpret_cast<page_id_t *>(page->GetData()); };
+  bpm->PrefetchPages(0, 5, next_page);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (bpm->GetPrefetchedPages() < 5 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(5U, bpm->GetPrefetchedPages());
+
+  // The chain was followed and nothing stays pinned: the pages read back fine and all frames can be reused.
+  for (page_id_t page_id = 0; page_id < 10; page_id += 2) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id + 2, next_page(page));
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: the chain ends early, read-ahead stops there.
+  bpm->PrefetchPages(16, 5, next_page);
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (bpm->GetPrefetchedPages() < 7 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(7U, bpm->GetPrefetchedPages());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Deleted pages are reused by NewPage before the file grows, and come back zeroed.
+TEST(BufferPoolManagerInstanceTest, PageReuseTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: write twice as many pages as the pool holds, so that half of them are evicted to disk.
+  for (int i = 0; i < 2 * static_cast<int>(buffer_pool_size); ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: delete an evicted page and a resident one, they are reused lowest first.
+  EXPECT_EQ(true, bpm->DeletePage(1));
+  EXPECT_EQ(true, bpm->DeletePage(8));
+  EXPECT_EQ(2U, disk_manager->GetNumFreePages());
+  page_id_t page_id_temp;
+  char zeros[PAGE_SIZE] = {0};
+  for (page_id_t expected : {1, 8, 10}) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(expected, page_id_temp);
+    EXPECT_EQ(0, memcmp(page->GetData(), zeros, PAGE_SIZE));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0U, disk_manager->GetNumFreePages());
+
+  // Scenario: the reused page reads back zeroed after being evicted, not with its old contents.
+  for (int i = 0; i < static_cast<int>(buffer_pool_size); ++i) {
+    auto *page = bpm->FetchPage(i + 2);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm->UnpinPage(i + 2, false));
+  }
+  auto *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, memcmp(page->GetData(), zeros, PAGE_SIZE));
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+
+  // Scenario: pages that were never allocated cannot be freed.
+  EXPECT_EQ(true, bpm->DeletePage(100));
+  EXPECT_EQ(0U, disk_manager->GetNumFreePages());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Pages created out of an extent are contiguous, no matter how the allocations of several objects interleave.
+TEST(BufferPoolManagerInstanceTest, ExtentTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: two objects and plain NewPage calls allocate pages in turn.
+  Extent extent_a;
+  Extent extent_b;
+  std::vector<page_id_t> pages_a;
+  std::vector<page_id_t> pages_b;
+  std::vector<page_id_t> plain_pages;
+  page_id_t page_id_temp;
+  for (int i = 0; i < EXTENT_SIZE + 1; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id_temp, &extent_a));
+    pages_a.push_back(page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id_temp, &extent_b));
+    pages_b.push_back(page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    plain_pages.push_back(page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Each object got a whole extent, and a second one once the first was used up.
+  for (int i = 1; i < EXTENT_SIZE; ++i) {
+    EXPECT_EQ(pages_a[0] + i, pages_a[i]);
+    EXPECT_EQ(pages_b[0] + i, pages_b[i]);
+  }
+  EXPECT_EQ(0, pages_a[0]);
+  EXPECT_EQ(EXTENT_SIZE, pages_b[0]);
+  for (page_id_t page_id : plain_pages) {
+    EXPECT_TRUE(page_id >= 2 * EXTENT_SIZE);
+    EXPECT_TRUE(page_id < pages_a.back() || page_id >= pages_a.back() + EXTENT_SIZE);
+    EXPECT_TRUE(page_id < pages_b.back() || page_id >= pages_b.back() + EXTENT_SIZE);
+  }
+
+  // Scenario: a full buffer pool fails the allocation without using up the page id.
+  std::vector<page_id_t> pinned;
+  while (bpm->NewPage(&page_id_temp) != nullptr) {
+    pinned.push_back(page_id_temp);
+  }
+  EXPECT_EQ(buffer_pool_size, pinned.size());
+  EXPECT_EQ(nullptr, bpm->NewPageInExtent(&page_id_temp, &extent_a));
+  EXPECT_EQ(true, bpm->UnpinPage(pinned[0], false));
+  ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id_temp, &extent_a));
+  EXPECT_EQ(pages_a.back() + 1, page_id_temp);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// FlushAllPages writes the dirty pages only, however large the pool.
+TEST(BufferPoolManagerInstanceTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+
+  auto *disk_manager = new DiskManager(db_name, DiskIoMode::POSITIONAL);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: a full pool of new pages is all dirty.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+
+  // Scenario: with nothing dirty, flushing writes nothing.
+  bpm->FlushAllPages();
+  EXPECT_EQ(static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+
+  // Scenario: a few pages are modified, a few more are only read.
+  for (page_id_t page_id : {40, 10, 11, 3}) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t page_id : {12, 20}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(static_cast<int>(buffer_pool_size) + 4, disk_manager->GetNumWrites());
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id : {3, 10, 11, 40}) {
+    disk_manager->ReadPage(page_id, buf);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+
+  // Scenario: deleted and evicted pages leave the dirty set.
+  Page *page = bpm->FetchPage(5);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm->UnpinPage(5, true));
+  EXPECT_EQ(true, bpm->DeletePage(5));
+  bpm->FlushAllPages();
+  EXPECT_EQ(static_cast<int>(buffer_pool_size) + 4, disk_manager->GetNumWrites());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// The pool grows and shrinks while pages are resident; pages on frames that leave the pool are written back first.
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 160;
+
+  auto *disk_manager = new DiskManager(db_name, DiskIoMode::POSITIONAL);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: grow the pool across several chunks of frames and fill it.
+  EXPECT_EQ(true, bpm->Resize(200));
+  EXPECT_EQ(200U, bpm->GetPoolSize());
+  EXPECT_EQ(200U, bpm->GetAvailableFrames());
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    if (page_id_temp != num_pages - 1) {
+      EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    }
+  }
+  EXPECT_EQ(0, disk_manager->GetNumWrites());
+
+  // Scenario: a pinned page on a frame that would leave the pool makes shrinking time out, nothing changes.
+  EXPECT_EQ(false, bpm->Resize(5, std::chrono::milliseconds(50)));
+  EXPECT_EQ(200U, bpm->GetPoolSize());
+  EXPECT_EQ(200U - 1, bpm->GetAvailableFrames());
+  for (int i = 0; i < num_pages - 1; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: once it is unpinned, the pool shrinks and the dirty pages reach the disk.
+  EXPECT_EQ(true, bpm->UnpinPage(num_pages - 1, true));
+  EXPECT_EQ(true, bpm->Resize(5));
+  EXPECT_EQ(5U, bpm->GetPoolSize());
+  EXPECT_EQ(5U, bpm->GetAvailableFrames());
+  EXPECT_LE(num_pages - 5, disk_manager->GetNumWrites());
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: only five frames are left.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NE(nullptr, bpm->FetchPage(i));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->FetchPage(5));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: growing again brings the freed chunks back.
+  EXPECT_EQ(true, bpm->Resize(70));
+  EXPECT_EQ(70U, bpm->GetAvailableFrames());
+  for (int i = 0; i < 70; ++i) {
+    EXPECT_NE(nullptr, bpm->FetchPage(i));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(70));
+  for (int i = 0; i < 70; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Resizing back and forth under concurrent fetches loses no page.
+TEST(BufferPoolManagerInstanceTest, ConcurrentResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 200;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManager(db_name, DiskIoMode::POSITIONAL);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // The pages are unpinned dirty, so that they keep being written back while frames come and go.
+  std::vector<std::thread> threads;
+  std::atomic<bool> done{false};
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid, &done] {
+      std::default_random_engine rng(tid);
+      while (!done) {
+        auto page_id = static_cast<page_id_t>(rng() % num_pages);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  size_t shrunk = 0;
+  for (int round = 0; round < 20; ++round) {
+    EXPECT_EQ(true, bpm->Resize(150));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    shrunk += bpm->Resize(8, std::chrono::milliseconds(100)) ? 1 : 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_LT(0U, shrunk);
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Evicted pages come back from the compressed cache with their contents, dirty or clean, under concurrent fetches.
+TEST(BufferPoolManagerInstanceTest, CompressedCacheTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 50;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  bpm->SetCompressedCacheSize(PAGE_SIZE * 4);
+  CompressedPageCache *cache = bpm->GetCompressedCache();
+  ASSERT_NE(nullptr, cache);
+
+  // Scenario: the pages evicted while the pool is filled are kept compressed, written back first if dirty.
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(static_cast<size_t>(num_pages - buffer_pool_size), cache->GetNumPages());
+  EXPECT_LE(num_pages - static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+  EXPECT_GT(cache->GetCompressionRatio(), 10.0);
+
+  // Scenario: fetching them again hits the cache, and a page modified meanwhile comes back modified.
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < num_pages; ++i) {
+      Page *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      const std::string expected = "page " + std::to_string(i) + (round == 0 ? "" : " modified");
+      EXPECT_EQ(expected, std::string(page->GetData()));
+      if (round == 0) {
+        snprintf(page->GetData(), PAGE_SIZE, "page %d modified", i);
+      }
+      EXPECT_EQ(true, bpm->UnpinPage(i, round == 0));
+    }
+  }
+  // A scan over more pages than frames evicts the resident ones before it gets to them, so every fetch hits.
+  EXPECT_EQ(static_cast<uint64_t>(2 * num_pages), cache->GetHits());
+  EXPECT_DOUBLE_EQ(1.0, cache->GetHitRatio());
+
+  // Scenario: a deleted page is dropped from the cache and its id comes back as a zeroed page.
+  const size_t cached_pages = cache->GetNumPages();
+  EXPECT_EQ(true, bpm->DeletePage(0));
+  EXPECT_EQ(cached_pages - 1, cache->GetNumPages());
+  Page *page = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, page_id_temp);
+  EXPECT_EQ("", std::string(page->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+
+  // Scenario: concurrent fetches of pages that move between the pool and the cache always see their contents.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<page_id_t> page_dist(1, num_pages - 1);
+      for (int i = 0; i < 500; ++i) {
+        page_id_t page_id = page_dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ("page " + std::to_string(page_id) + " modified", std::string(page->GetData()));
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Frame data lives in the aligned frame arena, apart from the Page headers, which do not share cache lines.
+TEST(BufferPoolManagerInstanceTest, FrameArenaTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 100;
+
+  for (bool huge_pages : {false, true}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::LRU_K, 2,
+                                              huge_pages);
+    EXPECT_EQ(huge_pages, bpm->GetFrameArena().HasHugePages());
+    EXPECT_EQ(128U * PAGE_SIZE, bpm->GetFrameArena().GetMappedSize());
+
+    // Scenario: every frame is page aligned, the frames of a chunk are contiguous, the headers are cache line aligned.
+    std::vector<Page *> pages;
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      Page *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      pages.push_back(page);
+      EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+      EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(page) % 64);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    }
+    for (size_t i = 1; i < 64; ++i) {
+      EXPECT_EQ(pages[0]->GetData() + i * PAGE_SIZE, pages[i]->GetData());
+    }
+    if (huge_pages) {
+      EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(pages[0]->GetData()) % FrameArena::HUGE_PAGE_SIZE);
+    }
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      EXPECT_EQ(true, bpm->UnpinPage(static_cast<page_id_t>(i), true));
+    }
+
+    // Scenario: a chunk that leaves the pool gives its memory back and reuses its mapping when it comes back.
+    EXPECT_EQ(true, bpm->Resize(10));
+    EXPECT_EQ(true, bpm->Resize(buffer_pool_size));
+    EXPECT_EQ(128U * PAGE_SIZE, bpm->GetFrameArena().GetMappedSize());
+    for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+    EXPECT_EQ(true, bpm->Resize(300));
+    EXPECT_EQ(320U * PAGE_SIZE, bpm->GetFrameArena().GetMappedSize());
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.fsm");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+// The metrics count what the pool does, and the instance latch is only taken off the hit path.
+TEST(BufferPoolManagerInstanceTest, MetricsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: the second half of the new pages evicts the first half, writing each one back.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 2 * buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  std::vector<BufferPoolMetrics> metrics = bpm->GetMetrics();
+  ASSERT_EQ(1U, metrics.size());
+  EXPECT_EQ(0U, metrics[0].hits_);
+  EXPECT_EQ(0U, metrics[0].misses_);
+  EXPECT_EQ(buffer_pool_size, metrics[0].evictions_);
+  EXPECT_EQ(buffer_pool_size, metrics[0].foreground_write_backs_);
+
+  // Scenario: hits on the resident pages, then misses that evict more dirty pages.
+  for (page_id_t page_id = 10; page_id < 20; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  metrics = bpm->GetMetrics();
+  EXPECT_EQ(10U, metrics[0].hits_);
+  EXPECT_EQ(5U, metrics[0].misses_);
+  EXPECT_EQ(15U, metrics[0].evictions_);
+  // The pages read in have a single reference, so LRU-K evicts each one for the next miss; they are clean.
+  EXPECT_EQ(11U, metrics[0].foreground_write_backs_);
+  EXPECT_EQ(0U, metrics[0].background_write_backs_);
+  EXPECT_EQ(0U, metrics[0].pin_waits_);
+  // once per new page and per miss, never on a hit
+  EXPECT_EQ(25U, metrics[0].latch_hold_.count_);
+  EXPECT_NE(std::string::npos, metrics[0].ToString().find("evictions=15"));
+
+  // Scenario: the disk manager timed every page it wrote back or read.
+  const DiskMetrics disk_metrics = disk_manager->GetMetrics();
+  EXPECT_EQ(5U, disk_metrics.reads_.count_);
+  EXPECT_EQ(11U, disk_metrics.writes_.count_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -0,0 +1,203 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_warmer_test.cpp
+//
+// Identification: test/buffer/buffer_pool_warmer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_warmer.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Create num_pages pages holding "page <id>", and leave the last pool_size of them resident. */
+static void CreatePages(BufferPoolManager *bpm, int num_pages) {
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolWarmerTest, RetentionOrderTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+
+  // Scenario: whatever the policy, the pages hit again after they were read in are listed before the others.
+  for (ReplacerPolicy policy :
+       {ReplacerPolicy::LRU_K, ReplacerPolicy::TWO_Q, ReplacerPolicy::ARC, ReplacerPolicy::CLOCK}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, policy);
+    CreatePages(bpm, 20);
+    for (page_id_t page_id : {3, 5}) {
+      EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+    for (page_id_t page_id = 14; page_id < 20; ++page_id) {
+      EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+    for (page_id_t page_id : {3, 5, 3, 5}) {
+      EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+    std::vector<page_id_t> page_ids = bpm->GetResidentPages();
+    ASSERT_EQ(buffer_pool_size, page_ids.size());
+    std::sort(page_ids.begin(), page_ids.begin() + 2);
+    EXPECT_EQ(3, page_ids[0]);
+    EXPECT_EQ(5, page_ids[1]);
+    std::sort(page_ids.begin(), page_ids.end());
+    EXPECT_EQ((std::vector<page_id_t>{3, 5, 14, 15, 16, 17, 18, 19}), page_ids);
+
+    disk_manager->ShutDown();
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.fsm");
+  }
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolWarmerTest, DumpAndLoadTest) {
+  const std::string db_name = "test.db";
+  const std::string warm_name = "test.warm";
+  const size_t buffer_pool_size = 10;
+  remove(warm_name.c_str());
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  CreatePages(bpm, 50);
+  std::vector<page_id_t> hot_pages;
+  for (page_id_t page_id = 0; page_id < 50; page_id += 5) {
+    hot_pages.push_back(page_id);
+    EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: without a dump there is nothing to load.
+  auto *warmer = new BufferPoolWarmer(bpm, warm_name);
+  EXPECT_EQ(false, warmer->StartLoader());
+  EXPECT_EQ(true, warmer->Dump());
+  delete warmer;
+  delete bpm;
+
+  // Scenario: after a restart, the loader reads the working set back in and every fetch of it is a hit.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  warmer = new BufferPoolWarmer(bpm, warm_name);
+  EXPECT_EQ(true, warmer->StartLoader());
+  warmer->WaitForLoader();
+  EXPECT_EQ(buffer_pool_size, warmer->GetLoadedPages());
+  for (page_id_t page_id : hot_pages) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0U, bpm->GetMisses());
+  delete warmer;
+  delete bpm;
+
+  // Scenario: loading alongside traffic only fills the free frames, the pages traffic read in stay.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (page_id_t page_id = 1; page_id < 8; ++page_id) {
+    EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  warmer = new BufferPoolWarmer(bpm, warm_name);
+  EXPECT_EQ(true, warmer->StartLoader());
+  warmer->WaitForLoader();
+  EXPECT_EQ(3U, warmer->GetLoadedPages());
+  std::vector<page_id_t> page_ids = bpm->GetResidentPages();
+  for (page_id_t page_id = 1; page_id < 8; ++page_id) {
+    EXPECT_NE(page_ids.end(), std::find(page_ids.begin(), page_ids.end(), page_id));
+  }
+  EXPECT_EQ(buffer_pool_size, page_ids.size());
+  delete warmer;
+  delete bpm;
+
+  // Scenario: a truncated dump is ignored.
+  {
+    std::ifstream in(warm_name, std::ios::binary);
+    std::string dump((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream out(warm_name, std::ios::binary | std::ios::trunc);
+    out.write(dump.data(), static_cast<std::streamsize>(dump.size() - sizeof(page_id_t)));
+  }
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  warmer = new BufferPoolWarmer(bpm, warm_name);
+  EXPECT_EQ(false, warmer->StartLoader());
+  delete warmer;
+  delete bpm;
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.fsm");
+  remove("test.log");
+  remove(warm_name.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolWarmerTest, ParallelTest) {
+  const std::string db_name = "test.db";
+  const std::string warm_name = "test.warm";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 8;
+  remove(warm_name.c_str());
+
+  // Scenario: the periodic dumper saves the pages of every instance, and they are loaded back into their instances.
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  CreatePages(bpm, 100);
+  auto *warmer = new BufferPoolWarmer(bpm, warm_name);
+  warmer->StartDumper(std::chrono::milliseconds(5));
+  std::vector<page_id_t> resident = bpm->GetResidentPages();
+  EXPECT_EQ(num_instances * buffer_pool_size, resident.size());
+  while (!std::ifstream(warm_name).good()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  delete warmer;
+  delete bpm;
+
+  bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  warmer = new BufferPoolWarmer(bpm, warm_name);
+  EXPECT_EQ(true, warmer->StartLoader());
+  warmer->WaitForLoader();
+  EXPECT_EQ(num_instances * buffer_pool_size, warmer->GetLoadedPages());
+  std::vector<page_id_t> loaded = bpm->GetResidentPages();
+  std::sort(resident.begin(), resident.end());
+  std::sort(loaded.begin(), loaded.end());
+  EXPECT_EQ(resident, loaded);
+  delete warmer;
+  delete bpm;
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.fsm");
+  remove("test.log");
+  remove(warm_name.c_str());
+}
+
+}  // namespace bustub
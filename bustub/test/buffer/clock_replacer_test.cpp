@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <cstdio>
+#include <set>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -19,7 +20,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +60,51 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// Hits on resident frames from many threads while another thread keeps evicting and reloading frames. No frame is
+// lost or counted twice.
+TEST(ClockReplacerTest, ConcurrentHitTest) {
+  const int num_frames = 64;
+  const int num_threads = 8;
+  const int rounds = 2000;
+  ClockReplacer clock_replacer(num_frames / 2);
+  clock_replacer.SetNumFrames(num_frames);
+  for (frame_id_t frame_id = 0; frame_id < num_frames; ++frame_id) {
+    clock_replacer.RecordAccess(frame_id);
+    clock_replacer.Unpin(frame_id);
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&clock_replacer, tid] {
+      for (int i = 0; i < rounds; ++i) {
+        frame_id_t frame_id = tid * (num_frames / num_threads) + i % (num_frames / num_threads);
+        clock_replacer.Pin(frame_id);
+        clock_replacer.RecordAccess(frame_id, AccessType::Get);
+        clock_replacer.Unpin(frame_id);
+      }
+    });
+  }
+  threads.emplace_back([&clock_replacer] {
+    for (int i = 0; i < rounds; ++i) {
+      frame_id_t frame_id;
+      if (clock_replacer.Victim(&frame_id)) {
+        clock_replacer.RecordAccess(frame_id, AccessType::Get);
+        clock_replacer.Unpin(frame_id);
+      }
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(static_cast<size_t>(num_frames), clock_replacer.Size());
+  std::set<frame_id_t> victims;
+  frame_id_t frame_id;
+  while (clock_replacer.Victim(&frame_id)) {
+    EXPECT_TRUE(victims.insert(frame_id).second);
+  }
+  EXPECT_EQ(static_cast<size_t>(num_frames), victims.size());
+  EXPECT_EQ(0U, clock_replacer.Size());
+}
+
 }  // namespace bustub
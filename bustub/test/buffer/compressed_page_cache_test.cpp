@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache_test.cpp
+//
+// Identification: test/buffer/compressed_page_cache_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/util/lz_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Fill a page with text that looks like tuples: a lot of repetition, some variation. */
+static void FillTextPage(char *data, int seed) {
+  std::memset(data, 0, PAGE_SIZE);
+  size_t offset = 0;
+  for (int i = 0; offset + 64 < PAGE_SIZE; ++i) {
+    offset += snprintf(data + offset, 64, "tuple %d of page %d: name=user%d;", i, seed, (seed * 31 + i) % 997);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(LZUtilTest, RoundTripTest) {
+  std::vector<std::vector<char>> inputs;
+  std::vector<char> text(PAGE_SIZE);
+  FillTextPage(text.data(), 7);
+  inputs.push_back(text);
+  inputs.emplace_back(PAGE_SIZE, 0);
+  std::default_random_engine rng(42);
+  std::uniform_int_distribution<int> byte_dist(0, 255);
+  std::vector<char> random(PAGE_SIZE);
+  for (auto &c : random) {
+    c = static_cast<char>(byte_dist(rng));
+  }
+  inputs.push_back(random);
+  // Mostly zeros with a few runs of random bytes, like a half empty page.
+  std::vector<char> sparse(PAGE_SIZE, 0);
+  for (size_t i = 0; i < 300; ++i) {
+    sparse[i] = static_cast<char>(byte_dist(rng));
+  }
+  inputs.push_back(sparse);
+  inputs.emplace_back(std::vector<char>{'a', 'b', 'c'});
+
+  for (const auto &input : inputs) {
+    std::vector<char> compressed(input.size() * 2 + 16);
+    const size_t size = LZUtil::Compress(input.data(), input.size(), compressed.data(), compressed.size());
+    ASSERT_NE(0U, size);
+    std::vector<char> output(input.size());
+    EXPECT_EQ(input.size(), LZUtil::Decompress(compressed.data(), size, output.data(), output.size()));
+    EXPECT_EQ(input, output);
+    // A truncated block or a too small output is reported, not overrun.
+    EXPECT_EQ(0U, LZUtil::Decompress(compressed.data(), size, output.data(), output.size() - 1));
+  }
+
+  // Text and zeros shrink a lot, random data does not fit in less than its size.
+  std::vector<char> compressed(PAGE_SIZE);
+  EXPECT_LT(LZUtil::Compress(text.data(), PAGE_SIZE, compressed.data(), PAGE_SIZE), PAGE_SIZE / 2);
+  EXPECT_LT(LZUtil::Compress(inputs[1].data(), PAGE_SIZE, compressed.data(), PAGE_SIZE), 64U);
+  EXPECT_EQ(0U, LZUtil::Compress(random.data(), PAGE_SIZE, compressed.data(), PAGE_SIZE / 2));
+}
+
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, SampleTest) {
+  char page[PAGE_SIZE];
+  char output[PAGE_SIZE];
+  FillTextPage(page, 0);
+  std::vector<char> compressed(PAGE_SIZE);
+  const size_t page_size = LZUtil::Compress(page, PAGE_SIZE, compressed.data(), PAGE_SIZE);
+  CompressedPageCache cache(page_size * 3 + page_size / 2);
+
+  // Scenario: three pages fit, the fourth drops the least recently inserted one.
+  for (int i = 0; i < 4; ++i) {
+    FillTextPage(page, i);
+    cache.Insert(i, page);
+  }
+  EXPECT_EQ(3U, cache.GetNumPages());
+  EXPECT_LE(cache.GetSize(), page_size * 3 + page_size / 2);
+  EXPECT_FALSE(cache.Lookup(0, output));
+  EXPECT_GT(cache.GetCompressionRatio(), 2.0);
+
+  // Scenario: a lookup returns the page and takes it out of the cache.
+  EXPECT_TRUE(cache.Lookup(2, output));
+  FillTextPage(page, 2);
+  EXPECT_EQ(0, std::memcmp(page, output, PAGE_SIZE));
+  EXPECT_FALSE(cache.Lookup(2, output));
+  EXPECT_EQ(2U, cache.GetNumPages());
+
+  // Scenario: inserting a page again replaces its copy, erasing it drops it.
+  FillTextPage(page, 100);
+  cache.Insert(1, page);
+  EXPECT_EQ(2U, cache.GetNumPages());
+  EXPECT_TRUE(cache.Lookup(1, output));
+  EXPECT_EQ(0, std::memcmp(page, output, PAGE_SIZE));
+  cache.Erase(3);
+  EXPECT_EQ(0U, cache.GetNumPages());
+  EXPECT_EQ(0U, cache.GetSize());
+
+  // Scenario: a page that does not compress is not kept.
+  std::default_random_engine rng(42);
+  std::uniform_int_distribution<int> byte_dist(0, 255);
+  for (auto &c : page) {
+    c = static_cast<char>(byte_dist(rng));
+  }
+  cache.Insert(5, page);
+  EXPECT_EQ(0U, cache.GetNumPages());
+
+  EXPECT_EQ(2U, cache.GetHits());
+  EXPECT_EQ(4U, cache.GetLookups());
+  EXPECT_DOUBLE_EQ(0.5, cache.GetHitRatio());
+}
+
+}  // namespace bustub
@@ -0,0 +1,148 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: add six elements to the replacer. We have [1,2,3,4,5]. Frame 6 is non-evictable.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.RecordAccess(5);
+  lru_replacer.RecordAccess(6);
+  lru_replacer.SetEvictable(1, true);
+  lru_replacer.SetEvictable(2, true);
+  lru_replacer.SetEvictable(3, true);
+  lru_replacer.SetEvictable(4, true);
+  lru_replacer.SetEvictable(5, true);
+  lru_replacer.SetEvictable(6, false);
+  ASSERT_EQ(5, lru_replacer.Size());
+
+  // Scenario: Insert access history for frame 1. Now frame 1 has two access histories.
+  // All other frames have max backward k-dist. The order of eviction is [2,3,4,5,1].
+  lru_replacer.RecordAccess(1);
+
+  // Scenario: Evict three pages from the replacer. Elements with max k-distance should be popped
+  // first based on LRU.
+  int value;
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(2, value);
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(3, value);
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(4, value);
+  ASSERT_EQ(2, lru_replacer.Size());
+
+  // Scenario: Now replacer has frames [5,1].
+  // Insert new frames 3, 4, and update access history for 5. We should end with [3,1,5,4]
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.RecordAccess(5);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.SetEvictable(3, true);
+  lru_replacer.SetEvictable(4, true);
+  ASSERT_EQ(4, lru_replacer.Size());
+
+  // Scenario: continue looking for victims. We expect 3 to be evicted next.
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(3, value);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  // Set 6 to be evictable. 6 Should be evicted next since it has max backward k-dist.
+  lru_replacer.SetEvictable(6, true);
+  ASSERT_EQ(4, lru_replacer.Size());
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(6, value);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  // Now we have [1,5,4]. Continue looking for victims.
+  lru_replacer.SetEvictable(1, false);
+  ASSERT_EQ(2, lru_replacer.Size());
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(5, value);
+  ASSERT_EQ(1, lru_replacer.Size());
+
+  // Update access history for 1. Now we have [4,1]. Next victim is 4.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.SetEvictable(1, true);
+  ASSERT_EQ(2, lru_replacer.Size());
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(value, 4);
+
+  ASSERT_EQ(1, lru_replacer.Size());
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(value, 1);
+  ASSERT_EQ(0, lru_replacer.Size());
+
+  // These operations should not modify size
+  ASSERT_EQ(false, lru_replacer.Evict(&value));
+  ASSERT_EQ(0, lru_replacer.Size());
+  lru_replacer.Remove(1);
+  ASSERT_EQ(0, lru_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  LRUKReplacer lru_replacer(8, 2);
+
+  // Scenario: frames 0 and 1 are hot, each referenced twice by point lookups.
+  for (int i = 0; i < 2; ++i) {
+    lru_replacer.RecordAccess(0, AccessType::Get);
+    lru_replacer.RecordAccess(1, AccessType::Get);
+  }
+  lru_replacer.Unpin(0);
+  lru_replacer.Unpin(1);
+
+  // Scenario: a sequential scan streams through frames 2..7, touching each of them several times.
+  for (int frame_id = 2; frame_id < 8; ++frame_id) {
+    for (int i = 0; i < 4; ++i) {
+      lru_replacer.RecordAccess(frame_id, AccessType::Scan);
+    }
+    lru_replacer.Unpin(frame_id);
+  }
+  ASSERT_EQ(8, lru_replacer.Size());
+
+  // The scanned frames kept a single reference each, so all of them go before the hot frames.
+  int value;
+  for (int frame_id = 2; frame_id < 8; ++frame_id) {
+    ASSERT_EQ(true, lru_replacer.Victim(&value));
+    ASSERT_EQ(frame_id, value);
+  }
+  ASSERT_EQ(true, lru_replacer.Victim(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_EQ(true, lru_replacer.Victim(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_EQ(false, lru_replacer.Victim(&value));
+
+  // Pin and Remove drop frames from the evictable set.
+  lru_replacer.RecordAccess(3);
+  lru_replacer.Unpin(3);
+  ASSERT_EQ(1, lru_replacer.Size());
+  lru_replacer.Pin(3);
+  ASSERT_EQ(0, lru_replacer.Size());
+  lru_replacer.Unpin(3);
+  lru_replacer.Remove(3);
+  ASSERT_EQ(0, lru_replacer.Size());
+  ASSERT_EQ(false, lru_replacer.Victim(&value));
+}
+
+}  // namespace bustub
@@ -13,7 +13,10 @@
 #include "buffer/parallel_buffer_pool_manager.h"
 #include <cstdio>
 #include <random>
+#include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -151,4 +154,349 @@ TEST(ParallelBufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// An extent spans all instances: its pages are contiguous, and no instance hands its page ids out on its own.
+TEST(ParallelBufferPoolManagerTest, ExtentTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  Extent extent_a;
+  Extent extent_b;
+  std::vector<page_id_t> pages_a;
+  std::vector<page_id_t> pages_b;
+  std::vector<page_id_t> plain_pages;
+  page_id_t page_id_temp;
+  for (int i = 0; i < EXTENT_SIZE; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id_temp, &extent_a));
+    pages_a.push_back(page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id_temp, &extent_b));
+    pages_b.push_back(page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    plain_pages.push_back(page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  for (int i = 1; i < EXTENT_SIZE; ++i) {
+    EXPECT_EQ(pages_a[0] + i, pages_a[i]);
+    EXPECT_EQ(pages_b[0] + i, pages_b[i]);
+  }
+  for (page_id_t page_id : plain_pages) {
+    EXPECT_TRUE(page_id < pages_a[0] || page_id >= pages_a[0] + EXTENT_SIZE);
+    EXPECT_TRUE(page_id < pages_b[0] || page_id >= pages_b[0] + EXTENT_SIZE);
+  }
+
+  // Every page is served by the instance it belongs to.
+  for (page_id_t page_id : pages_a) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, page->GetPageId());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// The page ids an extent did not hand out are freed when it is released, and reused by the instances owning them.
+TEST(ParallelBufferPoolManagerTest, ReleaseExtentTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 20;
+  const size_t num_instances = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Tables created and dropped one after the other, each with a couple of pages.
+  const int num_tables = 3;
+  const int pages_per_table = 2;
+  std::set<page_id_t> unused_page_ids;
+  page_id_t page_id_temp;
+  for (int t = 0; t < num_tables; ++t) {
+    Extent extent;
+    for (int i = 0; i < pages_per_table; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id_temp, &extent));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    }
+    for (page_id_t page_id = extent.next_page_id_; page_id < extent.end_page_id_; ++page_id) {
+      unused_page_ids.insert(page_id);
+    }
+    bpm->ReleaseExtent(&extent);
+    EXPECT_EQ(extent.end_page_id_, extent.next_page_id_);
+    // Released twice, e.g. by a second owner, nothing is freed again.
+    bpm->ReleaseExtent(&extent);
+  }
+  EXPECT_EQ(static_cast<size_t>(num_tables * (EXTENT_SIZE - pages_per_table)), unused_page_ids.size());
+  EXPECT_EQ(unused_page_ids.size(), disk_manager->GetNumFreePages());
+
+  // Every instance takes its freed ids before any new one, so new pages soon use all of them up.
+  std::set<page_id_t> new_page_ids;
+  for (size_t i = 0; i < 2 * unused_page_ids.size() && disk_manager->GetNumFreePages() > 0; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    new_page_ids.insert(page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0U, disk_manager->GetNumFreePages());
+  for (page_id_t page_id : unused_page_ids) {
+    EXPECT_EQ(1U, new_page_ids.count(page_id));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// NewPage picks instances by turns, by load, or by calling thread, and only fails once every instance is full.
+TEST(ParallelBufferPoolManagerTest, InstanceSelectionTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: by turns, the instances alternate. Unpinning the odd pages leaves instance 1 with more room.
+  page_id_t page_id_temp;
+  for (page_id_t expected = 0; expected < 4; ++expected) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(expected, page_id_temp);
+  }
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+  EXPECT_EQ(true, bpm->UnpinPage(3, false));
+
+  // Scenario: by load, the next two pages both go to instance 1.
+  bpm->SetInstanceSelection(InstanceSelection::LOAD_AWARE);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(1, page_id_temp % 2);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+
+  // Scenario: by thread, the pages stay in one instance until it is full, then spill over to the other. Another thread
+  // starts out in its own instance too.
+  bpm->SetInstanceSelection(InstanceSelection::THREAD_AFFINITY);
+  std::vector<page_id_t> page_ids;
+  while (bpm->NewPage(&page_id_temp) != nullptr) {
+    page_ids.push_back(page_id_temp);
+  }
+  ASSERT_EQ(buffer_pool_size * num_instances, page_ids.size());
+  const page_id_t home = page_ids[0] % 2;
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    EXPECT_EQ(i < buffer_pool_size ? home : 1 - home, page_ids[i] % 2);
+  }
+  for (page_id_t page_id : page_ids) {
+    bpm->UnpinPage(page_id, false);
+  }
+  std::thread worker([bpm] {
+    page_id_t page_id;
+    std::vector<page_id_t> worker_page_ids;
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      worker_page_ids.push_back(page_id);
+    }
+    EXPECT_EQ(worker_page_ids[0] % 2, worker_page_ids[1] % 2);
+    EXPECT_EQ(worker_page_ids[0] % 2, worker_page_ids[2] % 2);
+    for (page_id_t id : worker_page_ids) {
+      bpm->UnpinPage(id, false);
+    }
+  });
+  worker.join();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Concurrent NewPage and NewPageInExtent calls never hand out a page id twice, with any selection policy.
+TEST(ParallelBufferPoolManagerTest, ConcurrentNewPageTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_instances = 4;
+  const int num_threads = 8;
+  const int pages_per_thread = 100;
+
+  for (InstanceSelection selection :
+       {InstanceSelection::ROUND_ROBIN, InstanceSelection::LOAD_AWARE, InstanceSelection::THREAD_AFFINITY}) {
+    auto *disk_manager = new DiskManager(db_name, DiskIoMode::POSITIONAL);
+    auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+    bpm->SetInstanceSelection(selection);
+
+    std::vector<std::vector<page_id_t>> page_ids(num_threads);
+    std::vector<std::thread> threads;
+    Extent shared_extent;
+    for (int tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([bpm, tid, &page_ids, &shared_extent] {
+        Extent extent;
+        for (int i = 0; i < pages_per_thread; ++i) {
+          page_id_t page_id;
+          // every tenth page comes out of the thread's own extent and another one out of an extent all threads share,
+          // so that extents are reserved and shared while NewPage runs
+          Page *page;
+          if (i % 10 == 0) {
+            page = bpm->NewPageInExtent(&page_id, &extent);
+          } else if (i % 10 == 5) {
+            page = bpm->NewPageInExtent(&page_id, &shared_extent);
+          } else {
+            page = bpm->NewPage(&page_id);
+          }
+          ASSERT_NE(nullptr, page);
+          page_ids[tid].push_back(page_id);
+          bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::set<page_id_t> unique_page_ids;
+    for (const auto &thread_page_ids : page_ids) {
+      unique_page_ids.insert(thread_page_ids.begin(), thread_page_ids.end());
+    }
+    EXPECT_EQ(static_cast<size_t>(num_threads * pages_per_thread), unique_page_ids.size());
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.fsm");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+// Resizing applies to every instance; one that cannot drain its frames keeps its size.
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(12U, bpm->GetPoolSize());
+
+  // Scenario: grown, every instance takes more pages.
+  EXPECT_EQ(true, bpm->Resize(10));
+  EXPECT_EQ(30U, bpm->GetPoolSize());
+  page_id_t page_id_temp;
+  for (int i = 0; i < 30; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  for (page_id_t page_id = 0; page_id < 30; ++page_id) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, page_id != 29));
+  }
+
+  // Scenario: a pinned page in instance 2 keeps that instance from shrinking, the others do.
+  ASSERT_NE(nullptr, bpm->FetchPage(29));
+  EXPECT_EQ(false, bpm->Resize(2, std::chrono::milliseconds(10)));
+  EXPECT_EQ(2U + 2U + 10U, bpm->GetPoolSize());
+  EXPECT_EQ(true, bpm->UnpinPage(29, false));
+  EXPECT_EQ(true, bpm->Resize(2));
+  EXPECT_EQ(6U, bpm->GetPoolSize());
+  for (page_id_t page_id = 0; page_id < 30; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Page ids reserved for another buffer pool are never handed out by the instances.
+TEST(ParallelBufferPoolManagerTest, ReservePageIdsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  auto *partition = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  partition->SetPageIdSource(bpm);
+
+  // Scenario: both pools create pages in turn, the partition out of runs it reserves from the parallel pool.
+  std::set<page_id_t> page_ids;
+  page_id_t page_id_temp;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, page_ids.insert(page_id_temp).second);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+    ASSERT_NE(nullptr, partition->NewPage(&page_id_temp));
+    EXPECT_EQ(true, page_ids.insert(page_id_temp).second);
+    EXPECT_EQ(true, partition->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: a single instance of a parallel pool cannot reserve on its own.
+  BufferPoolManagerInstance instance(buffer_pool_size, 2, 1, disk_manager);
+  EXPECT_EQ(INVALID_PAGE_ID, instance.ReservePageIds(EXTENT_SIZE));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete partition;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, MetricsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: every instance reports its own metrics, in instance order.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 2 * num_instances; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  for (page_id_t page_id : {0, 1, 2, 3, 4, 5, 0, 3}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  const std::vector<BufferPoolMetrics> metrics = bpm->GetMetrics();
+  ASSERT_EQ(num_instances, metrics.size());
+  EXPECT_EQ(4U, metrics[0].hits_);
+  EXPECT_EQ(2U, metrics[1].hits_);
+  EXPECT_EQ(2U, metrics[2].hits_);
+  for (const auto &instance_metrics : metrics) {
+    EXPECT_EQ(0U, instance_metrics.misses_);
+    EXPECT_EQ(2U, instance_metrics.latch_hold_.count_);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
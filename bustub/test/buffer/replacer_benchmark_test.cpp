@@ -0,0 +1,358 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_benchmark_test.cpp
+//
+// Identification: test/buffer/replacer_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/replacer.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// The benchmarks are disabled in the unit tests, run them with --gtest_also_run_disabled_tests.
+
+namespace {
+
+/** One page access of a trace. */
+struct TraceAccess {
+  page_id_t page_id_;
+  AccessType access_type_;
+};
+
+using Trace = std::vector<TraceAccess>;
+
+/** Forwards to another buffer pool manager and records every page it fetches. */
+class RecordingBufferPoolManager : public BufferPoolManager {
+ public:
+  RecordingBufferPoolManager(BufferPoolManager *bpm, Trace *trace) : bpm_(bpm), trace_(trace) {}
+  size_t GetPoolSize() override { return bpm_->GetPoolSize(); }
+  void ReleaseExtent(Extent *extent) override { bpm_->ReleaseExtent(extent); }
+
+ protected:
+  Page *FetchPgImp(page_id_t page_id, AccessType access_type) override {
+    trace_->push_back({page_id, access_type});
+    return bpm_->FetchPage(page_id, access_type);
+  }
+  bool UnpinPgImp(page_id_t page_id, bool is_dirty) override { return bpm_->UnpinPage(page_id, is_dirty); }
+  bool FlushPgImp(page_id_t page_id) override { return bpm_->FlushPage(page_id); }
+  Page *NewPgImp(page_id_t *page_id) override {
+    Page *page = bpm_->NewPage(page_id);
+    trace_->push_back({*page_id, AccessType::Unknown});
+    return page;
+  }
+  Page *NewPgInExtentImp(page_id_t *page_id, Extent *extent) override {
+    Page *page = bpm_->NewPageInExtent(page_id, extent);
+    trace_->push_back({*page_id, AccessType::Unknown});
+    return page;
+  }
+  bool DeletePgImp(page_id_t page_id) override { return bpm_->DeletePage(page_id); }
+  void FlushAllPgsImp() override { bpm_->FlushAllPages(); }
+
+ private:
+  BufferPoolManager *bpm_;
+  Trace *trace_;
+};
+
+/** @return a sampler of ranks in [0, n) where rank i has probability proportional to 1 / (i + 1)^theta */
+std::discrete_distribution<size_t> ZipfDistribution(size_t n, double theta) {
+  std::vector<double> weights(n);
+  for (size_t i = 0; i < n; ++i) {
+    weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), theta);
+  }
+  return std::discrete_distribution<size_t>(weights.begin(), weights.end());
+}
+
+/** Point accesses to num_pages pages, Zipfian with skew theta, or uniform for theta 0. */
+Trace ZipfTrace(size_t num_pages, double theta, size_t length) {
+  std::default_random_engine rng(42);
+  auto dist = ZipfDistribution(num_pages, theta);
+  Trace trace;
+  trace.reserve(length);
+  for (size_t i = 0; i < length; ++i) {
+    trace.push_back({static_cast<page_id_t>(dist(rng)), AccessType::Get});
+  }
+  return trace;
+}
+
+/** Zipfian point accesses to a hot set, interrupted every scan_interval accesses by a scan of a cold range. */
+Trace HotSetScanTrace(size_t hot_pages, size_t scan_pages, size_t scan_interval, size_t length) {
+  std::default_random_engine rng(42);
+  auto dist = ZipfDistribution(hot_pages, 0.99);
+  Trace trace;
+  trace.reserve(length);
+  while (trace.size() < length) {
+    for (size_t i = 0; i < scan_interval; ++i) {
+      trace.push_back({static_cast<page_id_t>(dist(rng)), AccessType::Get});
+    }
+    for (size_t i = 0; i < scan_pages; ++i) {
+      trace.push_back({static_cast<page_id_t>(hot_pages + i), AccessType::Scan});
+    }
+  }
+  return trace;
+}
+
+/** Repeated sequential passes over num_pages pages, LRU's worst case once they do not fit. */
+Trace LoopTrace(size_t num_pages, size_t length) {
+  Trace trace;
+  trace.reserve(length);
+  for (size_t i = 0; i < length; ++i) {
+    trace.push_back({static_cast<page_id_t>(i % num_pages), AccessType::Get});
+  }
+  return trace;
+}
+
+/**
+ * Record the page accesses of a table heap workload: the table is loaded, then read by Zipfian point lookups, with a
+ * full scan after every scan_interval lookups.
+ */
+Trace RecordTableHeapTrace(int num_tuples, size_t num_lookups, size_t scan_interval) {
+  const std::string db_name = "test.db";
+  remove(db_name.c_str());
+  remove("test.fsm");
+  Trace trace;
+  {
+    DiskManager disk_manager(db_name, DiskIoMode::POSITIONAL);
+    BufferPoolManagerInstance bpm(64, &disk_manager);
+    RecordingBufferPoolManager recorder(&bpm, &trace);
+    Transaction txn(0);
+    LockManager lock_manager;
+    std::vector<Column> columns{{"a", TypeId::INTEGER}, {"b", TypeId::VARCHAR, 200}};
+    Schema schema{columns};
+    TableHeap table(&recorder, &lock_manager, nullptr, &txn);
+    std::vector<RID> rids(num_tuples);
+    for (int i = 0; i < num_tuples; ++i) {
+      std::vector<Value> values{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+      EXPECT_TRUE(table.InsertTuple(Tuple(values, &schema), &rids[i], &txn));
+    }
+    std::default_random_engine rng(42);
+    auto dist = ZipfDistribution(rids.size(), 0.99);
+    Tuple tuple;
+    for (size_t i = 0; i < num_lookups; ++i) {
+      EXPECT_TRUE(table.GetTuple(rids[dist(rng)], &tuple, &txn, AccessType::Get));
+      if ((i + 1) % scan_interval == 0) {
+        int count = 0;
+        for (auto iter = table.Begin(&txn); iter != table.End(); ++iter) {
+          count++;
+        }
+        EXPECT_EQ(num_tuples, count);
+      }
+    }
+    disk_manager.ShutDown();
+  }
+  remove(db_name.c_str());
+  remove("test.fsm");
+  return trace;
+}
+
+/** Read a recorded trace: one access per line, a page id optionally followed by "S" for a scan access. */
+Trace LoadTrace(const std::string &file_name) {
+  Trace trace;
+  std::ifstream in(file_name);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    auto page_id = static_cast<page_id_t>(std::stol(line));
+    trace.push_back({page_id, line.find('S') != std::string::npos ? AccessType::Scan : AccessType::Get});
+  }
+  return trace;
+}
+
+/**
+ * Replay a trace against a replacer the way a buffer pool of num_frames frames drives it: a hit pins the frame and
+ * records the access, a miss takes a free frame or a victim and records the load, and the frame is unpinned again.
+ * @return the hit ratio and the time per access in nanoseconds
+ */
+std::pair<double, double> Replay(ReplacerPolicy policy, size_t num_frames, const Trace &trace) {
+  auto replacer = MakeReplacer(policy, num_frames, 2);
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frame_pages(num_frames, INVALID_PAGE_ID);
+  size_t num_used_frames = 0;
+  size_t hits = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &access : trace) {
+    frame_id_t frame_id;
+    auto iter = page_table.find(access.page_id_);
+    if (iter != page_table.end()) {
+      hits++;
+      frame_id = iter->second;
+      replacer->Pin(frame_id);
+      replacer->RecordAccess(frame_id, access.access_type_);
+    } else {
+      if (num_used_frames < num_frames) {
+        frame_id = static_cast<frame_id_t>(num_used_frames++);
+      } else {
+        bool found = replacer->Victim(&frame_id);
+        EXPECT_TRUE(found);
+        page_table.erase(frame_pages[frame_id]);
+      }
+      page_table.emplace(access.page_id_, frame_id);
+      frame_pages[frame_id] = access.page_id_;
+      replacer->RecordLoad(frame_id, access.page_id_, access.access_type_);
+    }
+    replacer->Unpin(frame_id);
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return {static_cast<double>(hits) / static_cast<double>(trace.size()),
+          elapsed.count() / static_cast<double>(trace.size())};
+}
+
+/**
+ * Run op(rng) ops_per_thread times on each of num_threads threads.
+ * @return the aggregate throughput in operations per second
+ */
+template <class Op>
+double RunThreads(size_t num_threads, size_t ops_per_thread, Op op) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&op, tid, ops_per_thread] {
+      std::default_random_engine rng(tid);
+      for (size_t i = 0; i < ops_per_thread; ++i) {
+        op(&rng);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(num_threads * ops_per_thread) / elapsed.count();
+}
+
+const std::pair<std::string, ReplacerPolicy> POLICIES[] = {{"lru", ReplacerPolicy::LRU},
+                                                           {"lru_k", ReplacerPolicy::LRU_K},
+                                                           {"2q", ReplacerPolicy::TWO_Q},
+                                                           {"arc", ReplacerPolicy::ARC},
+                                                           {"clock", ReplacerPolicy::CLOCK}};
+
+}  // namespace
+
+// NOLINTNEXTLINE
+// Replays page access traces through every replacement policy and reports the hit ratio and the time per access. The
+// Zipfian traces use the skews of TableGenerator's Zipf_* distributions; the table heap trace is recorded from a load
+// followed by Zipfian lookups and periodic scans. A trace recorded elsewhere can be added with
+// BUSTUB_REPLACER_TRACE=<file>, one page id per line, "S" after it for a scan access.
+TEST(DISABLED_ReplacerBenchmarkTest, TraceReplayTest) {
+  const size_t num_frames = 256;
+  const size_t num_pages = 4096;
+  const size_t length = 100000;
+
+  std::vector<std::pair<std::string, Trace>> traces;
+  traces.emplace_back("uniform", ZipfTrace(num_pages, 0.0, length));
+  traces.emplace_back("zipf_50", ZipfTrace(num_pages, 0.50, length));
+  traces.emplace_back("zipf_75", ZipfTrace(num_pages, 0.75, length));
+  traces.emplace_back("zipf_95", ZipfTrace(num_pages, 0.95, length));
+  traces.emplace_back("zipf_99", ZipfTrace(num_pages, 0.99, length));
+  traces.emplace_back("hot_set+scan", HotSetScanTrace(num_frames, 4 * num_frames, 2000, length));
+  traces.emplace_back("loop", LoopTrace(num_frames + num_frames / 4, length));
+  traces.emplace_back("table_heap", RecordTableHeapTrace(10000, 50000, 25000));
+  const char *trace_file = std::getenv("BUSTUB_REPLACER_TRACE");
+  if (trace_file != nullptr) {
+    traces.emplace_back(trace_file, LoadTrace(trace_file));
+  }
+
+  std::cout << "trace  accesses";
+  for (const auto &policy : POLICIES) {
+    std::cout << "  " << policy.first << "(hit%, ns/op)";
+  }
+  std::cout << std::endl;
+  for (const auto &[name, trace] : traces) {
+    ASSERT_FALSE(trace.empty());
+    std::cout << name << "  " << trace.size();
+    for (const auto &policy : POLICIES) {
+      auto [hit_ratio, ns_per_op] = Replay(policy.second, num_frames, trace);
+      std::cout << std::fixed << std::setprecision(1) << "  " << 100 * hit_ratio << ", " << ns_per_op;
+    }
+    std::cout << std::endl;
+  }
+}
+
+// NOLINTNEXTLINE
+// Many threads hitting resident frames. A hit on the replacer alone is the Pin, RecordAccess and Unpin the buffer pool
+// issues for it; every replacer but CLOCK serializes them on its latch, CLOCK only does atomic stores. The "bpm"
+// columns run FetchPage/UnpinPage of resident pages on a buffer pool instance built with each policy.
+TEST(DISABLED_ReplacerBenchmarkTest, ConcurrentHitTest) {
+  const std::string db_name = "test.db";
+  const size_t num_frames = 1024;
+  const size_t ops_per_thread = 20000;
+
+  remove(db_name.c_str());
+  DiskManager disk_manager(db_name, DiskIoMode::POSITIONAL);
+  std::vector<std::unique_ptr<Replacer>> replacers;
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> bpms;
+  for (const auto &policy : POLICIES) {
+    replacers.emplace_back(MakeReplacer(policy.second, num_frames, 2));
+    bpms.emplace_back(
+        std::make_unique<BufferPoolManagerInstance>(num_frames, &disk_manager, nullptr, policy.second));
+    for (size_t i = 0; i < num_frames; ++i) {
+      replacers.back()->RecordAccess(static_cast<frame_id_t>(i), AccessType::Get);
+      replacers.back()->Unpin(static_cast<frame_id_t>(i));
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpms.back()->NewPage(&page_id));
+      ASSERT_TRUE(bpms.back()->UnpinPage(page_id, false));
+    }
+  }
+
+  std::cout << "threads";
+  for (const auto &policy : POLICIES) {
+    std::cout << "  " << policy.first << "(ops/s)";
+  }
+  for (const auto &policy : POLICIES) {
+    std::cout << "  bpm " << policy.first << "(ops/s)";
+  }
+  std::cout << std::endl;
+  for (size_t num_threads : {1, 8, 32, 64}) {
+    std::cout << num_threads;
+    for (auto &replacer : replacers) {
+      auto hit = [&replacer](std::default_random_engine *rng) {
+        auto frame_id = static_cast<frame_id_t>((*rng)() % num_frames);
+        replacer->Pin(frame_id);
+        replacer->RecordAccess(frame_id, AccessType::Get);
+        replacer->Unpin(frame_id);
+      };
+      std::cout << "  " << static_cast<uint64_t>(RunThreads(num_threads, ops_per_thread, hit));
+    }
+    for (auto &bpm : bpms) {
+      auto hit = [&bpm](std::default_random_engine *rng) {
+        auto page_id = static_cast<page_id_t>((*rng)() % num_frames);
+        EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+        bpm->UnpinPage(page_id, false);
+      };
+      std::cout << "  " << static_cast<uint64_t>(RunThreads(num_threads, ops_per_thread, hit));
+    }
+    std::cout << std::endl;
+  }
+
+  bpms.clear();
+  disk_manager.ShutDown();
+  remove(db_name.c_str());
+  remove("test.fsm");
+}
+
+}  // namespace bustub
@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer_test.cpp
+//
+// Identification: test/buffer/two_q_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_q_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(TwoQReplacerTest, SampleTest) {
+  // Eight frames: A1in is preferred for eviction above two frames, A1out remembers four pages.
+  TwoQReplacer replacer(8);
+  for (frame_id_t frame_id = 0; frame_id < 8; ++frame_id) {
+    replacer.RecordLoad(frame_id, frame_id);
+    replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(8, replacer.Size());
+
+  // A1in is FIFO, a hit does not move a page in it.
+  replacer.RecordAccess(0);
+  frame_id_t value;
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Page 0 comes back while A1out remembers it and enters Am; page 100 is new and enters A1in.
+  replacer.RecordLoad(0, 0);
+  replacer.Unpin(0);
+  replacer.RecordLoad(1, 100);
+  replacer.Unpin(1);
+
+  // A1in (frames 2-7 and 1) is drained down to its share before Am is touched.
+  for (frame_id_t expected : {2, 3, 4, 5, 6}) {
+    ASSERT_TRUE(replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  EXPECT_EQ(2, replacer.Size());
+
+  // A1out kept the last four pages evicted from A1in. Page 2 was dropped, a scan never promotes page 3.
+  replacer.RecordLoad(2, 2);
+  replacer.RecordLoad(3, 3, AccessType::Scan);
+  replacer.RecordLoad(4, 4);
+  for (frame_id_t frame_id : {2, 3, 4}) {
+    replacer.Unpin(frame_id);
+  }
+  // A1in holds frames 7, 1, 2, 3, Am holds frame 4.
+  for (frame_id_t expected : {7, 1}) {
+    ASSERT_TRUE(replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+
+  // Pinned frames are skipped, removed ones are forgotten.
+  replacer.Pin(4);
+  replacer.Remove(2);
+  EXPECT_EQ(1, replacer.Size());
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_FALSE(replacer.Victim(&value));
+  replacer.Unpin(4);
+  ASSERT_TRUE(replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(0, replacer.Size());
+}
+
+TEST(TwoQReplacerTest, AmIsLruTest) {
+  TwoQReplacer replacer(8);
+  for (frame_id_t frame_id = 0; frame_id < 4; ++frame_id) {
+    replacer.RecordLoad(frame_id, frame_id);
+    replacer.Unpin(frame_id);
+  }
+  frame_id_t value;
+  for (frame_id_t expected = 0; expected < 4; ++expected) {
+    ASSERT_TRUE(replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+  for (frame_id_t frame_id = 0; frame_id < 4; ++frame_id) {
+    replacer.RecordLoad(frame_id, frame_id);
+    replacer.Unpin(frame_id);
+  }
+
+  // Hits move pages to the end of Am, scans do not.
+  replacer.RecordAccess(0);
+  replacer.RecordAccess(1, AccessType::Scan);
+  for (frame_id_t expected : {1, 2, 3, 0}) {
+    ASSERT_TRUE(replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+}
+
+}  // namespace bustub
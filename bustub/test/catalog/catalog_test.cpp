@@ -688,4 +688,87 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
   remove("catalog_test.log");
 }
 
+// Tables and indexes in a resident partition stay in memory while a large table streams through the shared pool
+TEST(CatalogTest, PartitionTest) {
+  auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(16, disk_manager.get());
+  LockManager lock_manager;
+  auto catalog = std::make_unique<Catalog>(bpm.get(), &lock_manager, nullptr, disk_manager.get());
+  Transaction txn{0};
+
+  // Partition names are unique, and there are none without a disk manager
+  auto *hot = catalog->CreatePartition("hot", 8, ReplacerPolicy::LRU_K, 2, true);
+  ASSERT_NE(nullptr, hot);
+  EXPECT_EQ(nullptr, catalog->CreatePartition("hot", 8));
+  EXPECT_EQ(hot, catalog->GetPartition("hot"));
+  EXPECT_EQ(nullptr, Catalog(bpm.get(), nullptr, nullptr).CreatePartition("cold", 8));
+
+  std::vector<Column> columns{{"A", TypeId::BIGINT}, {"B", TypeId::VARCHAR, 200}};
+  Schema schema{columns};
+  EXPECT_EQ(Catalog::NULL_TABLE_INFO, catalog->CreateTable(&txn, "lookup", schema, "missing"));
+  auto *lookup = catalog->CreateTable(&txn, "lookup", schema, "hot");
+  auto *big = catalog->CreateTable(&txn, "big", schema);
+  ASSERT_NE(Catalog::NULL_TABLE_INFO, lookup);
+  ASSERT_NE(Catalog::NULL_TABLE_INFO, big);
+
+  auto make_tuple = [&schema](int64_t key) {
+    return Tuple{std::vector<Value>{ValueFactory::GetBigIntValue(key),
+                                    ValueFactory::GetVarcharValue(std::string(200, 'a' + key % 26))},
+                 &schema};
+  };
+  RID rid;
+  for (int64_t key = 0; key < 40; ++key) {
+    ASSERT_TRUE(lookup->table_->InsertTuple(make_tuple(key), &rid, &txn));
+  }
+  std::vector<Column> key_columns{{"A", TypeId::BIGINT}};
+  Schema key_schema{key_columns};
+  auto *index_info = catalog->CreateIndex<BigintKeyType, BigintValueType, BigintComparatorType>(
+      &txn, "lookup_a", "lookup", schema, key_schema, {0}, BIGINT_SIZE, BigintHashFunctionType{}, "hot");
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+
+  // The big table is many times the shared pool, and its page ids never collide with the partition's
+  for (int64_t key = 0; key < 2000; ++key) {
+    ASSERT_TRUE(big->table_->InsertTuple(make_tuple(key), &rid, &txn));
+  }
+  const uint64_t hot_misses = hot->GetMisses();
+  int64_t count = 0;
+  for (auto iter = big->table_->Begin(&txn); iter != big->table_->End(); ++iter) {
+    EXPECT_EQ(count++, iter->GetValue(&schema, 0).GetAs<int64_t>());
+  }
+  EXPECT_EQ(2000, count);
+  EXPECT_LT(0U, bpm->GetMisses());
+
+  // The lookup table and its index are still resident
+  count = 0;
+  for (auto iter = lookup->table_->Begin(&txn); iter != lookup->table_->End(); ++iter) {
+    Tuple tuple = *iter;
+    EXPECT_EQ(make_tuple(count).GetValue(&schema, 1).CompareEquals(tuple.GetValue(&schema, 1)), CmpBool::CmpTrue);
+    std::vector<RID> results;
+    index_info->index_->ScanKey(tuple.KeyFromTuple(schema, key_schema, {0}), &results, &txn);
+    ASSERT_EQ(1U, results.size());
+    EXPECT_EQ(tuple.GetRid().Get(), results[0].Get());
+    count++;
+  }
+  EXPECT_EQ(40, count);
+  EXPECT_EQ(hot_misses, hot->GetMisses());
+  EXPECT_EQ(0U, hot->GetMisses());
+
+  // A resident partition refuses new pages once it is full
+  page_id_t page_id;
+  while (hot->GetAvailableFrames() > 0) {
+    ASSERT_NE(nullptr, hot->NewPage(&page_id));
+  }
+  EXPECT_EQ(nullptr, hot->NewPage(&page_id));
+
+  auto hit_ratios = catalog->GetPartitionHitRatios();
+  ASSERT_EQ(1U, hit_ratios.size());
+  EXPECT_EQ(1.0, hit_ratios["hot"]);
+
+  catalog.reset();
+  disk_manager->ShutDown();
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+  remove("catalog_test.log");
+}
+
 }  // namespace bustub
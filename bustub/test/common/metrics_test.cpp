@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics_test.cpp
+//
+// Identification: test/common/metrics_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/metrics.h"
+
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, ShardedCounterTest) {
+  const size_t num_threads = 2 * NUM_METRIC_SHARDS;
+  const uint64_t adds_per_thread = 10000;
+  ShardedCounter counter;
+  EXPECT_EQ(0U, counter.Get());
+
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&counter] {
+      for (uint64_t i = 0; i < adds_per_thread; ++i) {
+        counter.Add();
+      }
+      counter.Add(2);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * (adds_per_thread + 2), counter.Get());
+}
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, LatencyHistogramTest) {
+  LatencyHistogram histogram;
+  HistogramSnapshot snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(0U, snapshot.count_);
+  EXPECT_EQ(0U, snapshot.GetPercentileNs(0.5));
+  EXPECT_EQ(0, snapshot.GetMeanNs());
+
+  // Scenario: latencies land in power-of-two buckets, percentiles are the upper bound of their bucket.
+  histogram.Record(std::chrono::nanoseconds(0));
+  histogram.Record(std::chrono::nanoseconds(1));
+  std::thread other([&histogram] {
+    for (int i = 0; i < 98; ++i) {
+      histogram.Record(std::chrono::nanoseconds(1000));
+    }
+  });
+  other.join();
+  histogram.Record(std::chrono::milliseconds(1));
+  snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(101U, snapshot.count_);
+  EXPECT_EQ(1000001U + 98000U, snapshot.sum_ns_);
+  EXPECT_EQ(1U, snapshot.buckets_[0]);
+  EXPECT_EQ(1U, snapshot.buckets_[1]);
+  EXPECT_EQ(98U, snapshot.buckets_[10]);
+  EXPECT_EQ(1U, snapshot.buckets_[20]);
+  EXPECT_EQ(0U, snapshot.GetPercentileNs(0));
+  EXPECT_EQ(1023U, snapshot.GetPercentileNs(0.5));
+  EXPECT_EQ(1023U, snapshot.GetPercentileNs(0.99));
+  EXPECT_EQ((1U << 20) - 1, snapshot.GetPercentileNs(1));
+
+  // Scenario: merged snapshots add up, and a latency beyond the last bucket goes to it.
+  LatencyHistogram slow;
+  slow.Record(std::chrono::hours(1));
+  snapshot.Merge(slow.GetSnapshot());
+  EXPECT_EQ(102U, snapshot.count_);
+  EXPECT_EQ(1U, snapshot.buckets_[HistogramSnapshot::NUM_BUCKETS - 1]);
+}
+
+// NOLINTNEXTLINE
+TEST(MetricsTest, MeasuredMutexTest) {
+  LatencyHistogram hold_times;
+  MeasuredMutex mutex(&hold_times);
+  {
+    std::scoped_lock lock{mutex};
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  {
+    std::unique_lock<MeasuredMutex> lock(mutex, std::try_to_lock);
+    EXPECT_TRUE(lock.owns_lock());
+  }
+  const HistogramSnapshot snapshot = hold_times.GetSnapshot();
+  EXPECT_EQ(2U, snapshot.count_);
+  EXPECT_LE(2000000U, snapshot.GetPercentileNs(1));
+  EXPECT_GT(2000000U, snapshot.GetPercentileNs(0));
+}
+
+}  // namespace bustub
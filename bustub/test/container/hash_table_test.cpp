@@ -27,89 +27,91 @@ namespace bustub {
 TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
-  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
-
-  // insert a few values
-  for (int i = 0; i < 5; i++) {
-    ht.Insert(nullptr, i, i);
-    std::vector<int> res;
-    ht.GetValue(nullptr, i, &res);
-    EXPECT_EQ(1, res.size()) << "Failed to insert " << i << std::endl;
-    EXPECT_EQ(i, res[0]);
-  }
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+    // insert a few values
+    for (int i = 0; i < 5; i++) {
+      ht.Insert(nullptr, i, i);
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      EXPECT_EQ(1, res.size()) << "Failed to insert " << i << std::endl;
+      EXPECT_EQ(i, res[0]);
+    }
 
-  ht.VerifyIntegrity();
+    ht.VerifyIntegrity();
 
-  // check if the inserted values are all there
-  for (int i = 0; i < 5; i++) {
-    std::vector<int> res;
-    ht.GetValue(nullptr, i, &res);
-    EXPECT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
-    EXPECT_EQ(i, res[0]);
-  }
+    // check if the inserted values are all there
+    for (int i = 0; i < 5; i++) {
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      EXPECT_EQ(1, res.size()) << "Failed to keep " << i << std::endl;
+      EXPECT_EQ(i, res[0]);
+    }
 
-  ht.VerifyIntegrity();
+    ht.VerifyIntegrity();
 
-  // insert one more value for each key
-  for (int i = 0; i < 5; i++) {
-    if (i == 0) {
-      // duplicate values for the same key are not allowed
-      EXPECT_FALSE(ht.Insert(nullptr, i, 2 * i));
-    } else {
-      EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i));
-    }
-    ht.Insert(nullptr, i, 2 * i);
-    std::vector<int> res;
-    ht.GetValue(nullptr, i, &res);
-    if (i == 0) {
-      // duplicate values for the same key are not allowed
-      EXPECT_EQ(1, res.size());
-      EXPECT_EQ(i, res[0]);
-    } else {
-      EXPECT_EQ(2, res.size());
-      if (res[0] == i) {
-        EXPECT_EQ(2 * i, res[1]);
+    // insert one more value for each key
+    for (int i = 0; i < 5; i++) {
+      if (i == 0) {
+        // duplicate values for the same key are not allowed
+        EXPECT_FALSE(ht.Insert(nullptr, i, 2 * i));
       } else {
-        EXPECT_EQ(2 * i, res[0]);
-        EXPECT_EQ(i, res[1]);
+        EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i));
+      }
+      ht.Insert(nullptr, i, 2 * i);
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      if (i == 0) {
+        // duplicate values for the same key are not allowed
+        EXPECT_EQ(1, res.size());
+        EXPECT_EQ(i, res[0]);
+      } else {
+        EXPECT_EQ(2, res.size());
+        if (res[0] == i) {
+          EXPECT_EQ(2 * i, res[1]);
+        } else {
+          EXPECT_EQ(2 * i, res[0]);
+          EXPECT_EQ(i, res[1]);
+        }
       }
     }
-  }
 
-  ht.VerifyIntegrity();
+    ht.VerifyIntegrity();
 
-  // look for a key that does not exist
-  std::vector<int> res;
-  ht.GetValue(nullptr, 20, &res);
-  EXPECT_EQ(0, res.size());
-
-  // delete some values
-  for (int i = 0; i < 5; i++) {
-    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    // look for a key that does not exist
     std::vector<int> res;
-    ht.GetValue(nullptr, i, &res);
-    if (i == 0) {
-      // (0, 0) is the only pair with key 0
-      EXPECT_EQ(0, res.size());
-    } else {
-      EXPECT_EQ(1, res.size());
-      EXPECT_EQ(2 * i, res[0]);
+    ht.GetValue(nullptr, 20, &res);
+    EXPECT_EQ(0, res.size());
+
+    // delete some values
+    for (int i = 0; i < 5; i++) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      if (i == 0) {
+        // (0, 0) is the only pair with key 0
+        EXPECT_EQ(0, res.size());
+      } else {
+        EXPECT_EQ(1, res.size());
+        EXPECT_EQ(2 * i, res[0]);
+      }
     }
-  }
 
-  ht.VerifyIntegrity();
+    ht.VerifyIntegrity();
 
-  // delete all values
-  for (int i = 0; i < 5; i++) {
-    if (i == 0) {
-      // (0, 0) has been deleted
-      EXPECT_FALSE(ht.Remove(nullptr, i, 2 * i));
-    } else {
-      EXPECT_TRUE(ht.Remove(nullptr, i, 2 * i));
+    // delete all values
+    for (int i = 0; i < 5; i++) {
+      if (i == 0) {
+        // (0, 0) has been deleted
+        EXPECT_FALSE(ht.Remove(nullptr, i, 2 * i));
+      } else {
+        EXPECT_TRUE(ht.Remove(nullptr, i, 2 * i));
+      }
     }
-  }
 
-  ht.VerifyIntegrity();
+    ht.VerifyIntegrity();
+  }
 
   disk_manager->ShutDown();
   remove("test.db");
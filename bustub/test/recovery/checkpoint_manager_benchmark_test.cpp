@@ -0,0 +1,237 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checkpoint_manager_benchmark_test.cpp
+//
+// Identification: test/recovery/checkpoint_manager_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/metrics.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/page/table_page.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// The benchmarks are disabled in the unit tests, run them with --gtest_also_run_disabled_tests.
+
+namespace {
+
+const size_t NUM_PAGES = 2000;
+const size_t POOL_SIZE = 4096;
+const size_t NUM_THREADS = 4;
+const size_t UPDATES_PER_TXN = 4;
+const auto RUN_TIME = std::chrono::seconds(3);
+const auto CHECKPOINT_INTERVAL = std::chrono::milliseconds(500);
+
+Tuple MakeTuple(const Schema &schema, char fill) {
+  return Tuple({ValueFactory::GetVarcharValue(std::string(100, fill))}, &schema);
+}
+
+/** Fill NUM_PAGES table pages with tuples, one logged transaction per page, and return the first page and the rids. */
+page_id_t LoadTable(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager,
+                    TransactionManager *txn_manager, const Schema &schema, std::vector<RID> *rids) {
+  const Tuple tuple = MakeTuple(schema, 'a');
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  TablePage *prev_page = nullptr;
+  for (size_t i = 0; i < NUM_PAGES; ++i) {
+    Transaction *txn = txn_manager->Begin();
+    page_id_t page_id;
+    auto *page = reinterpret_cast<TablePage *>(bpm->NewPage(&page_id));
+    const page_id_t prev_page_id = prev_page == nullptr ? INVALID_PAGE_ID : prev_page->GetTablePageId();
+    page->Init(page_id, PAGE_SIZE, prev_page_id, log_manager, txn);
+    if (prev_page == nullptr) {
+      first_page_id = page_id;
+    } else {
+      prev_page->SetNextPageId(page_id);
+      bpm->UnpinPage(prev_page_id, true);
+    }
+    RID rid;
+    while (page->InsertTuple(tuple, &rid, txn, lock_manager, log_manager)) {
+      rids->push_back(rid);
+    }
+    txn_manager->Commit(txn);
+    delete txn;
+    prev_page = page;
+  }
+  bpm->UnpinPage(prev_page->GetTablePageId(), true);
+  return first_page_id;
+}
+
+/** @return a hash of every tuple of the table, read after recovery with logging off */
+size_t HashTable(BufferPoolManager *bpm, const std::vector<RID> &rids) {
+  size_t hash = 0;
+  for (const RID &rid : rids) {
+    auto *page = reinterpret_cast<TablePage *>(bpm->FetchPage(rid.GetPageId()));
+    Tuple tuple;
+    page->RLatch();
+    EXPECT_TRUE(page->GetTuple(rid, &tuple, nullptr, nullptr));
+    page->RUnlatch();
+    bpm->UnpinPage(rid.GetPageId(), false);
+    hash = hash * 31 + std::hash<std::string>()(std::string(tuple.GetData(), tuple.GetLength()));
+  }
+  return hash;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+// Update transactions from NUM_THREADS threads over a table that fits in the buffer pool, with a checkpoint every
+// CHECKPOINT_INTERVAL. A blocking checkpoint holds off every transaction while it flushes the whole pool, which shows
+// in the tail latency; a fuzzy one only logs its tables and writes the pages back in the background. After the fuzzy
+// run the system crashes, and recovery from the last checkpoint is timed against a scan of the whole log.
+TEST(DISABLED_CheckpointManagerBenchmarkTest, FuzzyCheckpointTest) {
+  Schema schema({Column("value", TypeId::VARCHAR, 100)});
+  std::vector<RID> rids;
+  size_t expected_hash = 0;
+
+  std::cout << "mode  txns/s  p50(us)  p99(us)  max(us)  checkpoints  checkpoint(ms)" << std::endl;
+  for (bool fuzzy : {false, true}) {
+    remove("test.db");
+    remove("test.log");
+    remove("test.ckpt");
+    rids.clear();
+    DiskManager disk_manager("test.db", DiskIoMode::POSITIONAL);
+    LogManager log_manager(&disk_manager);
+    BufferPoolManagerInstance bpm(POOL_SIZE, &disk_manager, &log_manager);
+    LockManager lock_manager;
+    TransactionManager txn_manager(&lock_manager, &log_manager);
+    CheckpointManager checkpoint_manager(&txn_manager, &log_manager, &bpm, &disk_manager);
+    log_manager.RunFlushThread();
+    // The load does not wait for a log write per page.
+    txn_manager.SetAsyncCommit(true);
+    const page_id_t first_page_id = LoadTable(&bpm, &lock_manager, &log_manager, &txn_manager, schema, &rids);
+    txn_manager.SetAsyncCommit(false);
+    TableHeap table(&bpm, &lock_manager, &log_manager, first_page_id);
+
+    std::atomic<bool> done{false};
+    LatencyHistogram txn_latencies;
+    std::atomic<int64_t> max_latency_ns{0};
+    std::atomic<size_t> num_txns{0};
+    std::vector<std::thread> threads;
+    for (size_t tid = 0; tid < NUM_THREADS; ++tid) {
+      threads.emplace_back([&, tid] {
+        // Disjoint rids per thread, so the transactions never wait for each other's locks.
+        const size_t begin = rids.size() * tid / NUM_THREADS;
+        const size_t end = rids.size() * (tid + 1) / NUM_THREADS;
+        std::mt19937 rng(tid);
+        std::uniform_int_distribution<size_t> pick(begin, end - 1);
+        const Tuple tuple = MakeTuple(schema, static_cast<char>('b' + tid));
+        while (!done) {
+          const auto start = std::chrono::steady_clock::now();
+          Transaction *txn = txn_manager.Begin();
+          for (size_t i = 0; i < UPDATES_PER_TXN; ++i) {
+            table.UpdateTuple(tuple, rids[pick(rng)], txn);
+          }
+          txn_manager.Commit(txn);
+          delete txn;
+          const auto latency = std::chrono::steady_clock::now() - start;
+          txn_latencies.Record(latency);
+          int64_t max_ns = max_latency_ns;
+          while (latency.count() > max_ns && !max_latency_ns.compare_exchange_weak(max_ns, latency.count())) {
+          }
+          num_txns++;
+        }
+      });
+    }
+
+    LatencyHistogram checkpoint_latencies;
+    const auto run_start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - run_start < RUN_TIME) {
+      std::this_thread::sleep_for(CHECKPOINT_INTERVAL);
+      const auto start = std::chrono::steady_clock::now();
+      if (fuzzy) {
+        checkpoint_manager.BeginCheckpoint();
+        checkpoint_latencies.RecordSince(start);
+        checkpoint_manager.EndCheckpoint();
+      } else {
+        txn_manager.BlockAllTransactions();
+        bpm.FlushAllPages();
+        log_manager.FlushUntil(log_manager.GetNextLSN() - 1);
+        txn_manager.ResumeTransactions();
+        checkpoint_latencies.RecordSince(start);
+      }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - run_start;
+    done = true;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    log_manager.StopFlushThread();
+
+    const HistogramSnapshot latencies = txn_latencies.GetSnapshot();
+    const HistogramSnapshot checkpoints = checkpoint_latencies.GetSnapshot();
+    std::cout << (fuzzy ? "fuzzy" : "blocking") << "  " << static_cast<uint64_t>(num_txns / elapsed.count()) << "  "
+              << latencies.GetPercentileNs(0.5) / 1000 << "  " << latencies.GetPercentileNs(0.99) / 1000 << "  "
+              << max_latency_ns / 1000 << "  " << checkpoints.count_ << "  " << checkpoints.GetMeanNs() / 1e6
+              << std::endl;
+
+    if (fuzzy) {
+      // Crash: nothing but the log and what the checkpoints wrote back is on disk.
+      std::filesystem::copy_file("test.db", "test_crash.db", std::filesystem::copy_options::overwrite_existing);
+      expected_hash = HashTable(&bpm, rids);
+    }
+  }
+
+  CheckpointMasterRecord master_record;
+  {
+    DiskManager disk_manager("test.db", DiskIoMode::POSITIONAL);
+    ASSERT_TRUE(disk_manager.ReadMasterRecord(reinterpret_cast<char *>(&master_record), sizeof(master_record)));
+  }
+  std::cout << "recovery  seconds  log read(MB)" << std::endl;
+  const auto log_size = static_cast<double>(std::filesystem::file_size("test.log"));
+  for (bool from_checkpoint : {false, true}) {
+    std::filesystem::copy_file("test_crash.db", "test.db", std::filesystem::copy_options::overwrite_existing);
+    DiskManager disk_manager("test.db", DiskIoMode::POSITIONAL);
+    if (from_checkpoint) {
+      disk_manager.WriteMasterRecord(reinterpret_cast<const char *>(&master_record), sizeof(master_record));
+    } else {
+      // Without a master record, recovery reads the log from its start.
+      remove("test.ckpt");
+    }
+    BufferPoolManagerInstance bpm(POOL_SIZE, &disk_manager);
+    LogManager log_manager(&disk_manager);
+    LogRecovery log_recovery(&disk_manager, &bpm, &log_manager);
+    const auto start = std::chrono::steady_clock::now();
+    log_recovery.Redo();
+    log_recovery.Undo();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const int64_t redo_offset = from_checkpoint ? master_record.redo_offset_ : 0;
+    std::cout << (from_checkpoint ? "checkpoint" : "full log") << "  " << elapsed.count() << "  "
+              << (log_size - static_cast<double>(redo_offset)) / (1 << 20) << std::endl;
+    EXPECT_EQ(HashTable(&bpm, rids), expected_hash);
+  }
+
+  remove("test.db");
+  remove("test_crash.db");
+  remove("test.fsm");
+  remove("test.log");
+  remove("test.ckpt");
+}
+
+}  // namespace bustub
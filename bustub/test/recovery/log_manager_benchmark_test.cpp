@@ -0,0 +1,200 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_benchmark_test.cpp
+//
+// Identification: test/recovery/log_manager_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// The benchmarks are disabled in the unit tests, run them with --gtest_also_run_disabled_tests.
+
+// NOLINTNEXTLINE
+// Empty transactions committed from more and more threads, each commit waiting for its log record to be synced. With
+// one thread every commit pays a whole log write; with more, the commits that arrive during one write share the next,
+// so the commits per DiskManager::WriteLog call grow with the thread count and the throughput with them.
+TEST(DISABLED_LogManagerBenchmarkTest, GroupCommitTest) {
+  const size_t commits_per_run = 2000;
+
+  std::cout << "threads  commits/s  log writes  commits/write" << std::endl;
+  for (size_t num_threads : {1, 2, 4, 8, 16, 32}) {
+    remove("test.db");
+    remove("test.log");
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    LockManager lock_manager;
+    TransactionManager txn_manager(&lock_manager, &log_manager);
+    log_manager.RunFlushThread();
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([&txn_manager, commits = commits_per_run / num_threads] {
+        for (size_t i = 0; i < commits; ++i) {
+          Transaction *txn = txn_manager.Begin();
+          txn_manager.Commit(txn);
+          delete txn;
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    log_manager.StopFlushThread();
+
+    const size_t num_commits = commits_per_run / num_threads * num_threads;
+    const int num_writes = disk_manager.GetNumFlushes();
+    std::cout << num_threads << "  " << static_cast<uint64_t>(num_commits / elapsed.count()) << "  " << num_writes
+              << "  " << static_cast<double>(num_commits) / num_writes << std::endl;
+    EXPECT_LE(num_writes, num_commits);
+    disk_manager.ShutDown();
+  }
+
+  remove("test.db");
+  remove("test.fsm");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+// The same empty transactions from 8 threads, committing synchronously, then asynchronously under durability lag
+// bounds. An asynchronous commit does not wait for the log write, so the throughput is that of appending the BEGIN and
+// COMMIT records; a monitor thread samples the durability lag, which stays around the bounds.
+TEST(DISABLED_LogManagerBenchmarkTest, AsyncCommitTest) {
+  const size_t num_threads = 8;
+  const size_t commits_per_thread = 5000;
+  struct Mode {
+    const char *name_;
+    bool async_commit_;
+    std::chrono::milliseconds max_lag_time_;
+    size_t max_lag_bytes_;
+  };
+  const Mode modes[] = {{"sync", false, std::chrono::milliseconds(0), 0},
+                        {"async 10ms", true, std::chrono::milliseconds(10), 0},
+                        {"async 2ms", true, std::chrono::milliseconds(2), 0},
+                        {"async 4KB", true, std::chrono::milliseconds(0), 4096},
+                        {"async 2ms 4KB", true, std::chrono::milliseconds(2), 4096}};
+
+  std::cout << "mode  commits/s  log writes  max lag(us)  max lag(bytes)" << std::endl;
+  for (const Mode &mode : modes) {
+    remove("test.db");
+    remove("test.log");
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    LockManager lock_manager;
+    TransactionManager txn_manager(&lock_manager, &log_manager);
+    txn_manager.SetAsyncCommit(mode.async_commit_);
+    log_manager.SetMaxDurabilityLag(mode.max_lag_time_, mode.max_lag_bytes_);
+    log_manager.RunFlushThread();
+
+    std::atomic<bool> done{false};
+    std::chrono::nanoseconds max_lag_time{0};
+    size_t max_lag_bytes = 0;
+    std::thread monitor([&] {
+      while (!done) {
+        const DurabilityLag lag = log_manager.GetDurabilityLag();
+        max_lag_time = std::max(max_lag_time, lag.time_);
+        max_lag_bytes = std::max(max_lag_bytes, lag.bytes_);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    });
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([&txn_manager, commits_per_thread] {
+        for (size_t i = 0; i < commits_per_thread; ++i) {
+          Transaction *txn = txn_manager.Begin();
+          txn_manager.Commit(txn);
+          delete txn;
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    done = true;
+    monitor.join();
+    log_manager.StopFlushThread();
+
+    std::cout << mode.name_ << "  " << static_cast<uint64_t>(num_threads * commits_per_thread / elapsed.count())
+              << "  " << disk_manager.GetNumFlushes() << "  "
+              << std::chrono::duration_cast<std::chrono::microseconds>(max_lag_time).count() << "  " << max_lag_bytes
+              << std::endl;
+    disk_manager.ShutDown();
+  }
+
+  remove("test.db");
+  remove("test.fsm");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+// Insert log records of a 100 byte tuple appended from more and more threads, with the flush thread writing the log
+// out in the background and nobody waiting for it. This is the log manager's share of a bulk insert: reserving room
+// in the log buffer, serializing the record into it, and swapping the buffers when they fill up.
+TEST(DISABLED_LogManagerBenchmarkTest, AppendTest) {
+  const size_t records_per_run = 400000;
+  Schema schema({Column("value", TypeId::VARCHAR, 100)});
+  const Tuple tuple({ValueFactory::GetVarcharValue(std::string(100, 'x'))}, &schema);
+
+  std::cout << "threads  records/s  MB/s" << std::endl;
+  for (size_t num_threads : {1, 2, 4, 8, 16, 32}) {
+    remove("test.db");
+    remove("test.log");
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    log_manager.RunFlushThread();
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([&log_manager, &tuple, tid, records = records_per_run / num_threads] {
+        for (size_t i = 0; i < records; ++i) {
+          LogRecord record(static_cast<txn_id_t>(tid), INVALID_LSN, LogRecordType::INSERT, RID(0, i), tuple);
+          log_manager.AppendLogRecord(&record);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    log_manager.StopFlushThread();
+
+    const size_t num_records = records_per_run / num_threads * num_threads;
+    EXPECT_EQ(num_records, log_manager.GetNextLSN());
+    const double record_size = 20 + sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
+    std::cout << num_threads << "  " << static_cast<uint64_t>(num_records / elapsed.count()) << "  "
+              << num_records * record_size / elapsed.count() / (1 << 20) << std::endl;
+    disk_manager.ShutDown();
+  }
+
+  remove("test.db");
+  remove("test.fsm");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,298 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+
+namespace bustub {
+
+class LogManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.fsm");
+  }
+
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.fsm");
+  }
+};
+
+/** The header of a log record as it is written to the log. */
+struct LogRecordHeader {
+  int32_t size_;
+  lsn_t lsn_;
+  txn_id_t txn_id_;
+  lsn_t prev_lsn_;
+  LogRecordType type_;
+};
+
+/** @return the headers of the records in the log file, in order */
+std::vector<LogRecordHeader> ReadLogHeaders(DiskManager *disk_manager) {
+  std::vector<LogRecordHeader> headers;
+  std::vector<char> log(LOG_BUFFER_SIZE);
+  int offset = 0;
+  while (disk_manager->ReadLog(log.data(), sizeof(LogRecordHeader), offset)) {
+    LogRecordHeader header;
+    memcpy(&header, log.data(), sizeof(LogRecordHeader));
+    if (header.size_ == 0) {
+      break;
+    }
+    headers.push_back(header);
+    offset += header.size_;
+  }
+  return headers;
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AppendTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+
+  LogRecord begin(0, INVALID_LSN, LogRecordType::BEGIN);
+  EXPECT_EQ(0, log_manager->AppendLogRecord(&begin));
+  EXPECT_EQ(0, begin.GetLSN());
+  LogRecord new_page(0, 0, LogRecordType::NEWPAGE, INVALID_PAGE_ID, 7);
+  EXPECT_EQ(1, log_manager->AppendLogRecord(&new_page));
+  LogRecord commit(0, 1, LogRecordType::COMMIT);
+  EXPECT_EQ(2, log_manager->AppendLogRecord(&commit));
+  EXPECT_EQ(3, log_manager->GetNextLSN());
+
+  // Nothing is written until somebody waits for it.
+  EXPECT_EQ(INVALID_LSN, log_manager->GetPersistentLSN());
+  EXPECT_EQ(0, disk_manager->GetNumFlushes());
+  log_manager->FlushUntil(1);
+  EXPECT_EQ(2, log_manager->GetPersistentLSN());
+  EXPECT_EQ(1, disk_manager->GetNumFlushes());
+  // Already persistent, no write.
+  log_manager->FlushUntil(2);
+  EXPECT_EQ(1, disk_manager->GetNumFlushes());
+
+  auto headers = ReadLogHeaders(disk_manager.get());
+  ASSERT_EQ(3, headers.size());
+  EXPECT_EQ(LogRecordType::BEGIN, headers[0].type_);
+  EXPECT_EQ(20, headers[0].size_);
+  EXPECT_EQ(LogRecordType::NEWPAGE, headers[1].type_);
+  EXPECT_EQ(28, headers[1].size_);
+  EXPECT_EQ(0, headers[1].prev_lsn_);
+  EXPECT_EQ(LogRecordType::COMMIT, headers[2].type_);
+  for (lsn_t lsn = 0; lsn < 3; ++lsn) {
+    EXPECT_EQ(lsn, headers[lsn].lsn_);
+    EXPECT_EQ(0, headers[lsn].txn_id_);
+  }
+
+  char payload[2 * sizeof(page_id_t)];
+  ASSERT_TRUE(disk_manager->ReadLog(payload, sizeof(payload), 20 + 20));
+  page_id_t page_ids[2];
+  memcpy(page_ids, payload, sizeof(page_ids));
+  EXPECT_EQ(INVALID_PAGE_ID, page_ids[0]);
+  EXPECT_EQ(7, page_ids[1]);
+
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, FullBufferTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  // More records than fit in the log buffer, once by the appender itself and once through the flush thread.
+  const int num_records = 3 * LOG_BUFFER_SIZE / 20;
+  for (int i = 0; i < num_records; ++i) {
+    LogRecord record(i, INVALID_LSN, LogRecordType::BEGIN);
+    log_manager->AppendLogRecord(&record);
+  }
+  const int records_per_buffer = LOG_BUFFER_SIZE / 20;
+  EXPECT_EQ((num_records - 1) / records_per_buffer, disk_manager->GetNumFlushes());
+  EXPECT_LT(log_manager->GetPersistentLSN(), num_records - 1);
+
+  log_manager->RunFlushThread();
+  EXPECT_TRUE(enable_logging);
+  for (int i = num_records; i < 2 * num_records; ++i) {
+    LogRecord record(i, INVALID_LSN, LogRecordType::BEGIN);
+    log_manager->AppendLogRecord(&record);
+  }
+  log_manager->StopFlushThread();
+  EXPECT_FALSE(enable_logging);
+  EXPECT_EQ(2 * num_records - 1, log_manager->GetPersistentLSN());
+
+  auto headers = ReadLogHeaders(disk_manager.get());
+  ASSERT_EQ(2 * num_records, headers.size());
+  for (int i = 0; i < 2 * num_records; ++i) {
+    EXPECT_EQ(i, headers[i].lsn_);
+    EXPECT_EQ(i, headers[i].txn_id_);
+  }
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, ConcurrentAppendTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  log_manager->RunFlushThread();
+
+  // Enough records for the buffers to be swapped many times while threads are appending.
+  const int num_threads = 8;
+  const int records_per_thread = LOG_BUFFER_SIZE / 4;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      lsn_t last_lsn = INVALID_LSN;
+      for (int i = 0; i < records_per_thread; ++i) {
+        LogRecord record(tid, last_lsn, LogRecordType::NEWPAGE, tid, i);
+        const lsn_t lsn = log_manager->AppendLogRecord(&record);
+        EXPECT_GT(lsn, last_lsn);
+        last_lsn = lsn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+
+  // Every record is in the log exactly once, in LSN order, and follows the one its thread appended before it.
+  const int num_records = num_threads * records_per_thread;
+  EXPECT_EQ(num_records - 1, log_manager->GetPersistentLSN());
+  std::vector<char> log(static_cast<size_t>(num_records) * 28);
+  ASSERT_TRUE(disk_manager->ReadLog(log.data(), log.size(), 0));
+  std::vector<int> next_page(num_threads, 0);
+  std::vector<lsn_t> last_lsns(num_threads, INVALID_LSN);
+  for (int i = 0; i < num_records; ++i) {
+    LogRecordHeader header;
+    page_id_t page_ids[2];
+    memcpy(&header, log.data() + i * 28, sizeof(header));
+    memcpy(page_ids, log.data() + i * 28 + sizeof(header), sizeof(page_ids));
+    ASSERT_EQ(i, header.lsn_);
+    ASSERT_EQ(LogRecordType::NEWPAGE, header.type_);
+    ASSERT_EQ(header.txn_id_, page_ids[0]);
+    EXPECT_EQ(last_lsns[header.txn_id_], header.prev_lsn_);
+    EXPECT_EQ(next_page[header.txn_id_]++, page_ids[1]);
+    last_lsns[header.txn_id_] = header.lsn_;
+  }
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, GroupCommitTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager.get());
+  log_manager->RunFlushThread();
+
+  const int num_threads = 8;
+  const int commits_per_thread = 50;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < commits_per_thread; ++i) {
+        Transaction *txn = txn_manager.Begin();
+        txn_manager.Commit(txn);
+        // The commit record is durable once Commit returns.
+        EXPECT_LE(txn->GetPrevLSN(), log_manager->GetPersistentLSN());
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+
+  const int num_commits = num_threads * commits_per_thread;
+  EXPECT_EQ(2 * num_commits - 1, log_manager->GetPersistentLSN());
+  EXPECT_LE(disk_manager->GetNumFlushes(), num_commits);
+
+  // Every transaction wrote a BEGIN and then a COMMIT that points back to it.
+  auto headers = ReadLogHeaders(disk_manager.get());
+  ASSERT_EQ(2 * num_commits, headers.size());
+  std::vector<lsn_t> begin_lsns(num_commits, INVALID_LSN);
+  for (const auto &header : headers) {
+    if (header.type_ == LogRecordType::BEGIN) {
+      begin_lsns[header.txn_id_] = header.lsn_;
+    } else {
+      ASSERT_EQ(LogRecordType::COMMIT, header.type_);
+      EXPECT_EQ(begin_lsns[header.txn_id_], header.prev_lsn_);
+    }
+  }
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AsyncCommitTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  LockManager lock_manager;
+  TransactionManager txn_manager(&lock_manager, log_manager.get());
+  txn_manager.SetAsyncCommit(true);
+  log_manager->RunFlushThread();
+
+  // Without a bound, the commit returns before its record is written, which waits for the log timeout.
+  Transaction *txn = txn_manager.Begin();
+  EXPECT_TRUE(txn->IsAsyncCommit());
+  txn_manager.Commit(txn);
+  EXPECT_LT(log_manager->GetPersistentLSN(), txn->GetPrevLSN());
+  DurabilityLag lag = log_manager->GetDurabilityLag();
+  EXPECT_EQ(40, lag.bytes_);
+  EXPECT_GT(lag.time_.count(), 0);
+  log_manager->FlushUntil(txn->GetPrevLSN());
+  EXPECT_EQ(0, log_manager->GetDurabilityLag().bytes_);
+  delete txn;
+
+  // With a bound in time, the flush thread writes the record out long before the log timeout.
+  log_manager->SetMaxDurabilityLag(std::chrono::milliseconds(20), 0);
+  txn = txn_manager.Begin();
+  auto start = std::chrono::steady_clock::now();
+  txn_manager.Commit(txn);
+  while (log_manager->GetPersistentLSN() < txn->GetPrevLSN()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::duration_cast<std::chrono::milliseconds>(log_timeout) / 2);
+  delete txn;
+
+  // With a bound in bytes, commits stop running ahead of the log once there are more bytes waiting for a write.
+  log_manager->SetMaxDurabilityLag(std::chrono::milliseconds(0), 1000);
+  for (int i = 0; i < 200; ++i) {
+    txn = txn_manager.Begin();
+    // a transaction that commits synchronously among the asynchronous ones
+    txn->SetAsyncCommit(i % 50 != 0);
+    txn_manager.Commit(txn);
+    EXPECT_LE(log_manager->GetDurabilityLag().bytes_, 1000);
+    if (!txn->IsAsyncCommit()) {
+      EXPECT_GE(log_manager->GetPersistentLSN(), txn->GetPrevLSN());
+    }
+    delete txn;
+  }
+
+  const LogMetrics metrics = log_manager->GetMetrics();
+  EXPECT_GT(metrics.writes_.count_, 0);
+  EXPECT_GT(metrics.flush_waits_.count_, 0);
+  log_manager->StopFlushThread();
+  EXPECT_EQ(0, log_manager->GetMetrics().lag_.bytes_);
+  disk_manager->ShutDown();
+}
+
+}  // namespace bustub
@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_recovery_benchmark_test.cpp
+//
+// Identification: test/recovery/log_recovery_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/page/table_page.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// The benchmarks are disabled in the unit tests, run them with --gtest_also_run_disabled_tests.
+
+// NOLINTNEXTLINE
+// Redo of a generated log with more and more redo threads, from an empty database file as after a crash that lost
+// every page. The log is a bulk load of 100 byte tuples, 30 to a page, with the inserts of 1024 pages interleaved
+// like those of concurrent transactions. The log is a few hundred MB; set BUSTUB_RECOVERY_LOG_MB for a bigger one.
+TEST(DISABLED_LogRecoveryBenchmarkTest, RedoTest) {
+  const char *log_mb = std::getenv("BUSTUB_RECOVERY_LOG_MB");
+  const int64_t log_size = (log_mb == nullptr ? 256 : std::atoll(log_mb)) << 20;
+  const page_id_t pages_per_txn = 1024;
+  const uint32_t tuples_per_page = 30;
+  Schema schema({Column("value", TypeId::VARCHAR, 100)});
+  const Tuple tuple({ValueFactory::GetVarcharValue(std::string(100, 'x'))}, &schema);
+
+  remove("test.db");
+  remove("test.log");
+  int64_t num_records = 0;
+  page_id_t num_pages = 0;
+  int64_t logged = 0;
+  {
+    DiskManager disk_manager("test.db");
+    LogManager log_manager(&disk_manager);
+    log_manager.RunFlushThread();
+    for (txn_id_t txn_id = 0; logged < log_size; ++txn_id) {
+      LogRecord begin(txn_id, INVALID_LSN, LogRecordType::BEGIN);
+      log_manager.AppendLogRecord(&begin);
+      logged += begin.GetSize();
+      const page_id_t first_page_id = num_pages;
+      for (page_id_t page_id = first_page_id; page_id < first_page_id + pages_per_txn; ++page_id) {
+        LogRecord new_page(txn_id, INVALID_LSN, LogRecordType::NEWPAGE, page_id - 1, page_id);
+        log_manager.AppendLogRecord(&new_page);
+        logged += new_page.GetSize();
+      }
+      for (uint32_t slot = 0; slot < tuples_per_page; ++slot) {
+        for (page_id_t page_id = first_page_id; page_id < first_page_id + pages_per_txn; ++page_id) {
+          LogRecord insert(txn_id, INVALID_LSN, LogRecordType::INSERT, RID(page_id, slot), tuple);
+          log_manager.AppendLogRecord(&insert);
+          logged += insert.GetSize();
+        }
+      }
+      LogRecord commit(txn_id, INVALID_LSN, LogRecordType::COMMIT);
+      log_manager.AppendLogRecord(&commit);
+      logged += commit.GetSize();
+      num_records += 2 + pages_per_txn * (tuples_per_page + 1);
+      num_pages += pages_per_txn;
+    }
+    log_manager.StopFlushThread();
+    disk_manager.ShutDown();
+  }
+
+  std::cout << "log: " << (logged >> 20) << " MB, " << num_records << " records, " << num_pages << " pages"
+            << std::endl;
+  std::cout << "threads  seconds  MB/s  records/s" << std::endl;
+  for (size_t num_threads : {1, 2, 4, 8}) {
+    remove("test.db");
+    DiskManager disk_manager("test.db", DiskIoMode::POSITIONAL);
+    ParallelBufferPoolManager bpm(8, 256, &disk_manager);
+    LogManager log_manager(&disk_manager);
+    LogRecovery log_recovery(&disk_manager, &bpm, &log_manager, num_threads);
+
+    auto start = std::chrono::steady_clock::now();
+    log_recovery.Redo();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    log_recovery.Undo();
+
+    std::cout << num_threads << "  " << elapsed.count() << "  "
+              << static_cast<double>(logged) / (1 << 20) / elapsed.count() << "  "
+              << static_cast<uint64_t>(num_records / elapsed.count()) << std::endl;
+
+    // Spot check the last page, redone from the end of the log.
+    auto *page = reinterpret_cast<TablePage *>(bpm.FetchPage(num_pages - 1));
+    ASSERT_NE(page, nullptr);
+    EXPECT_EQ(page->GetTablePageId(), num_pages - 1);
+    EXPECT_EQ(page->GetPrevPageId(), num_pages - 2);
+    uint32_t num_tuples = 0;
+    RID rid;
+    for (bool found = page->GetFirstTupleRid(&rid); found; found = page->GetNextTupleRid(rid, &rid)) {
+      ++num_tuples;
+    }
+    EXPECT_EQ(num_tuples, tuples_per_page);
+    bpm.UnpinPage(num_pages - 1, false);
+    disk_manager.ShutDown();
+  }
+
+  remove("test.db");
+  remove("test.fsm");
+  remove("test.log");
+}
+
+}  // namespace bustub
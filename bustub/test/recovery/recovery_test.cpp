@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -19,6 +20,7 @@
 #include "concurrency/transaction_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "recovery/checkpoint_manager.h"
 #include "recovery/log_recovery.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/table_iterator.h"
@@ -32,6 +34,8 @@ class RecoveryTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.warm");
+    remove("test.ckpt");
   }
 
   // This function is called after every test.
@@ -39,11 +43,13 @@ class RecoveryTest : public ::testing::Test {
     LOG_INFO("Tearing down the system..");
     remove("test.db");
     remove("test.log");
+    remove("test.warm");
+    remove("test.ckpt");
   };
 };
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_RedoTest) {
+TEST_F(RecoveryTest, RedoTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   ASSERT_FALSE(enable_logging);
@@ -101,7 +107,8 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
   delete txn;
 
   LOG_INFO("Begin recovery");
-  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
 
   ASSERT_FALSE(enable_logging);
 
@@ -132,7 +139,7 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_UndoTest) {
+TEST_F(RecoveryTest, UndoTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   ASSERT_FALSE(enable_logging);
@@ -185,7 +192,8 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
   delete txn;
 
   LOG_INFO("Recovery started..");
-  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
 
   ASSERT_FALSE(enable_logging);
 
@@ -211,7 +219,177 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
+TEST_F(RecoveryTest, ParallelRedoTest) {
+  BustubInstance *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  // Enough tuples for many more pages than the buffer pool holds, so that some reach the disk before the crash.
+  LOG_INFO("Insert and commit");
+  std::vector<RID> committed_rids(2000);
+  std::vector<Tuple> committed_tuples;
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (RID &rid : committed_rids) {
+    committed_tuples.push_back(ConstructTuple(&schema));
+    ASSERT_TRUE(test_table->InsertTuple(committed_tuples.back(), &rid, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  LOG_INFO("Insert and delete without committing");
+  std::vector<RID> loser_rids(200);
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (RID &rid : loser_rids) {
+    ASSERT_TRUE(test_table->InsertTuple(ConstructTuple(&schema), &rid, txn));
+  }
+  for (size_t i = 0; i < committed_rids.size(); i += 10) {
+    ASSERT_TRUE(test_table->MarkDelete(committed_rids[i], txn));
+  }
+  delete txn;
+  delete test_table;
+
+  LOG_INFO("System crash before commit");
+  delete bustub_instance;
+  bustub_instance = new BustubInstance("test.db");
+
+  LOG_INFO("Recovery with 4 redo threads");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_, 4);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  for (size_t i = 0; i < committed_rids.size(); ++i) {
+    Tuple tuple;
+    ASSERT_TRUE(test_table->GetTuple(committed_rids[i], &tuple, txn)) << "tuple " << i;
+    ASSERT_EQ(tuple.GetLength(), committed_tuples[i].GetLength());
+    ASSERT_EQ(memcmp(tuple.GetData(), committed_tuples[i].GetData(), tuple.GetLength()), 0) << "tuple " << i;
+  }
+  for (const RID &rid : loser_rids) {
+    Tuple tuple;
+    ASSERT_FALSE(test_table->GetTuple(rid, &tuple, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  // A new page must not reuse a page of the log that never reached the disk.
+  page_id_t new_page_id;
+  ASSERT_NE(bustub_instance->buffer_pool_manager_->NewPage(&new_page_id), nullptr);
+  for (const RID &rid : committed_rids) {
+    ASSERT_NE(new_page_id, rid.GetPageId());
+  }
+  bustub_instance->buffer_pool_manager_->UnpinPage(new_page_id, false);
+
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, FuzzyCheckpointRecoveryTest) {
+  BustubInstance *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  LOG_INFO("Insert and commit before the checkpoint");
+  std::vector<RID> committed_rids(1000);
+  std::vector<Tuple> committed_tuples;
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (RID &rid : committed_rids) {
+    committed_tuples.push_back(ConstructTuple(&schema));
+    ASSERT_TRUE(test_table->InsertTuple(committed_tuples.back(), &rid, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  LOG_INFO("Checkpoint while a transaction is running");
+  std::vector<RID> loser_rids(100);
+  Transaction *loser_txn = bustub_instance->transaction_manager_->Begin();
+  for (RID &rid : loser_rids) {
+    ASSERT_TRUE(test_table->InsertTuple(ConstructTuple(&schema), &rid, loser_txn));
+  }
+  bustub_instance->checkpoint_manager_->BeginCheckpoint();
+  bustub_instance->checkpoint_manager_->EndCheckpoint();
+  CheckpointMasterRecord master_record;
+  ASSERT_TRUE(bustub_instance->disk_manager_->ReadMasterRecord(reinterpret_cast<char *>(&master_record),
+                                                               sizeof(master_record)));
+  EXPECT_LE(master_record.redo_lsn_, master_record.begin_lsn_);
+  EXPECT_LE(master_record.redo_offset_, master_record.begin_offset_);
+
+  LOG_INFO("Insert and commit after the checkpoint, delete without committing");
+  std::vector<RID> later_rids(500);
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (RID &rid : later_rids) {
+    committed_tuples.push_back(ConstructTuple(&schema));
+    ASSERT_TRUE(test_table->InsertTuple(committed_tuples.back(), &rid, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  committed_rids.insert(committed_rids.end(), later_rids.begin(), later_rids.end());
+  for (size_t i = 0; i < committed_rids.size(); i += 10) {
+    ASSERT_TRUE(test_table->MarkDelete(committed_rids[i], loser_txn));
+  }
+  delete loser_txn;
+  delete test_table;
+
+  LOG_INFO("System crash before commit");
+  delete bustub_instance;
+  bustub_instance = new BustubInstance("test.db");
+
+  LOG_INFO("Recovery from the checkpoint");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_, 4);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  for (size_t i = 0; i < committed_rids.size(); ++i) {
+    Tuple tuple;
+    ASSERT_TRUE(test_table->GetTuple(committed_rids[i], &tuple, txn)) << "tuple " << i;
+    ASSERT_EQ(tuple.GetLength(), committed_tuples[i].GetLength());
+    ASSERT_EQ(memcmp(tuple.GetData(), committed_tuples[i].GetData(), tuple.GetLength()), 0) << "tuple " << i;
+  }
+  for (const RID &rid : loser_rids) {
+    Tuple tuple;
+    ASSERT_FALSE(test_table->GetTuple(rid, &tuple, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, CheckpointTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   EXPECT_FALSE(enable_logging);
@@ -314,4 +492,156 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   LOG_INFO("Shutdown System");
   delete bustub_instance;
 }
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, LSNAcrossSessionsTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple = ConstructTuple(&schema);
+  const Tuple tuple1 = ConstructTuple(&schema);
+  Tuple tuple2 = ConstructTuple(&schema);
+  while (tuple2.GetValue(&schema, 1).CompareEquals(tuple1.GetValue(&schema, 1)) == CmpBool::CmpTrue) {
+    tuple2 = ConstructTuple(&schema);
+  }
+
+  LOG_INFO("First session: many updates, then a clean shutdown");
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  RID rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+  for (int i = 0; i < 500; i++) {
+    ASSERT_TRUE(test_table->UpdateTuple(i % 2 == 0 ? tuple : tuple1, rid, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  const lsn_t first_session_lsn = bustub_instance->log_manager_->GetNextLSN();
+  bustub_instance->log_manager_->StopFlushThread();
+  bustub_instance->buffer_pool_manager_->FlushAllPages();
+  delete bustub_instance;
+
+  LOG_INFO("Second session: one committed update, then a crash");
+  bustub_instance = new BustubInstance("test.db");
+  ASSERT_EQ(bustub_instance->log_manager_->GetNextLSN(), first_session_lsn);
+  bustub_instance->log_manager_->RunFlushThread();
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  ASSERT_TRUE(test_table->UpdateTuple(tuple2, rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  LOG_INFO("Recovery must redo the second session over the pages of the first");
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+
+  Tuple recovered_tuple;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  ASSERT_TRUE(test_table->GetTuple(rid, &recovered_tuple, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  EXPECT_EQ(recovered_tuple.GetValue(&schema, 0).CompareEquals(tuple2.GetValue(&schema, 0)), CmpBool::CmpTrue);
+  EXPECT_EQ(recovered_tuple.GetValue(&schema, 1).CompareEquals(tuple2.GetValue(&schema, 1)), CmpBool::CmpTrue);
+
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, RepeatedRecoveryTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple = ConstructTuple(&schema);
+  const Tuple loser_tuple = ConstructTuple(&schema);
+  const Tuple new_tuple = ConstructTuple(&schema);
+  auto same = [&](const Tuple &a, const Tuple &b) {
+    return a.GetValue(&schema, 0).CompareEquals(b.GetValue(&schema, 0)) == CmpBool::CmpTrue &&
+           a.GetValue(&schema, 1).CompareEquals(b.GetValue(&schema, 1)) == CmpBool::CmpTrue;
+  };
+
+  LOG_INFO("A committed insert, then a loser that updates it and inserts, and a crash");
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  RID rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  txn = bustub_instance->transaction_manager_->Begin();
+  RID loser_rid;
+  ASSERT_TRUE(test_table->UpdateTuple(loser_tuple, rid, txn));
+  ASSERT_TRUE(test_table->InsertTuple(loser_tuple, &loser_rid, txn));
+  bustub_instance->buffer_pool_manager_->FlushPage(first_page_id);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  LOG_INFO("Recovery, then committed changes over the undone ones, and a crash");
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  bustub_instance->log_manager_->RunFlushThread();
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple recovered_tuple;
+  ASSERT_TRUE(test_table->GetTuple(rid, &recovered_tuple, txn));
+  ASSERT_TRUE(same(recovered_tuple, tuple));
+  ASSERT_FALSE(test_table->GetTuple(loser_rid, &recovered_tuple, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  txn = bustub_instance->transaction_manager_->Begin();
+  RID new_rid;
+  ASSERT_TRUE(test_table->UpdateTuple(new_tuple, rid, txn));
+  ASSERT_TRUE(test_table->InsertTuple(new_tuple, &new_rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  LOG_INFO("The second recovery must not undo the loser again");
+  bustub_instance = new BustubInstance("test.db");
+  const int64_t log_size = bustub_instance->disk_manager_->GetLogFileSize();
+  log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                 bustub_instance->log_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  EXPECT_EQ(bustub_instance->disk_manager_->GetLogFileSize(), log_size);
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  ASSERT_TRUE(test_table->GetTuple(rid, &recovered_tuple, txn));
+  EXPECT_TRUE(same(recovered_tuple, new_tuple));
+  ASSERT_TRUE(test_table->GetTuple(new_rid, &recovered_tuple, txn));
+  EXPECT_TRUE(same(recovered_tuple, new_tuple));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  delete bustub_instance;
+}
 }  // namespace bustub
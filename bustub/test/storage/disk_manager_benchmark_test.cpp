@@ -0,0 +1,176 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_benchmark_test.cpp
+//
+// Identification: test/storage/disk_manager_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+// The benchmarks are disabled in the unit tests, run them with --gtest_also_run_disabled_tests.
+
+namespace {
+
+/**
+ * Read random pages of the first num_pages pages from num_threads threads, checking that every page carries its id.
+ * @return the aggregate throughput in pages per second
+ */
+double RandomReads(DiskManager *disk_manager, size_t num_threads, size_t reads_per_thread, int num_pages) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([disk_manager, tid, reads_per_thread, num_pages] {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+      char buf[PAGE_SIZE];
+      for (size_t i = 0; i < reads_per_thread; ++i) {
+        page_id_t page_id = page_dist(rng);
+        disk_manager->ReadPage(page_id, buf);
+        page_id_t stored_page_id;
+        memcpy(&stored_page_id, buf, sizeof(page_id_t));
+        EXPECT_EQ(page_id, stored_page_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(num_threads * reads_per_thread) / elapsed.count();
+}
+
+/** @return the number of bytes of the file that are in the OS page cache */
+size_t PageCacheBytes(const std::string &file_name) {
+  const int fd = open(file_name.c_str(), O_RDONLY);
+  const off_t size = lseek(fd, 0, SEEK_END);
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  const size_t os_page_size = sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> resident((size + os_page_size - 1) / os_page_size);
+  mincore(addr, size, resident.data());
+  munmap(addr, size);
+  close(fd);
+  return std::count_if(resident.begin(), resident.end(), [](unsigned char r) { return (r & 1) != 0; }) * os_page_size;
+}
+
+/** @return the latency in microseconds below which the given fraction of the sorted latencies fall */
+double Percentile(const std::vector<double> &sorted_latencies, double fraction) {
+  return sorted_latencies[static_cast<size_t>(fraction * (sorted_latencies.size() - 1))];
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+// Random page reads from many threads, STREAM mode (one latched fstream, stat per read) against POSITIONAL mode
+// (pread, cached file size). The file is small enough to stay in the page cache, so this measures the I/O path itself.
+TEST(DISABLED_DiskManagerBenchmarkTest, ParallelRandomReadTest) {
+  const std::string db_name = "test.db";
+  const int num_pages = 1024;
+  const size_t reads_per_thread = 5000;
+
+  remove(db_name.c_str());
+  {
+    DiskManager disk_manager(db_name, DiskIoMode::POSITIONAL);
+    char buf[PAGE_SIZE] = {0};
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      memcpy(buf, &page_id, sizeof(page_id_t));
+      disk_manager.WritePage(page_id, buf);
+    }
+    disk_manager.ShutDown();
+  }
+
+  DiskManager stream(db_name, DiskIoMode::STREAM);
+  DiskManager positional(db_name, DiskIoMode::POSITIONAL);
+  std::cout << "threads  stream(pages/s)  positional(pages/s)" << std::endl;
+  for (size_t num_threads : {1, 2, 4, 8, 16}) {
+    double stream_rate = RandomReads(&stream, num_threads, reads_per_thread, num_pages);
+    double positional_rate = RandomReads(&positional, num_threads, reads_per_thread, num_pages);
+    std::cout << num_threads << "  " << static_cast<uint64_t>(stream_rate) << "  "
+              << static_cast<uint64_t>(positional_rate) << std::endl;
+  }
+  stream.ShutDown();
+  positional.ShutDown();
+
+  remove(db_name.c_str());
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+// Random page writes then reads over a file, with and without direct I/O, starting with none of the file in the OS
+// page cache. Buffered I/O leaves every page it touched in the page cache, memory the buffer pool already spends on
+// the pages it keeps; its writes only copy into the page cache, and its reads get faster as the cache fills up. Direct
+// I/O keeps the page cache empty and pays a device access for every page, so its latencies are steadier but higher.
+TEST(DISABLED_DiskManagerBenchmarkTest, DirectIoTest) {
+  const std::string db_name = "test.db";
+  const int num_pages = 8192;
+  const size_t num_ops = 20000;
+
+  std::cout << "mode  write p50/p99/p99.9(us)  read p50/p99/p99.9(us)  page cache(KB)" << std::endl;
+  for (bool direct_io : {false, true}) {
+    remove(db_name.c_str());
+    DiskManager disk_manager(db_name, DiskIoMode::POSITIONAL, direct_io);
+    alignas(DiskManager::DIRECT_IO_ALIGNMENT) static char buf[PAGE_SIZE];
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      memcpy(buf, &page_id, sizeof(page_id_t));
+      disk_manager.WritePage(page_id, buf);
+    }
+    disk_manager.SyncPages();
+    // drop the (clean) pages of the file from the page cache
+    const int fd = open(db_name.c_str(), O_RDONLY);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+
+    std::default_random_engine rng(0);
+    std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+    std::vector<double> write_latencies;
+    std::vector<double> read_latencies;
+    for (size_t i = 0; i < 2 * num_ops; ++i) {
+      const page_id_t page_id = page_dist(rng);
+      const bool is_write = i < num_ops;
+      memcpy(buf, &page_id, sizeof(page_id_t));
+      auto start = std::chrono::steady_clock::now();
+      if (is_write) {
+        disk_manager.WritePage(page_id, buf);
+      } else {
+        disk_manager.ReadPage(page_id, buf);
+      }
+      std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+      (is_write ? write_latencies : read_latencies).push_back(elapsed.count());
+    }
+    disk_manager.SyncPages();
+    std::sort(write_latencies.begin(), write_latencies.end());
+    std::sort(read_latencies.begin(), read_latencies.end());
+    std::cout << (disk_manager.HasDirectIo() ? "direct" : "buffered") << "  " << Percentile(write_latencies, 0.5)
+              << "/" << Percentile(write_latencies, 0.99) << "/" << Percentile(write_latencies, 0.999) << "  "
+              << Percentile(read_latencies, 0.5) << "/" << Percentile(read_latencies, 0.99) << "/"
+              << Percentile(read_latencies, 0.999) << "  " << PageCacheBytes(db_name) / 1024 << std::endl;
+    disk_manager.ShutDown();
+  }
+
+  remove(db_name.c_str());
+  remove("test.fsm");
+  remove("test.log");
+}
+
+}  // namespace bustub
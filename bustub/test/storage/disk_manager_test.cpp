@@ -11,6 +11,8 @@
 //===----------------------------------------------------------------------===//
 
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -24,12 +26,14 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
   };
 };
 
@@ -55,6 +59,267 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PositionalReadWritePageTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file, DiskIoMode::POSITIONAL);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  dm.ReadPage(0, buf);  // tolerate empty read
+
+  dm.WritePage(0, data);
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  std::memset(buf, 0, sizeof(buf));
+  dm.WritePage(5, data);
+  dm.ReadPage(5, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // the pages skipped over read back as zeros
+  char zeros[PAGE_SIZE] = {0};
+  dm.ReadPage(3, buf);
+  EXPECT_EQ(std::memcmp(buf, zeros, sizeof(buf)), 0);
+  EXPECT_EQ(2, dm.GetNumWrites());
+
+  dm.SyncPages();
+  dm.ShutDown();
+
+  // the pages are there for a stream mode disk manager on the same file
+  auto stream_dm = DiskManager(db_file);
+  std::memset(buf, 0, sizeof(buf));
+  stream_dm.ReadPage(5, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  stream_dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SubmitPageIoTest) {
+  const int num_pages = 64;
+  std::string db_file("test.db");
+  for (DiskIoMode io_mode : {DiskIoMode::STREAM, DiskIoMode::POSITIONAL, DiskIoMode::IO_URING}) {
+    remove("test.db");
+    auto dm = DiskManager(db_file, io_mode);
+    std::vector<char> data(num_pages * PAGE_SIZE);
+    std::vector<char> buf(num_pages * PAGE_SIZE);
+    std::vector<PageIoRequest> writes;
+    std::vector<PageIoRequest> reads;
+    for (int i = 0; i < num_pages; ++i) {
+      std::memset(&data[i * PAGE_SIZE], 'a' + i % 26, PAGE_SIZE);
+      writes.push_back({true, i, &data[i * PAGE_SIZE]});
+      reads.push_back({false, i, &buf[i * PAGE_SIZE]});
+    }
+
+    // one batch of writes, then one batch of reads
+    dm.SubmitPageIo(writes).wait();
+    dm.SubmitPageIo(reads).wait();
+    EXPECT_EQ(std::memcmp(buf.data(), data.data(), data.size()), 0);
+    EXPECT_EQ(num_pages, dm.GetNumWrites());
+
+    // a page past the end of the file reads as zeros
+    char page[PAGE_SIZE];
+    char zeros[PAGE_SIZE] = {0};
+    std::memset(page, 'x', PAGE_SIZE);
+    dm.SubmitPageIo({{false, 2 * num_pages, page}}).wait();
+    EXPECT_EQ(std::memcmp(page, zeros, PAGE_SIZE), 0);
+
+    // an ordered batch writes the buffer out before reading another page into it
+    std::memset(page, 'x', PAGE_SIZE);
+    dm.SubmitPageIo({{true, num_pages, page}, {false, 3, page}}, true).wait();
+    EXPECT_EQ(std::memcmp(page, &data[3 * PAGE_SIZE], PAGE_SIZE), 0);
+    dm.ReadPage(num_pages, page);
+    EXPECT_EQ(page[0], 'x');
+    EXPECT_EQ(page[PAGE_SIZE - 1], 'x');
+
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  const int num_pages = 150;
+  std::string db_file("test.db");
+  for (DiskIoMode io_mode : {DiskIoMode::STREAM, DiskIoMode::POSITIONAL, DiskIoMode::IO_URING}) {
+    remove("test.db");
+    auto dm = DiskManager(db_file, io_mode);
+    std::vector<char> data(num_pages * PAGE_SIZE);
+    std::vector<const char *> pages;
+    for (int i = 0; i < num_pages; ++i) {
+      std::memset(&data[i * PAGE_SIZE], 'a' + i % 26, PAGE_SIZE);
+      pages.push_back(&data[i * PAGE_SIZE]);
+    }
+
+    // a run longer than one vectored write
+    dm.WritePages(0, pages);
+    EXPECT_EQ(num_pages, dm.GetNumWrites());
+    EXPECT_EQ(num_pages * PAGE_SIZE, dm.GetDbFileSize());
+    char buf[PAGE_SIZE];
+    for (int i = 0; i < num_pages; ++i) {
+      dm.ReadPage(i, buf);
+      EXPECT_EQ(std::memcmp(buf, &data[i * PAGE_SIZE], PAGE_SIZE), 0);
+    }
+
+    // a sorted batch with gaps and a read in between: each run of adjacent writes is merged, the rest is unchanged
+    std::vector<char> update(PAGE_SIZE * 6);
+    std::memset(update.data(), 'X', update.size());
+    std::memset(buf, 0, PAGE_SIZE);
+    dm.SubmitPageIo({{true, 10, &update[0]},
+                     {true, 11, &update[PAGE_SIZE]},
+                     {true, 12, &update[2 * PAGE_SIZE]},
+                     {false, 13, buf},
+                     {true, 14, &update[3 * PAGE_SIZE]},
+                     {true, 20, &update[4 * PAGE_SIZE]},
+                     {true, 21, &update[5 * PAGE_SIZE]}})
+        .wait();
+    EXPECT_EQ(num_pages + 6, dm.GetNumWrites());
+    EXPECT_EQ(std::memcmp(buf, &data[13 * PAGE_SIZE], PAGE_SIZE), 0);
+    for (int i = 9; i < 23; ++i) {
+      dm.ReadPage(i, buf);
+      const bool updated = (i >= 10 && i <= 12) || i == 14 || i == 20 || i == 21;
+      EXPECT_EQ(buf[0], updated ? 'X' : 'a' + i % 26);
+      EXPECT_EQ(buf[PAGE_SIZE - 1], updated ? 'X' : 'a' + i % 26);
+    }
+
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  for (page_id_t page_id = 0; page_id < 10; ++page_id) {
+    dm.WritePage(page_id, data);
+  }
+  EXPECT_EQ(10 * PAGE_SIZE, dm.GetDbFileSize());
+  EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage());
+
+  dm.DeallocatePage(7);
+  dm.DeallocatePage(2);
+  dm.DeallocatePage(5);
+  dm.DeallocatePage(5);  // freeing twice is ignored
+  EXPECT_EQ(3U, dm.GetNumFreePages());
+
+  // with two buffer pool instances, each only gets back its own pages, lowest first
+  EXPECT_EQ(5, dm.AllocateFreePage(2, 1));
+  EXPECT_EQ(7, dm.AllocateFreePage(2, 1));
+  EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage(2, 1));
+  EXPECT_EQ(1U, dm.GetNumFreePages());
+  dm.DeallocatePage(9);
+  dm.ShutDown();
+
+  // the free space map survives a restart
+  auto reopened = DiskManager(db_file);
+  EXPECT_EQ(2U, reopened.GetNumFreePages());
+  EXPECT_EQ(2, reopened.AllocateFreePage());
+  EXPECT_EQ(9, reopened.AllocateFreePage());
+  EXPECT_EQ(INVALID_PAGE_ID, reopened.AllocateFreePage());
+  reopened.DeallocatePage(3);
+  reopened.DeallocatePage(4);
+  reopened.SyncPages();
+
+  // an allocation only reaches the file with the next sync, after a crash recovery claims the page again
+  EXPECT_EQ(3, reopened.AllocateFreePage());
+  {
+    auto crashed = DiskManager(db_file);
+    EXPECT_EQ(2U, crashed.GetNumFreePages());
+    crashed.ClaimPage(3);
+    crashed.ClaimPage(3);  // claiming a page that is not free does nothing
+    EXPECT_EQ(1U, crashed.GetNumFreePages());
+    EXPECT_EQ(4, crashed.AllocateFreePage());
+  }
+  reopened.ShutDown();
+
+  // but not the db file being replaced by a new one
+  remove("test.db");
+  auto fresh = DiskManager(db_file);
+  EXPECT_EQ(0U, fresh.GetNumFreePages());
+  EXPECT_EQ(0, fresh.GetDbFileSize());
+  fresh.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIoTest) {
+  const int num_pages = 8;
+  std::string db_file("test.db");
+  for (DiskIoMode io_mode : {DiskIoMode::POSITIONAL, DiskIoMode::IO_URING}) {
+    remove("test.db");
+    auto dm = DiskManager(db_file, io_mode, true);
+    // aligned holds whole pages on DIRECT_IO_ALIGNMENT boundaries, unaligned the same pages one byte further
+    alignas(DiskManager::DIRECT_IO_ALIGNMENT) static char aligned[(num_pages + 1) * PAGE_SIZE];
+    alignas(DiskManager::DIRECT_IO_ALIGNMENT) static char page[PAGE_SIZE];
+    char *unaligned = aligned + 1;
+    char buf[PAGE_SIZE + 1];
+    for (int i = 0; i < num_pages; ++i) {
+      std::memset(&aligned[i * PAGE_SIZE], 'a' + i, PAGE_SIZE);
+    }
+
+    // single pages, from aligned and unaligned buffers
+    dm.WritePage(0, &aligned[0]);
+    dm.WritePage(1, &unaligned[PAGE_SIZE]);
+    dm.ReadPage(0, buf + 1);
+    EXPECT_EQ(std::memcmp(buf + 1, &aligned[0], PAGE_SIZE), 0);
+    dm.ReadPage(1, buf + 1);
+    EXPECT_EQ(std::memcmp(buf + 1, &unaligned[PAGE_SIZE], PAGE_SIZE), 0);
+
+    // a run holding an unaligned buffer, and a batch mixing both kinds
+    dm.WritePages(2, {&aligned[2 * PAGE_SIZE], &unaligned[3 * PAGE_SIZE], &aligned[4 * PAGE_SIZE]});
+    std::vector<char> reads(num_pages * PAGE_SIZE + 1);
+    dm.SubmitPageIo({{true, 5, &aligned[5 * PAGE_SIZE]},
+                     {true, 6, &unaligned[6 * PAGE_SIZE]},
+                     {false, 3, &reads[1]},
+                     {false, 4, page}})
+        .wait();
+    EXPECT_EQ(std::memcmp(&reads[1], &unaligned[3 * PAGE_SIZE], PAGE_SIZE), 0);
+    EXPECT_EQ(std::memcmp(page, &aligned[4 * PAGE_SIZE], PAGE_SIZE), 0);
+    EXPECT_EQ(7 * PAGE_SIZE, dm.GetDbFileSize());
+    EXPECT_EQ(7, dm.GetNumWrites());
+
+    // a page past the end of the file reads as zeros
+    char zeros[PAGE_SIZE] = {0};
+    std::memset(buf, 'x', sizeof(buf));
+    dm.SubmitPageIo({{false, 2 * num_pages, buf + 1}}).wait();
+    EXPECT_EQ(std::memcmp(buf + 1, zeros, PAGE_SIZE), 0);
+    dm.ShutDown();
+
+    // the pages are there for a buffered disk manager on the same file
+    auto buffered_dm = DiskManager(db_file, io_mode);
+    EXPECT_FALSE(buffered_dm.HasDirectIo());
+    buffered_dm.ReadPage(6, buf);
+    EXPECT_EQ(std::memcmp(buf, &unaligned[6 * PAGE_SIZE], PAGE_SIZE), 0);
+    buffered_dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MetricsTest) {
+  std::string db_file("test.db");
+  for (DiskIoMode io_mode : {DiskIoMode::STREAM, DiskIoMode::POSITIONAL, DiskIoMode::IO_URING}) {
+    remove("test.db");
+    auto dm = DiskManager(db_file, io_mode);
+    std::vector<char> data(4 * PAGE_SIZE, 'a');
+    char buf[PAGE_SIZE];
+
+    // one latency per page write or vectored write, per page read, and per sync
+    dm.WritePage(0, data.data());
+    dm.WritePages(1, {&data[0], &data[PAGE_SIZE], &data[2 * PAGE_SIZE]});
+    dm.ReadPage(0, buf);
+    dm.SubmitPageIo({{false, 1, &data[0]}, {false, 2, &data[PAGE_SIZE]}}).wait();
+    dm.SyncPages();
+    const DiskMetrics metrics = dm.GetMetrics();
+    EXPECT_EQ(2U, metrics.writes_.count_);
+    EXPECT_EQ(3U, metrics.reads_.count_);
+    EXPECT_EQ(1U, metrics.syncs_.count_);
+    EXPECT_LT(0U, metrics.reads_.GetPercentileNs(1));
+    EXPECT_LE(metrics.reads_.GetPercentileNs(0.5), metrics.reads_.GetPercentileNs(1));
+    EXPECT_NE(std::string::npos, metrics.ToString().find("syncs: count=1"));
+    dm.ShutDown();
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -73,6 +338,9 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
+TEST_F(DiskManagerTest, ThrowBadFileTest) {
+  EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception);
+  EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db", DiskIoMode::POSITIONAL), Exception);
+}
 
 }  // namespace bustub
@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_heap_benchmark_test.cpp
+//
+// Identification: test/table/table_heap_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// The benchmarks are disabled in the unit tests, run them with --gtest_also_run_disabled_tests.
+
+namespace {
+
+/** Forwards to another buffer pool manager but ignores extents, which is how table heaps grew before them. */
+class PageAtATimeBufferPoolManager : public BufferPoolManager {
+ public:
+  explicit PageAtATimeBufferPoolManager(BufferPoolManager *bpm) : bpm_(bpm) {}
+  size_t GetPoolSize() override { return bpm_->GetPoolSize(); }
+
+ protected:
+  Page *FetchPgImp(page_id_t page_id, AccessType access_type) override { return bpm_->FetchPage(page_id, access_type); }
+  bool UnpinPgImp(page_id_t page_id, bool is_dirty) override { return bpm_->UnpinPage(page_id, is_dirty); }
+  bool FlushPgImp(page_id_t page_id) override { return bpm_->FlushPage(page_id); }
+  Page *NewPgImp(page_id_t *page_id) override { return bpm_->NewPage(page_id); }
+  bool DeletePgImp(page_id_t page_id) override { return bpm_->DeletePage(page_id); }
+  void FlushAllPgsImp() override { bpm_->FlushAllPages(); }
+
+ private:
+  BufferPoolManager *bpm_;
+};
+
+/** Evict a synced file from the OS page cache, so that the following scan reads the disk. */
+void DropFileCache(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+// Several tables grow at the same time, one tuple each in turn, then each of them is scanned cold. Growing a heap one
+// page at a time interleaves the tables page by page on disk; with extents every table is a few contiguous runs. A
+// "seek" is a step of the scan to a page that does not follow the previous one on disk.
+TEST(DISABLED_TableHeapBenchmarkTest, InterleavedInsertScanTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_tables = 4;
+  const int tuples_per_table = 4000;
+
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  Transaction transaction(0);
+  LockManager lock_manager;
+
+  std::cout << "layout  pages  seeks  scan(tuples/s)" << std::endl;
+  for (bool use_extents : {false, true}) {
+    remove(db_name.c_str());
+    remove("test.fsm");
+    std::vector<page_id_t> first_page_ids;
+    {
+      DiskManager disk_manager(db_name, DiskIoMode::POSITIONAL);
+      BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager);
+      PageAtATimeBufferPoolManager page_at_a_time(&bpm);
+      BufferPoolManager *heap_bpm = use_extents ? static_cast<BufferPoolManager *>(&bpm) : &page_at_a_time;
+      std::vector<std::unique_ptr<TableHeap>> tables;
+      for (int t = 0; t < num_tables; ++t) {
+        tables.emplace_back(std::make_unique<TableHeap>(heap_bpm, &lock_manager, nullptr, &transaction));
+        first_page_ids.push_back(tables.back()->GetFirstPageId());
+      }
+      for (int i = 0; i < tuples_per_table; ++i) {
+        for (auto &table : tables) {
+          std::vector<Value> values{ValueFactory::GetIntegerValue(i),
+                                    ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+          RID rid;
+          ASSERT_TRUE(table->InsertTuple(Tuple(values, &schema), &rid, &transaction));
+        }
+      }
+      bpm.FlushAllPages();
+      disk_manager.ShutDown();
+    }
+    DropFileCache(db_name);
+
+    DiskManager disk_manager(db_name, DiskIoMode::POSITIONAL);
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager);
+    size_t pages = 0;
+    size_t seeks = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (page_id_t first_page_id : first_page_ids) {
+      TableHeap table(&bpm, &lock_manager, nullptr, first_page_id);
+      int count = 0;
+      page_id_t last_page_id = INVALID_PAGE_ID;
+      for (auto iter = table.Begin(&transaction); iter != table.End(); ++iter) {
+        page_id_t page_id = iter->GetRid().GetPageId();
+        if (page_id != last_page_id) {
+          pages++;
+          seeks += last_page_id == INVALID_PAGE_ID || page_id != last_page_id + 1 ? 1 : 0;
+          last_page_id = page_id;
+        }
+        count++;
+      }
+      EXPECT_EQ(tuples_per_table, count);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << (use_extents ? "extents" : "page-at-a-time") << "  " << pages << "  " << seeks << "  "
+              << static_cast<uint64_t>(num_tables * tuples_per_table / elapsed.count()) << std::endl;
+    if (use_extents) {
+      // Only the jumps between extents are left.
+      EXPECT_LE(seeks, num_tables * (pages / num_tables / EXTENT_SIZE + 1));
+    } else {
+      EXPECT_EQ(pages, seeks);
+    }
+    disk_manager.ShutDown();
+  }
+
+  remove(db_name.c_str());
+  remove("test.fsm");
+}
+
+}  // namespace bustub
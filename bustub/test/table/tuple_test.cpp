@@ -21,6 +21,7 @@
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -71,4 +72,52 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// A cold scan of a table much larger than the buffer pool reads the page chain ahead and still sees every tuple.
+TEST(TupleTest, TableHeapReadAheadTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const int num_tuples = 2000;
+  const size_t buffer_pool_size = 32;
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  const page_id_t first_page_id = table->GetFirstPageId();
+  for (int i = 0; i < num_tuples; ++i) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(Tuple(values, &schema), &rid, transaction));
+  }
+  buffer_pool_manager->FlushAllPages();
+  delete table;
+  delete buffer_pool_manager;
+
+  // Scan the table through a fresh, empty buffer pool.
+  auto *cold_buffer_pool_manager = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  table = new TableHeap(cold_buffer_pool_manager, lock_manager, log_manager, first_page_id);
+  int expected = 0;
+  for (auto iter = table->Begin(transaction); iter != table->End(); ++iter) {
+    ASSERT_EQ(expected, iter->GetValue(&schema, 0).GetAs<int32_t>());
+    expected++;
+  }
+  EXPECT_EQ(num_tuples, expected);
+  EXPECT_GT(cold_buffer_pool_manager->GetPrefetchedPages(), 0U);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete cold_buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub